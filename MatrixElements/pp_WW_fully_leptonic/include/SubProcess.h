@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <functional>
 #include <vector> 
 #include <utility>
 
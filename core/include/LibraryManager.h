@@ -20,6 +20,8 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #include <SharedLibrary.h>
@@ -29,6 +31,17 @@ class LibraryManager {
         static LibraryManager& get();
 
         void registerLibrary(const std::string& path);
+
+        /**
+         * \brief Load the plugin holding the ROOT-dependent parts of MoMEMta
+         *
+         * Only useful when MoMEMta is built with the `ROOT_FREE_CORE` option. The plugin is first looked for next
+         * to the MoMEMta library, then using the search path of the dynamic linker. Loading it several times is a
+         * no-op.
+         *
+         * \return True if the plugin is loaded
+         */
+        bool loadROOTPlugin();
     
     private:
         LibraryManager() = default;
@@ -36,4 +49,6 @@ class LibraryManager {
         const LibraryManager& operator=(const LibraryManager&) = delete;
 
         std::vector<std::shared_ptr<SharedLibrary>> m_libraries;
+        std::shared_ptr<SharedLibrary> m_root_plugin;
+        std::mutex m_root_plugin_mutex;
 };
@@ -0,0 +1,123 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <momemta/Histogram.h>
+
+/**
+ * \brief Lock-free accumulator for a set of histograms, shared between threads and processes
+ *
+ * The histograms are stored in memory shared by all the processes forked after the accumulator creation (like the
+ * workers started by Cuba), split in shards: each process fills its own shard, claimed the first time it calls fill(),
+ * so that processes do not compete for the same memory. Bins are updated using atomic operations, so that filling
+ * stays correct if several threads or processes end up using the same shard (when there are more processes than
+ * shards, or when several threads fill the same accumulator). Shards are only summed when the histograms are
+ * requested, using merge().
+ *
+ * All the histograms share the same uniform binning.
+ */
+class ShardedHistogram {
+    public:
+        /**
+         * \brief Create an empty accumulator
+         *
+         * \param n_histograms Number of histograms
+         * \param n_bins, min, max Binning of the histograms
+         * \param n_shards Number of shards. Processes beyond this number share the existing shards.
+         */
+        ShardedHistogram(size_t n_histograms, size_t n_bins, double min, double max, size_t n_shards = 64);
+        ~ShardedHistogram();
+
+        ShardedHistogram(const ShardedHistogram&) = delete;
+        ShardedHistogram& operator=(const ShardedHistogram&) = delete;
+
+        /// Fill histogram \p histogram with value \p x and weight \p weight
+        void fill(size_t histogram, double x, double weight) {
+            std::atomic<double>* bins = shard() + histogram * m_histogram_size;
+            const size_t bin = m_axis.findBin(x);
+
+            add(bins[2 * bin], weight);
+            add(bins[2 * bin + 1], weight * weight);
+            add(bins[m_histogram_size - 1], 1.);
+        }
+
+        /**
+         * \brief Move the content of the shard of the calling process from \p other into this accumulator
+         *
+         * Both accumulators must have the same layout. The shards of the other processes are left untouched.
+         */
+        void absorb(ShardedHistogram& other);
+
+        /**
+         * \brief Empty all the shards, and release them
+         *
+         * \warning Must not be called while other processes are filling the accumulator.
+         */
+        void reset();
+
+        /// \return Histogram \p histogram, sum of all the shards
+        momemta::Histogram merge(size_t histogram) const;
+
+        size_t size() const {
+            return m_n_histograms;
+        }
+
+    private:
+        /// \return The first bin of the shard of the calling process
+        std::atomic<double>* shard() {
+            const pid_t pid = getpid();
+            if (pid != m_shard_pid)
+                claim(pid);
+
+            return m_shard;
+        }
+
+        void claim(pid_t pid);
+
+        static void add(std::atomic<double>& target, double value) {
+            // Shards usually have a single writer: the exchange almost never fails
+            double current = target.load(std::memory_order_relaxed);
+            while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed));
+        }
+
+        momemta::BinnedTable2D::Axis m_axis;
+        size_t m_n_histograms;
+        size_t m_n_shards;
+        size_t m_histogram_size; ///< Number of doubles per histogram: sum of weights and of squared weights per bin, then number of entries
+        size_t m_shard_size; ///< Number of doubles per shard, padded to a multiple of a cache line
+
+        /// Shared memory: the owner of each shard, followed by the shards
+        void* m_memory = nullptr;
+        size_t m_memory_size;
+        std::atomic<pid_t>* m_owners;
+        std::atomic<double>* m_shards;
+
+        // Shard used by this process (the values are copied to the child processes, and updated there)
+        pid_t m_shard_pid = 0;
+        std::atomic<double>* m_shard = nullptr;
+};
@@ -30,6 +30,10 @@ struct SharedLibrary {
         SharedLibrary(const SharedLibrary&) = delete;
         SharedLibrary& operator=(const SharedLibrary&) = delete;
 
+        bool isLoaded() const {
+            return m_handle != nullptr;
+        }
+
     private:
         void* m_handle = nullptr;
 };
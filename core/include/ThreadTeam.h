@@ -0,0 +1,77 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief A fixed team of threads running the same job
+ *
+ * The threads are started when the team is created, and wait for jobs. run() executes a job on all the lanes of the
+ * team at once, the calling thread taking part as lane 0, and returns once all the lanes are done. Compared to
+ * starting new threads for each job, this avoids the cost of creating threads, which matters when jobs are short
+ * (for instance the evaluation of the solutions of a block for a single phase-space point).
+ *
+ * \warning Threads are not inherited by child processes. A team created before a `fork` must not be used in the child.
+ */
+class ThreadTeam {
+    public:
+        using Job = std::function<void(size_t)>;
+
+        /// Start a team of \p size lanes (\p size - 1 threads)
+        explicit ThreadTeam(size_t size);
+        ~ThreadTeam();
+
+        ThreadTeam(const ThreadTeam&) = delete;
+        ThreadTeam& operator=(const ThreadTeam&) = delete;
+
+        /**
+         * \brief Run \p job on all the lanes, and wait for completion
+         *
+         * The job is called with the lane index, between 0 and size() - 1. If the job throws on any lane,
+         * the first exception is rethrown once all the lanes are done.
+         */
+        void run(const Job& job);
+
+        size_t size() const {
+            return m_threads.size() + 1;
+        }
+
+    private:
+        void loop(size_t lane);
+        void execute(const Job& job, size_t lane);
+
+        std::vector<std::thread> m_threads;
+
+        std::mutex m_mutex;
+        std::condition_variable m_start;
+        std::condition_variable m_done;
+
+        const Job* m_job = nullptr;
+        size_t m_generation = 0; ///< Incremented for each job
+        size_t m_pending = 0; ///< Number of threads still running the current job
+        bool m_stop = false;
+        std::exception_ptr m_exception;
+};
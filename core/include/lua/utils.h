@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <tuple>
 #include <vector>
 
@@ -71,6 +72,7 @@ namespace lua {
      */
     struct LazyFunction: public Lazy {
         int ref_index; ///< The reference index where the anonymous function is stored.
+        std::string parameter; ///< Name of the global parameter returned by the function, if created by `parameter()`
 
         /**
          * \brief Evaluate the anonymous function
@@ -179,6 +181,7 @@ namespace lua {
      *
      *  Available functions:
      *      - @link load_modules @endlink
+     *      - @link load_root_plugin @endlink
      *      - @link parameter @endlink
      */
     void setup_hooks(lua_State* L, void* ptr);
@@ -227,6 +230,17 @@ namespace lua {
      */
     int load_modules(lua_State* L);
 
+    /*!
+     * \brief Hook for the `load_root_plugin` lua function. The stack must be empty.
+     *
+     * When MoMEMta is built with the `ROOT_FREE_CORE` option, load the plugin holding the modules depending on ROOT,
+     * and declare a new global variable for each of them. Otherwise, these modules are part of the core library
+     * and nothing is done, so that configurations calling this function work with both builds.
+     *
+     * \return always 0
+     */
+    int load_root_plugin(lua_State* L);
+
     /*!
      * \brief Hook for the `parameter` lua function. This function accepts one argument:
      *   1. (string) The name of the parameter
@@ -0,0 +1,111 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <momemta/Arena.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace {
+constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+}
+
+namespace momemta {
+
+Arena::Arena(size_t block_size, bool huge_pages):
+    m_block_size(std::max<size_t>(block_size, 1024)), m_huge_pages(huge_pages) {
+    // Empty
+}
+
+Arena::~Arena() {
+    for (const auto& block: m_blocks) {
+        if (block.mapped)
+            munmap(block.data, block.size);
+        else
+            std::free(block.data);
+    }
+}
+
+void Arena::reset() {
+    m_peak = peakUsage();
+
+    m_current = 0;
+    m_offset = 0;
+    m_used = 0;
+}
+
+size_t Arena::peakUsage() const {
+    return std::max(m_peak, m_used);
+}
+
+size_t Arena::capacity() const {
+    size_t capacity = 0;
+    for (const auto& block: m_blocks)
+        capacity += block.size;
+
+    return capacity;
+}
+
+void* Arena::allocateSlow(size_t size, size_t alignment) {
+    // Move to the next block large enough, allocating a new one if needed
+    m_current = (m_current < m_blocks.size()) ? m_current + 1 : m_blocks.size();
+    while (m_current < m_blocks.size() && size + alignment > m_blocks[m_current].size)
+        m_current++;
+
+    if (m_current == m_blocks.size())
+        m_blocks.push_back(newBlock(std::max(m_block_size, size + alignment)));
+
+    m_offset = 0;
+    return allocate(size, alignment);
+}
+
+Arena::Block Arena::newBlock(size_t size) {
+    if (m_huge_pages) {
+        size = ((size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+
+        void* data = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+        if (data == MAP_FAILED) {
+            // No explicit huge pages available: ask for transparent huge pages
+            data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+            if (data != MAP_FAILED)
+                madvise(data, size, MADV_HUGEPAGE);
+#endif
+        }
+
+        if (data == MAP_FAILED)
+            throw std::bad_alloc();
+
+        return {static_cast<char*>(data), size, true};
+    }
+
+    void* data = std::malloc(size);
+    if (!data)
+        throw std::bad_alloc();
+
+    return {static_cast<char*>(data), size, false};
+}
+
+}
@@ -0,0 +1,368 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <momemta/BinnedTable2D.h>
+
+#include <momemta/Logging.h>
+#include <momemta/config.h>
+
+#include <LibraryManager.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace momemta {
+
+BinnedTable2D::Axis::Axis(size_t n_bins, double min, double max):
+    m_n_bins(n_bins), m_min(min), m_max(max), m_uniform(true) {
+
+    if (n_bins == 0 || !(min < max))
+        throw std::invalid_argument("Invalid uniform binning");
+
+    m_width = (max - min) / n_bins;
+}
+
+BinnedTable2D::Axis::Axis(const std::vector<double>& edges):
+    m_uniform(false), m_width(0), m_edges(edges) {
+
+    if (edges.size() < 2 || !std::is_sorted(edges.begin(), edges.end()))
+        throw std::invalid_argument("Invalid variable binning: at least two edges, in increasing order, are needed");
+
+    m_n_bins = edges.size() - 1;
+    m_min = edges.front();
+    m_max = edges.back();
+}
+
+BinnedTable2D::BinnedTable2D(const Axis& x, const Axis& y, const std::vector<double>& contents):
+    m_x(x), m_y(y), m_stride(x.nBins() + 2) {
+
+    if (contents.size() != size())
+        throw std::invalid_argument("Number of bin contents is not consistent with the binning");
+
+    auto storage = std::make_shared<const std::vector<double>>(contents);
+    m_contents = storage->data();
+    m_storage = storage;
+}
+
+BinnedTable2D::BinnedTable2D(const Axis& x, const Axis& y, const double* contents, std::shared_ptr<const void> storage):
+    m_x(x), m_y(y), m_stride(x.nBins() + 2), m_storage(storage), m_contents(contents) {
+    // Empty
+}
+
+void BinnedTable2D::evaluate(const double* x, const double* y, double* out, size_t n) const {
+    for (size_t i = 0; i < n; i++)
+        out[i] = m_contents[findBin(x[i], y[i])];
+}
+
+namespace {
+const char MAGIC[8] = {'M', 'o', 'M', 'E', 'M', 'T', 'F', '\0'};
+const uint32_t VERSION = 1;
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const size_t MAX_NAME_LENGTH = 64;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t n_tables;
+};
+
+struct TableHeader {
+    char name[MAX_NAME_LENGTH];
+    uint64_t n_bins[2];
+    uint64_t variable[2];
+    double min[2];
+    double max[2];
+    uint64_t offset;
+};
+
+/// Read-only memory mapping of a whole file
+class MappedFile {
+public:
+    MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw BinnedTable2D::file_not_found_error("Could not open file " + path);
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw BinnedTable2D::file_not_found_error("Could not stat file " + path);
+        }
+
+        m_size = st.st_size;
+        void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        // The mapping stays valid after the file descriptor is closed
+        ::close(fd);
+
+        if (data == MAP_FAILED)
+            throw BinnedTable2D::invalid_file_error("Could not map file " + path + " in memory");
+
+        m_data = static_cast<const char*>(data);
+    }
+
+    ~MappedFile() {
+        ::munmap(const_cast<char*>(m_data), m_size);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_data;
+    size_t m_size;
+};
+
+std::mutex cache_mutex;
+std::map<std::string, std::weak_ptr<const MappedFile>> mapped_files_cache;
+std::map<std::pair<std::string, std::string>, std::weak_ptr<const BinnedTable2D>> tables_cache;
+
+std::mutex loader_mutex;
+BinnedTable2D::Loader fallback_loader;
+
+std::string canonicalPath(const std::string& path) {
+    char* resolved = ::realpath(path.c_str(), nullptr);
+    if (!resolved)
+        return path;
+
+    std::string result(resolved);
+    std::free(resolved);
+
+    return result;
+}
+
+bool isNativeFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    if (!file.read(magic, sizeof(magic)))
+        return false;
+
+    return std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+BinnedTable2D::Loader fallbackLoader() {
+    {
+        std::lock_guard<std::mutex> lock(loader_mutex);
+        if (fallback_loader)
+            return fallback_loader;
+    }
+
+#ifdef ROOT_FREE_CORE
+    // Loading the plugin registers its loader
+    LibraryManager::get().loadROOTPlugin();
+#endif
+
+    std::lock_guard<std::mutex> lock(loader_mutex);
+    return fallback_loader;
+}
+}
+
+std::shared_ptr<const BinnedTable2D> BinnedTable2D::load(const std::string& path, const std::string& name) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    auto key = std::make_pair(canonicalPath(path), name);
+    if (auto table = tables_cache[key].lock())
+        return table;
+
+    std::shared_ptr<const BinnedTable2D> table;
+    if (isNativeFile(path)) {
+        table = loadNative(key.first, name);
+    } else {
+        auto loader = fallbackLoader();
+        if (!loader)
+            throw invalid_file_error("File " + path + " is not in the native format, and ROOT support is not available."
+                                     " Convert it first using momemta-convert-tf.");
+
+        table = loader(path, name);
+    }
+    tables_cache[key] = table;
+
+    return table;
+}
+
+void BinnedTable2D::setFallbackLoader(const Loader& loader) {
+    std::lock_guard<std::mutex> lock(loader_mutex);
+    fallback_loader = loader;
+}
+
+std::shared_ptr<const BinnedTable2D> BinnedTable2D::loadNative(const std::string& path, const std::string& name) {
+    auto mapping = mapped_files_cache[path].lock();
+    if (!mapping) {
+        mapping = std::make_shared<const MappedFile>(path);
+        mapped_files_cache[path] = mapping;
+    }
+
+    const char* data = mapping->data();
+    const size_t size = mapping->size();
+
+    if (size < sizeof(FileHeader))
+        throw invalid_file_error("File " + path + " is truncated");
+
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(data);
+    if (header->version != VERSION || header->byte_order != BYTE_ORDER_MARK)
+        throw invalid_file_error("File " + path + " was written with an incompatible version or on an incompatible platform");
+
+    if (header->n_tables > (size - sizeof(FileHeader)) / sizeof(TableHeader))
+        throw invalid_file_error("File " + path + " is truncated");
+
+    const TableHeader* tables = reinterpret_cast<const TableHeader*>(data + sizeof(FileHeader));
+    for (size_t i = 0; i < header->n_tables; i++) {
+        const TableHeader& table = tables[i];
+        if (std::strncmp(table.name, name.c_str(), MAX_NAME_LENGTH) != 0)
+            continue;
+
+        const auto corrupted = invalid_file_error("Table " + name + " in file " + path + " is corrupted");
+
+        // Sizes are checked against the file size before any arithmetic, so that nothing can overflow
+        if (table.offset % sizeof(double) != 0 || table.offset > size)
+            throw corrupted;
+
+        const uint64_t max_values = (size - table.offset) / sizeof(double);
+        if (table.n_bins[0] == 0 || table.n_bins[1] == 0 || table.n_bins[0] > max_values ||
+                table.n_bins[1] > max_values || (table.n_bins[0] + 2) > max_values / (table.n_bins[1] + 2))
+            throw corrupted;
+
+        size_t n_edges[2];
+        for (size_t axis = 0; axis < 2; axis++)
+            n_edges[axis] = table.variable[axis] ? table.n_bins[axis] + 1 : 0;
+
+        if (n_edges[0] + n_edges[1] + (table.n_bins[0] + 2) * (table.n_bins[1] + 2) > max_values)
+            throw corrupted;
+
+        const double* values = reinterpret_cast<const double*>(data + table.offset);
+        auto axis = [&table, &values, &n_edges](size_t index) {
+            if (!table.variable[index])
+                return Axis(table.n_bins[index], table.min[index], table.max[index]);
+
+            std::vector<double> edges(values, values + n_edges[index]);
+            values += n_edges[index];
+
+            return Axis(edges);
+        };
+
+        std::unique_ptr<Axis> x, y;
+        try {
+            x.reset(new Axis(axis(0)));
+            y.reset(new Axis(axis(1)));
+        } catch (const std::invalid_argument&) {
+            throw corrupted;
+        }
+
+        LOG(debug) << "Mapped table " << name << " from file " << path << ".";
+
+        return std::shared_ptr<const BinnedTable2D>(new BinnedTable2D(*x, *y, values, mapping));
+    }
+
+    throw table_not_found_error("Could not find table " + name + " in file " + path + ".");
+}
+
+void BinnedTable2D::save(const std::string& path, const std::vector<std::pair<std::string, const BinnedTable2D*>>& tables) {
+    FileHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.n_tables = tables.size();
+
+    std::vector<TableHeader> headers(tables.size());
+    std::vector<double> data;
+
+    uint64_t offset = sizeof(FileHeader) + tables.size() * sizeof(TableHeader);
+    for (size_t i = 0; i < tables.size(); i++) {
+        const std::string& name = tables[i].first;
+        const BinnedTable2D& table = *tables[i].second;
+
+        if (name.size() >= MAX_NAME_LENGTH)
+            throw std::invalid_argument("Table name " + name + " is too long");
+
+        TableHeader& table_header = headers[i];
+        std::memset(&table_header, 0, sizeof(TableHeader));
+        std::strncpy(table_header.name, name.c_str(), MAX_NAME_LENGTH - 1);
+        table_header.offset = offset + data.size() * sizeof(double);
+
+        const Axis* axes[2] = {&table.xAxis(), &table.yAxis()};
+        for (size_t axis = 0; axis < 2; axis++) {
+            table_header.n_bins[axis] = axes[axis]->nBins();
+            table_header.variable[axis] = !axes[axis]->isUniform();
+            table_header.min[axis] = axes[axis]->min();
+            table_header.max[axis] = axes[axis]->max();
+        }
+
+        for (size_t axis = 0; axis < 2; axis++) {
+            if (axes[axis]->isUniform())
+                continue;
+
+            for (size_t bin = 1; bin <= axes[axis]->nBins() + 1; bin++)
+                data.push_back(axes[axis]->lowEdge(bin));
+        }
+
+        data.insert(data.end(), table.m_contents, table.m_contents + table.size());
+    }
+
+    // The table is written to a temporary file, then renamed: processes having the previous version of the file
+    // mapped in memory keep reading it unchanged, instead of seeing it truncated under their feet
+    static std::atomic<unsigned int> counter(0);
+    const std::string temporary = path + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(counter++);
+
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (fd < 0)
+        throw file_not_found_error("Could not open file " + temporary + " for writing");
+
+    auto write = [fd](const void* buffer, size_t size) {
+        const char* begin = static_cast<const char*>(buffer);
+        while (size > 0) {
+            ssize_t written = ::write(fd, begin, size);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+
+            begin += written;
+            size -= written;
+        }
+
+        return true;
+    };
+
+    bool success = write(&header, sizeof(FileHeader)) &&
+                   write(headers.data(), headers.size() * sizeof(TableHeader)) &&
+                   write(data.data(), data.size() * sizeof(double));
+    success = (::close(fd) == 0) && success;
+
+    if (!success || ::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        throw invalid_file_error("Error while writing file " + path);
+    }
+}
+
+}
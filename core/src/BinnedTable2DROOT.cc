@@ -0,0 +1,92 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file
+ * \brief ROOT support of BinnedTable2D: reading TH2s from ROOT files
+ *
+ * Part of the ROOT plugin when MoMEMta is built with the `ROOT_FREE_CORE` option.
+ */
+
+#include <momemta/BinnedTable2D.h>
+
+#include <momemta/Logging.h>
+
+#include <TAxis.h>
+#include <TFile.h>
+#include <TH2.h>
+
+namespace momemta {
+
+namespace {
+BinnedTable2D::Axis toAxis(const TAxis& axis) {
+    if (axis.IsVariableBinSize()) {
+        const double* edges = axis.GetXbins()->GetArray();
+        return BinnedTable2D::Axis(std::vector<double>(edges, edges + axis.GetNbins() + 1));
+    }
+
+    return BinnedTable2D::Axis(axis.GetNbins(), axis.GetXmin(), axis.GetXmax());
+}
+
+std::shared_ptr<const BinnedTable2D> loadROOT(const std::string& path, const std::string& name) {
+    std::unique_ptr<TFile> file(TFile::Open(path.c_str()));
+    if (!file || !file->IsOpen() || file->IsZombie())
+        throw BinnedTable2D::file_not_found_error("Could not open file " + path);
+
+    std::unique_ptr<TObject> object(file->Get(name.c_str()));
+    if (!object || !object->InheritsFrom("TH2"))
+        throw BinnedTable2D::table_not_found_error("Could not retrieve object " + name +
+                                                   " deriving from class TH2 in file " + path + ".");
+
+    std::unique_ptr<TH2> th2(static_cast<TH2*>(object.release()));
+    th2->SetDirectory(0);
+
+    file->Close();
+
+    LOG(debug) << "Loaded TH2 " << name << " from file " << path << ".";
+
+    return std::make_shared<const BinnedTable2D>(toBinnedTable(*th2));
+}
+
+struct RegisterROOTLoader {
+    RegisterROOTLoader() {
+        BinnedTable2D::setFallbackLoader(loadROOT);
+    }
+
+    // The plugin may be unloaded before the core library
+    ~RegisterROOTLoader() {
+        BinnedTable2D::setFallbackLoader(nullptr);
+    }
+};
+
+RegisterROOTLoader register_root_loader;
+}
+
+BinnedTable2D toBinnedTable(const TH2& th2) {
+    BinnedTable2D::Axis x = toAxis(*th2.GetXaxis());
+    BinnedTable2D::Axis y = toAxis(*th2.GetYaxis());
+
+    std::vector<double> contents((x.nBins() + 2) * (y.nBins() + 2));
+    for (size_t bin = 0; bin < contents.size(); bin++)
+        contents[bin] = th2.GetBinContent(bin);
+
+    return BinnedTable2D(x, y, contents);
+}
+
+}
@@ -0,0 +1,92 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <momemta/BinnedTableSampler.h>
+
+#include <algorithm>
+
+namespace momemta {
+
+BinnedTableSampler::BinnedTableSampler(std::shared_ptr<const BinnedTable2D> table): m_table(table) {
+    const auto& x = m_table->xAxis();
+    const auto& y = m_table->yAxis();
+
+    m_density.resize(x.nBins() * y.nBins());
+    m_cumulative.resize(x.nBins() * (y.nBins() + 1));
+
+    for (size_t i = 1; i <= x.nBins(); i++) {
+        double* density = &m_density[(i - 1) * y.nBins()];
+        double* cumulative = &m_cumulative[(i - 1) * (y.nBins() + 1)];
+
+        cumulative[0] = 0;
+        for (size_t j = 1; j <= y.nBins(); j++) {
+            const double content = m_table->binContent(m_table->findBin(x.binCenter(i), y.binCenter(j)));
+            density[j - 1] = std::max(content, 0.);
+            cumulative[j] = cumulative[j - 1] + density[j - 1] * (y.upEdge(j) - y.lowEdge(j));
+        }
+    }
+}
+
+double BinnedTableSampler::cumulative(size_t column, double y) const {
+    const auto& axis = m_table->yAxis();
+    const size_t bin = yBin(y);
+    const double clamped = std::min(std::max(y, axis.lowEdge(bin)), axis.upEdge(bin));
+
+    return m_cumulative[(column - 1) * (axis.nBins() + 1) + bin - 1] +
+           m_density[(column - 1) * axis.nBins() + bin - 1] * (clamped - axis.lowEdge(bin));
+}
+
+double BinnedTableSampler::sample(size_t column, double y_min, double y_max, double uniform_fraction, double u,
+                                  double& density) const {
+    const auto& axis = m_table->yAxis();
+    const double* column_density = &m_density[(column - 1) * axis.nBins()];
+
+    const double c_min = cumulative(column, y_min);
+    const double weight = cumulative(column, y_max) - c_min;
+    const double range = y_max - y_min;
+
+    // Coefficients of the mixture: F(y) = table_coef * (C(y) - C(y_min)) + uniform_coef * (y - y_min)
+    const double table_coef = (weight > 0) ? (1 - uniform_fraction) / weight : 0;
+    const double uniform_coef = (weight > 0) ? uniform_fraction / range : 1. / range;
+
+    auto F = [&](double y) {
+        return table_coef * (cumulative(column, y) - c_min) + uniform_coef * (y - y_min);
+    };
+
+    // Find the last bin whose lower edge (clipped to the range) is mapped below u
+    size_t first = yBin(y_min);
+    size_t last = yBin(y_max);
+    while (first < last) {
+        const size_t middle = (first + last + 1) / 2;
+        if (F(axis.lowEdge(middle)) <= u)
+            first = middle;
+        else
+            last = middle - 1;
+    }
+
+    const double low = std::max(axis.lowEdge(first), y_min);
+    const double high = std::min(axis.upEdge(first), y_max);
+
+    density = table_coef * column_density[first - 1] + uniform_coef;
+    if (!(density > 0))
+        return low;
+
+    return std::min(std::max(low + (u - F(low)) / density, low), high);
+}
+
+}
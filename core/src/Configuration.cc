@@ -17,9 +17,20 @@
  */
 
 #include <momemta/Configuration.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
 #include <momemta/ConfigurationReader.h>
+#include <momemta/Logging.h>
 #include <momemta/Path.h>
 #include <momemta/ParameterSet.h>
+#include <momemta/config.h>
+
+#include <LibraryManager.h>
 
 Configuration::Module::Module(const Configuration::Module& other) {
     name = other.name;
@@ -51,8 +62,10 @@ Configuration::Configuration(const Configuration& other) {
         cuba_configuration.reset(other.cuba_configuration->clone());
     integrands = other.integrands;
     paths = other.paths;
+    owned_paths = other.owned_paths;
     n_dimensions = other.n_dimensions;
     inputs = other.inputs;
+    libraries = other.libraries;
 }
 
 Configuration::Configuration(const Configuration&& other) {
@@ -61,8 +74,10 @@ Configuration::Configuration(const Configuration&& other) {
     cuba_configuration = std::move(other.cuba_configuration);
     integrands = std::move(other.integrands);
     paths = std::move(other.paths);
+    owned_paths = std::move(other.owned_paths);
     n_dimensions = other.n_dimensions;
     inputs = std::move(other.inputs);
+    libraries = std::move(other.libraries);
 }
 
 Configuration& Configuration::operator=(Configuration other) {
@@ -111,3 +126,353 @@ Configuration Configuration::freeze() const {
 
     return c;
 }
+
+namespace {
+const char MAGIC[8] = {'M', 'o', 'M', 'E', 'M', 'C', 'F', '\0'};
+const uint32_t VERSION = 2;
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+/// Type of a value stored in a ParameterSet. Vectors have the VECTOR bit set.
+enum ValueType: uint8_t {
+    INTEGER = 0,
+    REAL,
+    BOOLEAN,
+    STRING,
+    INPUT_TAG,
+    PARAMETER_SET,
+    PATH,
+
+    VECTOR = 0x80
+};
+
+template <typename T>
+void write(std::ostream& stream, const T& value) {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void write(std::ostream& stream, const std::string& value) {
+    write<uint64_t>(stream, value.size());
+    stream.write(value.data(), value.size());
+}
+
+void write(std::ostream& stream, const InputTag& value) {
+    write(stream, value.toString());
+}
+
+void write(std::ostream& stream, const std::vector<std::string>& values) {
+    write<uint64_t>(stream, values.size());
+    for (const auto& value: values)
+        write(stream, value);
+}
+
+template <typename T>
+T read(std::istream& stream) {
+    T value;
+    if (!stream.read(reinterpret_cast<char*>(&value), sizeof(T)))
+        throw Configuration::invalid_file_error("Unexpected end of file");
+
+    return value;
+}
+
+template <>
+std::string read<std::string>(std::istream& stream) {
+    std::string value(read<uint64_t>(stream), '\0');
+    if (!stream.read(&value[0], value.size()))
+        throw Configuration::invalid_file_error("Unexpected end of file");
+
+    return value;
+}
+
+template <>
+InputTag read<InputTag>(std::istream& stream) {
+    std::string tag = read<std::string>(stream);
+    if (tag.empty())
+        return InputTag();
+
+    return InputTag::fromString(tag);
+}
+
+template <>
+std::vector<std::string> read<std::vector<std::string>>(std::istream& stream) {
+    std::vector<std::string> values(read<uint64_t>(stream));
+    for (auto& value: values)
+        value = read<std::string>(stream);
+
+    return values;
+}
+
+/// Write the elements of \p values, using \p write_element for each of them
+template <typename T, typename F>
+void writeVector(std::ostream& stream, const momemta::any& value, F write_element) {
+    const auto& values = momemta::any_cast<const std::vector<T>&>(value);
+    write<uint64_t>(stream, values.size());
+    for (const auto& v: values)
+        write_element(v);
+}
+
+template <typename T, typename F>
+std::vector<T> readVector(std::istream& stream, F read_element) {
+    std::vector<T> values;
+    values.resize(read<uint64_t>(stream));
+    for (size_t i = 0; i < values.size(); i++)
+        values[i] = read_element();
+
+    return values;
+}
+}
+
+void Configuration::saveParameterSet(std::ostream& stream, const ParameterSet& set,
+                                     const std::vector<PathElements*>& paths) {
+
+    auto writeSet = [&stream, &paths](const ParameterSet& s) { saveParameterSet(stream, s, paths); };
+    auto writePath = [&stream, &paths](const Path& path) {
+        auto it = std::find(paths.begin(), paths.end(), path.elements_);
+        if (it == paths.end())
+            throw invalid_file_error("Cannot save a Path which is not declared in the configuration");
+
+        write<uint64_t>(stream, it - paths.begin());
+    };
+
+    // Global parameters are attached again to each module when loading
+    size_t size = set.m_set.size() - set.m_set.count("@global_parameters");
+    write<uint64_t>(stream, size);
+
+    for (const auto& p: set.m_set) {
+        if (p.first == "@global_parameters")
+            continue;
+
+        const momemta::any& value = p.second.value;
+        const std::type_info& type = value.type();
+
+        write(stream, p.first);
+
+        if (type == typeid(int64_t)) {
+            write<uint8_t>(stream, INTEGER);
+            write(stream, momemta::any_cast<int64_t>(value));
+        } else if (type == typeid(double)) {
+            write<uint8_t>(stream, REAL);
+            write(stream, momemta::any_cast<double>(value));
+        } else if (type == typeid(bool)) {
+            write<uint8_t>(stream, BOOLEAN);
+            write<uint8_t>(stream, momemta::any_cast<bool>(value));
+        } else if (type == typeid(std::string)) {
+            write<uint8_t>(stream, STRING);
+            write(stream, momemta::any_cast<const std::string&>(value));
+        } else if (type == typeid(InputTag)) {
+            write<uint8_t>(stream, INPUT_TAG);
+            write(stream, momemta::any_cast<const InputTag&>(value));
+        } else if (type == typeid(ParameterSet)) {
+            write<uint8_t>(stream, PARAMETER_SET);
+            writeSet(momemta::any_cast<const ParameterSet&>(value));
+        } else if (type == typeid(Path)) {
+            write<uint8_t>(stream, PATH);
+            writePath(momemta::any_cast<const Path&>(value));
+        } else if (type == typeid(std::vector<int64_t>)) {
+            write<uint8_t>(stream, VECTOR | INTEGER);
+            writeVector<int64_t>(stream, value, [&stream](int64_t v) { write(stream, v); });
+        } else if (type == typeid(std::vector<double>)) {
+            write<uint8_t>(stream, VECTOR | REAL);
+            writeVector<double>(stream, value, [&stream](double v) { write(stream, v); });
+        } else if (type == typeid(std::vector<bool>)) {
+            write<uint8_t>(stream, VECTOR | BOOLEAN);
+            writeVector<bool>(stream, value, [&stream](bool v) { write<uint8_t>(stream, v); });
+        } else if (type == typeid(std::vector<std::string>)) {
+            write<uint8_t>(stream, VECTOR | STRING);
+            writeVector<std::string>(stream, value, [&stream](const std::string& v) { write(stream, v); });
+        } else if (type == typeid(std::vector<InputTag>)) {
+            write<uint8_t>(stream, VECTOR | INPUT_TAG);
+            writeVector<InputTag>(stream, value, [&stream](const InputTag& v) { write(stream, v); });
+        } else if (type == typeid(std::vector<ParameterSet>)) {
+            write<uint8_t>(stream, VECTOR | PARAMETER_SET);
+            writeVector<ParameterSet>(stream, value, writeSet);
+        } else {
+            throw invalid_file_error("Cannot save parameter '" + p.first + "' of type " + demangle(type.name()));
+        }
+    }
+
+    write<uint64_t>(stream, set.m_references.size());
+    for (const auto& reference: set.m_references) {
+        write(stream, reference.first);
+        write(stream, reference.second);
+    }
+}
+
+void Configuration::loadParameterSet(std::istream& stream, ParameterSet& set,
+                                     const std::vector<PathElements*>& paths) {
+
+    auto readSet = [&stream, &paths]() {
+        ParameterSet s;
+        loadParameterSet(stream, s, paths);
+        return s;
+    };
+    auto readPath = [&stream, &paths]() {
+        uint64_t index = read<uint64_t>(stream);
+        if (index >= paths.size())
+            throw invalid_file_error("Invalid path index");
+
+        return Path(paths[index]);
+    };
+
+    uint64_t size = read<uint64_t>(stream);
+    for (uint64_t i = 0; i < size; i++) {
+        std::string name = read<std::string>(stream);
+        uint8_t type = read<uint8_t>(stream);
+
+        momemta::any value;
+        switch (type) {
+            case INTEGER:
+                value = read<int64_t>(stream);
+                break;
+            case REAL:
+                value = read<double>(stream);
+                break;
+            case BOOLEAN:
+                value = static_cast<bool>(read<uint8_t>(stream));
+                break;
+            case STRING:
+                value = read<std::string>(stream);
+                break;
+            case INPUT_TAG:
+                value = read<InputTag>(stream);
+                break;
+            case PARAMETER_SET:
+                value = readSet();
+                break;
+            case PATH:
+                value = readPath();
+                break;
+            case VECTOR | INTEGER:
+                value = readVector<int64_t>(stream, [&stream]() { return read<int64_t>(stream); });
+                break;
+            case VECTOR | REAL:
+                value = readVector<double>(stream, [&stream]() { return read<double>(stream); });
+                break;
+            case VECTOR | BOOLEAN:
+                value = readVector<bool>(stream, [&stream]() { return static_cast<bool>(read<uint8_t>(stream)); });
+                break;
+            case VECTOR | STRING:
+                value = readVector<std::string>(stream, [&stream]() { return read<std::string>(stream); });
+                break;
+            case VECTOR | INPUT_TAG:
+                value = readVector<InputTag>(stream, [&stream]() { return read<InputTag>(stream); });
+                break;
+            case VECTOR | PARAMETER_SET:
+                value = readVector<ParameterSet>(stream, readSet);
+                break;
+            default:
+                throw invalid_file_error("Invalid type for parameter '" + name + "'");
+        }
+
+        set.m_set.erase(name);
+        set.m_set.emplace(name, ParameterSet::Element(value, false));
+    }
+
+    uint64_t n_references = read<uint64_t>(stream);
+    for (uint64_t i = 0; i < n_references; i++) {
+        std::string name = read<std::string>(stream);
+        set.m_references[name] = read<std::string>(stream);
+    }
+}
+
+void Configuration::save(std::ostream& stream) const {
+    stream.write(MAGIC, sizeof(MAGIC));
+    write(stream, VERSION);
+    write(stream, BYTE_ORDER_MARK);
+
+    write(stream, libraries);
+    write(stream, inputs);
+    write<uint64_t>(stream, n_dimensions);
+
+    write<uint64_t>(stream, integrands.size());
+    for (const auto& integrand: integrands)
+        write(stream, integrand);
+
+    write<uint64_t>(stream, paths.size());
+    for (const auto& path: paths)
+        write(stream, path->elements);
+
+    saveParameterSet(stream, *global_parameters, paths);
+    saveParameterSet(stream, *cuba_configuration, paths);
+
+    write<uint64_t>(stream, modules.size());
+    for (const auto& module: modules) {
+        write(stream, module.name);
+        write(stream, module.type);
+        saveParameterSet(stream, *module.parameters, paths);
+    }
+}
+
+Configuration Configuration::load(std::istream& stream) {
+    char magic[sizeof(MAGIC)];
+    if (!stream.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw invalid_file_error("Not a MoMEMta configuration file");
+
+    if (read<uint32_t>(stream) != VERSION || read<uint32_t>(stream) != BYTE_ORDER_MARK)
+        throw invalid_file_error("Unsupported version or byte order");
+
+    Configuration c;
+
+    c.libraries = read<std::vector<std::string>>(stream);
+    c.inputs = read<std::vector<std::string>>(stream);
+    c.n_dimensions = read<uint64_t>(stream);
+
+    c.integrands.resize(read<uint64_t>(stream));
+    for (auto& integrand: c.integrands)
+        integrand = read<InputTag>(stream);
+
+    uint64_t n_paths = read<uint64_t>(stream);
+    for (uint64_t i = 0; i < n_paths; i++) {
+        auto path = std::make_shared<PathElements>();
+        path->resolved = false;
+        path->elements = read<std::vector<std::string>>(stream);
+
+        c.owned_paths.push_back(path);
+        c.paths.push_back(path.get());
+    }
+
+    c.global_parameters.reset(new ParameterSet());
+    loadParameterSet(stream, *c.global_parameters, c.paths);
+    c.cuba_configuration.reset(new ParameterSet());
+    loadParameterSet(stream, *c.cuba_configuration, c.paths);
+
+    c.modules.resize(read<uint64_t>(stream));
+    for (auto& module: c.modules) {
+        module.name = read<std::string>(stream);
+        module.type = read<std::string>(stream);
+        module.parameters.reset(new ParameterSet());
+        loadParameterSet(stream, *module.parameters, c.paths);
+    }
+
+    // Modules declared in shared libraries must be registered before being used
+    for (const auto& library: c.libraries) {
+#ifdef ROOT_FREE_CORE
+        if (library == ROOT_PLUGIN_NAME) {
+            LibraryManager::get().loadROOTPlugin();
+            continue;
+        }
+#endif
+        LibraryManager::get().registerLibrary(library);
+    }
+
+    return c.freeze();
+}
+
+void Configuration::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        throw invalid_file_error("Could not open file " + path + " for writing");
+
+    save(file);
+
+    if (!file)
+        throw invalid_file_error("Error while writing file " + path);
+}
+
+Configuration Configuration::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw invalid_file_error("Could not open file " + path);
+
+    LOG(debug) << "Loading frozen configuration from " << path;
+    return load(file);
+}
@@ -17,9 +17,19 @@
  */
 
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <unistd.h>
+
 #include <lua.hpp>
 
 #include <momemta/any.h>
+#include <momemta/config.h>
 #include <momemta/Logging.h>
 #include <momemta/ConfigurationReader.h>
 #include <momemta/ModuleFactory.h>
@@ -106,6 +116,10 @@ void ConfigurationReader::onNewInputDeclared(const std::string& name) {
     configuration.inputs.push_back(name);
 }
 
+void ConfigurationReader::onLibraryLoaded(const std::string& path) {
+    configuration.libraries.push_back(path);
+}
+
 ParameterSet& ConfigurationReader::getGlobalParameters() {
     return *configuration.global_parameters;
 }
@@ -117,3 +131,69 @@ ParameterSet& ConfigurationReader::getCubaConfiguration() {
 Configuration ConfigurationReader::freeze() const {
     return configuration.freeze();
 }
+
+namespace {
+/// 64 bits FNV-1a hash
+uint64_t hash(const std::string& data) {
+    uint64_t result = 0xcbf29ce484222325;
+    for (unsigned char c: data) {
+        result ^= c;
+        result *= 0x100000001b3;
+    }
+
+    return result;
+}
+}
+
+Configuration ConfigurationReader::readCached(const std::string& file, const ParameterSet& parameters,
+                                              const std::string& cache_directory) {
+
+    std::ifstream lua_file(file, std::ios::binary);
+    if (!lua_file) {
+        LOG(fatal) << "Failed to open configuration file " << file;
+        throw lua::invalid_configuration_file("Could not open file " + file);
+    }
+
+    // The cache is only valid for the same version of MoMEMta, with the same modules available
+    std::ostringstream key;
+    key << MOMEMTA_VERSION << '\0';
+
+    auto modules = ModuleFactory::get().getPluginsList();
+    std::sort(modules.begin(), modules.end());
+    for (const auto& module: modules)
+        key << module << '\0';
+
+    key << lua_file.rdbuf();
+    Configuration::saveParameterSet(key, parameters, {});
+
+    std::ostringstream name;
+    name << cache_directory << "/" << std::hex << std::setfill('0') << std::setw(16) << hash(key.str()) << ".momemta";
+    const std::string cache = name.str();
+
+    if (::access(cache.c_str(), R_OK) == 0) {
+        try {
+            return Configuration::load(cache);
+        } catch (const Configuration::invalid_file_error& e) {
+            LOG(warning) << "Ignoring invalid configuration cache " << cache << ": " << e.what();
+        }
+    }
+
+    std::stringstream frozen;
+    ConfigurationReader(file, parameters).freeze().save(frozen);
+
+    // Write to a temporary file first, so that concurrent jobs never see a partial cache
+    const std::string temporary = cache + "." + std::to_string(::getpid());
+    std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+    output << frozen.str();
+    output.close();
+
+    if (output && std::rename(temporary.c_str(), cache.c_str()) == 0) {
+        LOG(debug) << "Frozen configuration cached in " << cache;
+    } else {
+        LOG(warning) << "Could not write configuration cache " << cache;
+        std::remove(temporary.c_str());
+    }
+
+    // The paths of the parsed configuration are owned by the lua runtime, which is gone: use a copy owning them
+    return Configuration::load(frozen);
+}
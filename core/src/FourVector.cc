@@ -0,0 +1,125 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <momemta/FourVector.h>
+
+#include <stdexcept>
+
+namespace momemta {
+
+FourVectorBatch::FourVectorBatch(size_t size) {
+    resize(size);
+}
+
+void FourVectorBatch::reserve(size_t size) {
+    m_px.reserve(size);
+    m_py.reserve(size);
+    m_pz.reserve(size);
+    m_e.reserve(size);
+}
+
+void FourVectorBatch::resize(size_t size) {
+    m_px.resize(size);
+    m_py.resize(size);
+    m_pz.resize(size);
+    m_e.resize(size);
+}
+
+void FourVectorBatch::clear() {
+    m_px.clear();
+    m_py.clear();
+    m_pz.clear();
+    m_e.clear();
+}
+
+void FourVectorBatch::masses2(double* out) const {
+    const size_t n = size();
+    const double* px = m_px.data();
+    const double* py = m_py.data();
+    const double* pz = m_pz.data();
+    const double* e = m_e.data();
+
+    for (size_t i = 0; i < n; i++)
+        out[i] = e[i] * e[i] - px[i] * px[i] - py[i] * py[i] - pz[i] * pz[i];
+}
+
+void FourVectorBatch::masses(double* out) const {
+    masses2(out);
+
+    const size_t n = size();
+    for (size_t i = 0; i < n; i++)
+        out[i] = std::copysign(std::sqrt(std::abs(out[i])), out[i]);
+}
+
+void FourVectorBatch::pts(double* out) const {
+    const size_t n = size();
+    const double* px = m_px.data();
+    const double* py = m_py.data();
+
+    for (size_t i = 0; i < n; i++)
+        out[i] = std::sqrt(px[i] * px[i] + py[i] * py[i]);
+}
+
+void FourVectorBatch::momenta(double* out) const {
+    const size_t n = size();
+    const double* px = m_px.data();
+    const double* py = m_py.data();
+    const double* pz = m_pz.data();
+
+    for (size_t i = 0; i < n; i++)
+        out[i] = std::sqrt(px[i] * px[i] + py[i] * py[i] + pz[i] * pz[i]);
+}
+
+void FourVectorBatch::pairMasses2(const FourVectorBatch& other, double* out) const {
+    if (other.size() != size())
+        throw std::invalid_argument("Batches must have the same size");
+
+    const size_t n = size();
+    for (size_t i = 0; i < n; i++) {
+        const double px = m_px[i] + other.m_px[i];
+        const double py = m_py[i] + other.m_py[i];
+        const double pz = m_pz[i] + other.m_pz[i];
+        const double e = m_e[i] + other.m_e[i];
+        out[i] = e * e - px * px - py * py - pz * pz;
+    }
+}
+
+void FourVectorBatch::boost(double bx, double by, double bz) {
+    const double b2 = bx * bx + by * by + bz * bz;
+    const double gamma = 1. / std::sqrt(1. - b2);
+    const double gamma2 = b2 > 0 ? (gamma - 1.) / b2 : 0.;
+
+    const size_t n = size();
+    double* px = m_px.data();
+    double* py = m_py.data();
+    double* pz = m_pz.data();
+    double* e = m_e.data();
+
+    for (size_t i = 0; i < n; i++) {
+        const double bp = bx * px[i] + by * py[i] + bz * pz[i];
+        const double factor = gamma2 * bp + gamma * e[i];
+
+        px[i] += factor * bx;
+        py[i] += factor * by;
+        pz[i] += factor * bz;
+        e[i] = gamma * (e[i] + bp);
+    }
+}
+
+}
@@ -0,0 +1,56 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <momemta/Histogram.h>
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace momemta {
+
+Histogram::Histogram(size_t n_bins, double min, double max):
+    m_axis(n_bins, min, max), m_sumw(n_bins + 2, 0.), m_sumw2(n_bins + 2, 0.) {
+    // Empty
+}
+
+Histogram& Histogram::operator+=(const Histogram& other) {
+    if (nBins() != other.nBins() || min() != other.min() || max() != other.max())
+        throw std::invalid_argument("Cannot add histograms with different binnings");
+
+    for (size_t i = 0; i < m_sumw.size(); i++) {
+        m_sumw[i] += other.m_sumw[i];
+        m_sumw2[i] += other.m_sumw2[i];
+    }
+    m_entries += other.m_entries;
+
+    return *this;
+}
+
+void Histogram::reset() {
+    std::fill(m_sumw.begin(), m_sumw.end(), 0.);
+    std::fill(m_sumw2.begin(), m_sumw2.end(), 0.);
+    m_entries = 0;
+}
+
+double Histogram::integral() const {
+    return std::accumulate(m_sumw.begin() + 1, m_sumw.end() - 1, 0.);
+}
+
+}
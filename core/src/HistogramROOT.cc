@@ -0,0 +1,57 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file
+ * \brief Conversion of momemta::Histogram into ROOT histograms
+ *
+ * Part of the ROOT plugin when MoMEMta is built with the `ROOT_FREE_CORE` option.
+ */
+
+#include <momemta/Histogram.h>
+
+#include <cmath>
+#include <stdexcept>
+
+#include <TH1D.h>
+
+namespace momemta {
+
+std::unique_ptr<TH1D> Histogram::toTH1D(const std::string& name, const std::string& title) const {
+    std::unique_ptr<TH1D> hist(new TH1D(name.c_str(), title.c_str(), nBins(), min(), max()));
+    hist->SetDirectory(nullptr);
+    fillTH1D(*hist);
+
+    return hist;
+}
+
+void Histogram::fillTH1D(TH1D& hist) const {
+    if (static_cast<size_t>(hist.GetNbinsX()) != nBins())
+        throw std::invalid_argument("Cannot copy a histogram into a TH1D with a different number of bins");
+
+    hist.Reset();
+    for (size_t i = 0; i < m_sumw.size(); i++) {
+        hist.SetBinContent(i, m_sumw[i]);
+        hist.SetBinError(i, std::sqrt(m_sumw2[i]));
+    }
+    // SetBinContent() counts one entry per call
+    hist.SetEntries(m_entries);
+}
+
+}
@@ -20,6 +20,10 @@
 #include <LibraryManager.h>
 
 #include <momemta/Logging.h>
+#include <momemta/config.h>
+
+#include <dlfcn.h>
+#include <unistd.h>
 
 LibraryManager& LibraryManager::get() {
     static LibraryManager s_instance;
@@ -31,3 +35,37 @@ void LibraryManager::registerLibrary(const std::string& path) {
     LOG(debug) << "Loading library: " << path;
     m_libraries.push_back(std::make_shared<SharedLibrary>(path));
 }
+
+bool LibraryManager::loadROOTPlugin() {
+    std::lock_guard<std::mutex> lock(m_root_plugin_mutex);
+    if (m_root_plugin)
+        return true;
+
+    std::vector<std::string> candidates;
+
+    // Directory of the MoMEMta library
+    Dl_info info;
+    if (::dladdr(reinterpret_cast<void*>(&LibraryManager::get), &info) && info.dli_fname) {
+        std::string library = info.dli_fname;
+        auto slash = library.rfind('/');
+        if (slash != std::string::npos)
+            candidates.push_back(library.substr(0, slash + 1) + ROOT_PLUGIN_NAME);
+    }
+    candidates.push_back(ROOT_PLUGIN_NAME);
+
+    for (const auto& path: candidates) {
+        // Do not log an error for a candidate which does not exist
+        if (path.find('/') != std::string::npos && ::access(path.c_str(), F_OK) != 0)
+            continue;
+
+        auto library = std::make_shared<SharedLibrary>(path);
+        if (library->isLoaded()) {
+            LOG(debug) << "Loaded ROOT plugin: " << path;
+            m_root_plugin = library;
+            return true;
+        }
+    }
+
+    LOG(error) << "Could not load the ROOT plugin (" << ROOT_PLUGIN_NAME << ")";
+    return false;
+}
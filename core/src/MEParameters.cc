@@ -28,4 +28,12 @@ void momemta::MEParameters::setParameter(const std::string& name, double value)
     }
 
     it->second = value;
-}
\ No newline at end of file
+}
+
+bool momemta::MEParameters::hasParameter(const std::string& name) const {
+    return m_card_parameters.count(name) > 0;
+}
+
+double momemta::MEParameters::getParameter(const std::string& name) const {
+    return m_card_parameters.at(name);
+}
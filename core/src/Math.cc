@@ -18,11 +18,13 @@
 
 #include <momemta/Math.h>
 
+#include <algorithm>
 #include <iostream>
 
 using namespace std;
 
-bool solveQuadratic(const double a, const double b, const double c, std::vector<double>& roots,
+template <typename Container>
+bool solveQuadratic(const double a, const double b, const double c, Container& roots,
                     bool verbose) {
 
     if (!a) {
@@ -65,8 +67,9 @@ bool solveQuadratic(const double a, const double b, const double c, std::vector<
     }
 }
 
+template <typename Container>
 bool solveCubic(const double a, const double b, const double c, const double d,
-                std::vector<double>& roots, bool verbose) {
+                Container& roots, bool verbose) {
 
     if (a == 0)
         return solveQuadratic(b, c, d, roots, verbose);
@@ -113,8 +116,9 @@ bool solveCubic(const double a, const double b, const double c, const double d,
     return true;
 }
 
+template <typename Container>
 bool solveQuartic(const double a, const double b, const double c, const double d, const double e,
-                  std::vector<double>& roots, bool verbose) {
+                  Container& roots, bool verbose) {
 
     if (!a)
         return solveCubic(b, c, d, e, roots, verbose);
@@ -125,7 +129,7 @@ bool solveQuartic(const double a, const double b, const double c, const double d
         roots.push_back(0.);
         roots.push_back(0.);
     } else if (!b && !d) {
-        std::vector<double> sq_sol;
+        Roots sq_sol;
         solveQuadratic(a, c, e, sq_sol, verbose);
         for (unsigned short i = 0; i < sq_sol.size(); ++i) {
             if (sq_sol[i] < 0)
@@ -140,7 +144,7 @@ bool solveQuartic(const double a, const double b, const double c, const double d
         const double dn =
                 -3. * QU(0.25 * b / a) + e / a - 0.25 * b * d / SQ(a) + c * SQ(b / 4.) / CB(a);
 
-        std::vector<double> res;
+        Roots res;
         solveCubic(1., 2. * bn, SQ(bn) - 4. * dn, -SQ(cn), res, verbose);
         short pChoice = -1;
 
@@ -188,10 +192,11 @@ bool solveQuartic(const double a, const double b, const double c, const double d
     return nRoots > 0;
 }
 
+template <typename Container>
 bool solve2Quads(const double a20, const double a02, const double a11, const double a10,
                  const double a01, const double a00, const double b20, const double b02,
                  const double b11, const double b10, const double b01, const double b00,
-                 std::vector<double>& E1, std::vector<double>& E2, bool verbose) {
+                 Container& E1, Container& E2, bool verbose) {
 
     // The procedure used in this function relies on a20 != 0 or b20 != 0
     if (a20 == 0. && b20 == 0.) {
@@ -237,7 +242,7 @@ bool solve2Quads(const double a20, const double a02, const double a11, const dou
         } else if (alpha * SQ(e2) + delta * e2 + omega == 0.) {
             // Up to two solutions for e1
 
-            std::vector<double> e1;
+            Roots e1;
 
             if (!solveQuadratic(a20, a11 * e2 + a10, a02 * SQ(e2) + a01 * e2 + a00, e1, verbose)) {
 
@@ -292,9 +297,10 @@ bool solve2Quads(const double a20, const double a02, const double a11, const dou
     return true;
 }
 
+template <typename Container>
 bool solve2QuadsDeg(const double a11, const double a10, const double a01, const double a00,
                     const double b11, const double b10, const double b01, const double b00,
-                    vector<double>& E1, vector<double>& E2, bool verbose) {
+                    Container& E1, Container& E2, bool verbose) {
 
     if (a11 == 0. && b11 == 0.)
         return solve2Linear(a10, a01, a00, b10, b01, b00, E1, E2, verbose);
@@ -353,9 +359,10 @@ bool solve2QuadsDeg(const double a11, const double a10, const double a01, const
     return E1.size();
 }
 
+template <typename Container>
 bool solve2Linear(const double a10, const double a01, const double a00, const double b10,
-                  const double b01, const double b00, std::vector<double>& E1,
-                  std::vector<double>& E2, bool verbose) {
+                  const double b01, const double b00, Container& E1,
+                  Container& E2, bool verbose) {
 
     const double det = a10 * b01 - b10 * a01;
 
@@ -396,7 +403,133 @@ bool solve2Linear(const double a10, const double a01, const double a00, const do
     return true;
 }
 
+void solveQuarticBatch(size_t n, const double* a, const double* b, const double* c, const double* d,
+                       const double* e, Roots* roots) {
+
+    // Temporaries are kept on the stack
+    constexpr size_t CHUNK = 16;
+    double an[CHUNK], bn[CHUNK], cn[CHUNK], res[CHUNK];
+
+    for (size_t start = 0; start < n; start += CHUNK) {
+        const size_t size = std::min(CHUNK, n - start);
+        const double* ai = a + start;
+        const double* bi = b + start;
+        const double* ci = c + start;
+        const double* di = d + start;
+        const double* ei = e + start;
+
+        // Depressed quartic and first positive root of its resolvent cubic, as in solveQuartic and
+        // solveCubic. Values computed for the special cases are meaningless, and discarded below.
+        for (size_t i = 0; i < size; i++) {
+            an[i] = bi[i] / ai[i];
+            bn[i] = ci[i] / ai[i] - (3. / 8.) * SQ(bi[i] / ai[i]);
+            cn[i] = CB(0.5 * bi[i] / ai[i]) - 0.5 * bi[i] * ci[i] / SQ(ai[i]) + di[i] / ai[i];
+            const double dn = -3. * QU(0.25 * bi[i] / ai[i]) + ei[i] / ai[i] - 0.25 * bi[i] * di[i] / SQ(ai[i]) +
+                              ci[i] * SQ(bi[i] / 4.) / CB(ai[i]);
+
+            // Resolvent cubic: x^3 + r2 x^2 + r1 x + r0 = 0
+            const double r2 = 2. * bn[i];
+            const double r1 = SQ(bn[i]) - 4. * dn;
+            const double r0 = -SQ(cn[i]);
+
+            const double Q = SQ(r2) / 9. - r1 / 3.;
+            const double R = CB(r2) / 27. - r2 * r1 / 6. + r0 / 2.;
+
+            // Three real roots
+            const double theta = std::acos(R / std::sqrt(CB(Q))) / 3.;
+            const double x0 = -2. * std::sqrt(Q) * std::cos(theta) - r2 / 3.;
+            const double x1 = -2. * std::sqrt(Q) * cosXpm2PI3(theta, 1.) - r2 / 3.;
+            const double x2 = -2. * std::sqrt(Q) * cosXpm2PI3(theta, -1.) - r2 / 3.;
+
+            // One real root
+            const double A = -sign(R) * std::cbrt(std::abs(R) + std::sqrt(SQ(R) - CB(Q)));
+            const double B = (A == 0.) ? 0. : Q / A;
+            const double x = A + B - r2 / 3.;
+
+            res[i] = (SQ(R) < CB(Q)) ? ((x0 > 0) ? x0 : ((x1 > 0) ? x1 : x2)) : x;
+        }
+
+        for (size_t i = 0; i < size; i++) {
+            Roots& r = roots[start + i];
+            r.clear();
+
+            if (!ai[i] || (!bi[i] && !di[i])) {
+                solveQuartic(ai[i], bi[i], ci[i], di[i], ei[i], r);
+                continue;
+            }
+
+            // No positive root for the resolvent cubic: no real solution
+            if (!(res[i] > 0))
+                continue;
+
+            const double p = std::sqrt(res[i]);
+            solveQuadratic(p, SQ(p), 0.5 * (p * (bn[i] + res[i]) - cn[i]), r);
+            solveQuadratic(p, -SQ(p), 0.5 * (p * (bn[i] + res[i]) + cn[i]), r);
+
+            for (auto& root: r)
+                root -= an[i] / 4.;
+        }
+    }
+}
+
+// Solvers are available for std::vector and Roots
+#define INSTANTIATE_SOLVERS(Container) \
+    template bool solveQuadratic(const double, const double, const double, Container&, bool); \
+    template bool solveCubic(const double, const double, const double, const double, Container&, bool); \
+    template bool solveQuartic(const double, const double, const double, const double, const double, Container&, bool); \
+    template bool solve2Quads(const double, const double, const double, const double, const double, const double, \
+                              const double, const double, const double, const double, const double, const double, \
+                              Container&, Container&, bool); \
+    template bool solve2QuadsDeg(const double, const double, const double, const double, const double, const double, \
+                                 const double, const double, Container&, Container&, bool); \
+    template bool solve2Linear(const double, const double, const double, const double, const double, const double, \
+                               Container&, Container&, bool);
+
+INSTANTIATE_SOLVERS(std::vector<double>)
+INSTANTIATE_SOLVERS(Roots)
+
 double BreitWigner(const double s, const double m, const double g) {
     double k = m * g;
     return k / (std::pow(s - m * m, 2.) + std::pow(m * g, 2.));
 }
+
+#ifdef ROOT_FREE_CORE
+double normalQuantileAS241(double p) {
+    // Algorithm AS241, Applied Statistics (1988) Vol. 37, No. 3, pp. 477-484
+    const double q = p - 0.5;
+    double r, x;
+
+    if (std::abs(q) <= 0.425) {
+        r = 0.180625 - q * q;
+        x = q * (((((((r * 2509.0809287301226727 + 33430.575583588128105) * r + 67265.770927008700853) * r
+                     + 45921.953931549871457) * r + 13731.693765509461125) * r + 1971.5909503065514427) * r
+                     + 133.14166789178437745) * r + 3.387132872796366608)
+              / (((((((r * 5226.495278852545925 + 28729.085735721942674) * r + 39307.89580009271061) * r
+                     + 21213.794301586595867) * r + 5394.1960214247511077) * r + 687.1870074920579083) * r
+                     + 42.313330701600911252) * r + 1.);
+
+        return x;
+    }
+
+    r = std::sqrt(-std::log(q < 0 ? p : 1. - p));
+    if (r <= 5.) {
+        r -= 1.6;
+        x = (((((((r * 7.7454501427834140764e-4 + 0.0227238449892691845833) * r + 0.24178072517745061177) * r
+                 + 1.27045825245236838258) * r + 3.64784832476320460504) * r + 5.7694972214606914055) * r
+                 + 4.6303378461565452959) * r + 1.42343711074968357734)
+          / (((((((r * 1.05075007164441684324e-9 + 5.475938084995344946e-4) * r + 0.0151986665636164571966) * r
+                 + 0.14810397642748007459) * r + 0.68976733498510000455) * r + 1.6763848301838038494) * r
+                 + 2.05319162663775882187) * r + 1.);
+    } else {
+        r -= 5.;
+        x = (((((((r * 2.01033439929228813265e-7 + 2.71155556874348757815e-5) * r + 0.0012426609473880784386) * r
+                 + 0.026532189526576123093) * r + 0.29656057182850489123) * r + 1.7848265399172913358) * r
+                 + 5.4637849111641143699) * r + 6.6579046435011037772)
+          / (((((((r * 2.04426310338993978564e-15 + 1.4215117583164458887e-7) * r + 1.8463183175100546818e-5) * r
+                 + 7.868691311456132591e-4) * r + 0.0148753612908506148525) * r + 0.13692988092273580531) * r
+                 + 0.59983220655588793769) * r + 1.);
+    }
+
+    return q < 0 ? -x : x;
+}
+#endif
@@ -18,7 +18,11 @@
 
 #include <momemta/MoMEMta.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <set>
+#include <unordered_map>
 
 #include <cuba.h>
 
@@ -30,6 +34,7 @@
 #include <momemta/Unused.h>
 
 #include <Graph.h>
+#include <ThreadTeam.h>
 
 #ifdef DEBUG_TIMING
 using namespace std::chrono;
@@ -38,28 +43,57 @@ using namespace std::chrono;
 #define CUBA_ABORT -999
 #define CUBA_OK 0
 
-MoMEMta::MoMEMta(const Configuration& configuration) {
+// Largest number of integrand components supported by cuba
+#define CUBA_MAX_COMPONENTS 1024
+
+void MoMEMta::initPool(const ParameterSet& cuba_configuration, const std::vector<std::string>& inputs) {
 
     // Initialize shared memory pool for modules
     m_pool.reset(new Pool());
 
+    // Memory arena for the temporaries of the modules, reset for each phase-space point
+    int64_t arena_block_size = cuba_configuration.get<int64_t>("arena_block_size", 1 << 20);
+    bool huge_pages = cuba_configuration.get<bool>("huge_pages", false);
+    m_pool->m_arena.reset(new momemta::Arena(arena_block_size, huge_pages));
+
     // Create phase-space points vector, input for many modules
     m_pool->current_module("cuba");
     m_ps_points = m_pool->put<std::vector<double>>({"cuba", "ps_points"});
     m_ps_weight = m_pool->put<double>({"cuba", "ps_weight"});
 
     // For each input declared in the configuration, create pool entries for p4 and type
-    auto inputs = configuration.getInputs();
     for (const auto& input: inputs) {
         LOG(debug) << "Input declared: " << input;
         m_pool->current_module(input);
         m_inputs_p4.emplace(input, m_pool->put<LorentzVector>({input, "p4"}));
         m_inputs_type.emplace(input, m_pool->put<int64_t>({input, "type"}));
+
+        m_input_names.push_back(input);
+        m_inputs_p4_by_handle.push_back(m_inputs_p4.at(input).get());
+        m_inputs_type_by_handle.push_back(m_inputs_type.at(input).get());
     }
 
     // Create input for met
     m_pool->current_module("met");
     m_met = m_pool->put<LorentzVector>({"met", "p4"});
+}
+
+void MoMEMta::retargetPaths(ParameterSet& parameters, const std::unordered_map<PathElements*, PathElements*>& paths) {
+    for (auto& parameter: parameters.m_set) {
+        if (parameter.second.value.type() == typeid(Path)) {
+            Path& path = momemta::any_cast<Path&>(parameter.second.value);
+            auto it = paths.find(path.elements_);
+            if (it != paths.end())
+                path.elements_ = it->second;
+        }
+    }
+}
+
+MoMEMta::MoMEMta(const Configuration& configuration) {
+
+    initPool(configuration.getCubaConfiguration(), configuration.getInputs());
+
+    m_global_parameters = configuration.getGlobalParameters();
 
     // Construct modules from configuration
     std::vector<Configuration::Module> light_modules = configuration.getModules();
@@ -67,6 +101,7 @@ MoMEMta::MoMEMta(const Configuration& configuration) {
         m_pool->current_module(module);
         try {
             m_modules.push_back(ModuleFactory::get().create(module.type, m_pool, *module.parameters));
+            m_global_parameters_reads[module.name] = module.parameters->globalParametersReads();
         } catch (...) {
             LOG(fatal) << "Exception while trying to create module " << module.type << "::" << module.name
                        << ". See message above for a (possible) more detailed description of the error.";
@@ -92,11 +127,13 @@ MoMEMta::MoMEMta(const Configuration& configuration) {
     // Next, retrieve all the input tags for the components of the integrand
     m_pool->current_module("momemta");
 
+    m_integrand_tags = integrands;
     for(const auto& component: integrands) {
         m_integrands.push_back(m_pool->get<double>(component));
         LOG(debug) << "Configuration declared integrand component using: " << component.toString();
     }
     m_n_components = m_integrands.size();
+    m_cuba_probabilities.resize(m_n_components);
 
     m_cuba_configuration = configuration.getCubaConfiguration();
 
@@ -117,6 +154,18 @@ MoMEMta::MoMEMta(const Configuration& configuration) {
         module->configure();
     }
 
+    // Keep a resolved copy of the paths, used when re-creating modules in updateParameters()
+    std::unordered_map<PathElements*, PathElements*> paths;
+    for (const auto& path: configuration.getPaths()) {
+        m_paths.push_back(std::make_shared<PathElements>(*path));
+        paths.emplace(path, m_paths.back().get());
+    }
+
+    for (auto& description: m_pool->m_description) {
+        if (description.second.module.parameters)
+            retargetPaths(*description.second.module.parameters, paths);
+    }
+
     // Reset configuration path to the configuration state
     for (auto& path: configuration.getPaths()) {
         path->modules.clear();
@@ -127,6 +176,62 @@ MoMEMta::MoMEMta(const Configuration& configuration) {
     cubalogging(MoMEMta::cuba_logging);
 }
 
+MoMEMta::MoMEMta(const MoMEMta& other) {
+
+    // Same order of declaration as the original instance
+    initPool(other.m_cuba_configuration, other.m_input_names);
+
+    m_global_parameters = other.m_global_parameters;
+    m_global_parameters_reads = other.m_global_parameters_reads;
+    m_cuba_configuration = other.m_cuba_configuration;
+    m_n_dimensions = other.m_n_dimensions;
+    m_ps_points->resize(m_n_dimensions);
+
+    // The graph is already resolved: create the modules kept in the original instance, at the same place
+    std::unordered_map<PathElements*, PathElements*> paths;
+    for (const auto& path: other.m_paths) {
+        auto copy = std::make_shared<PathElements>();
+        copy->elements = path->elements;
+        copy->resolved = true;
+
+        m_paths.push_back(copy);
+        paths.emplace(path.get(), copy.get());
+    }
+
+    auto create = [this, &other, &paths](const ModulePtr& original) {
+        Configuration::Module module = other.m_pool->m_description.at(original->name()).module;
+        retargetPaths(*module.parameters, paths);
+
+        m_pool->current_module(module);
+        return ModuleFactory::get().create(module.type, m_pool, *module.parameters);
+    };
+
+    for (const auto& module: other.m_modules)
+        m_modules.push_back(create(module));
+
+    for (size_t i = 0; i < other.m_paths.size(); i++) {
+        for (const auto& module: other.m_paths[i]->modules)
+            m_paths[i]->modules.push_back(create(module));
+    }
+
+    m_pool->current_module("momemta");
+    m_integrand_tags = other.m_integrand_tags;
+    for (const auto& component: m_integrand_tags)
+        m_integrands.push_back(m_pool->get<double>(component));
+    m_n_components = m_integrands.size();
+    m_cuba_probabilities.resize(m_n_components);
+
+    m_pool->freeze();
+
+    for (const auto& module: m_modules) {
+        module->configure();
+    }
+}
+
+std::unique_ptr<MoMEMta> MoMEMta::clone() const {
+    return std::unique_ptr<MoMEMta>(new MoMEMta(*this));
+}
+
 MoMEMta::~MoMEMta() {
     for (const auto& module: m_modules) {
         module->finish();
@@ -137,6 +242,212 @@ const Pool& MoMEMta::getPool() const {
     return *m_pool;
 }
 
+namespace {
+/// \return True if \p a and \p b hold the same value. Values of unsupported types are never equal.
+bool equal(const momemta::any& a, const momemta::any& b) {
+    if (a.type() != b.type())
+        return false;
+
+    if (a.type() == typeid(int64_t))
+        return momemta::any_cast<int64_t>(a) == momemta::any_cast<int64_t>(b);
+    if (a.type() == typeid(double))
+        return momemta::any_cast<double>(a) == momemta::any_cast<double>(b);
+    if (a.type() == typeid(bool))
+        return momemta::any_cast<bool>(a) == momemta::any_cast<bool>(b);
+    if (a.type() == typeid(std::string))
+        return momemta::any_cast<const std::string&>(a) == momemta::any_cast<const std::string&>(b);
+
+    return false;
+}
+
+}
+
+void MoMEMta::updateParameters(const ParameterSet& parameters) {
+    std::vector<std::string> changed;
+    for (const auto& name: parameters.getNames()) {
+        if (!m_global_parameters.exists(name)) {
+            auto exception = unknown_parameter_error("Global parameter '" + name + "' is not declared in the configuration");
+            LOG(fatal) << exception.what();
+            throw exception;
+        }
+
+        const momemta::any& value = parameters.rawGet(name);
+        if (equal(m_global_parameters.rawGet(name), value))
+            continue;
+
+        changed.push_back(name);
+    }
+
+    if (changed.empty())
+        return;
+
+    const ParameterSet previous = m_global_parameters;
+    for (const auto& name: changed)
+        m_global_parameters.m_set.at(name).value = parameters.rawGet(name);
+
+    // Copies used for bulk evaluation hold the previous values
+    m_copies.clear();
+
+    try {
+        applyGlobalParameters(changed);
+    } catch (...) {
+        LOG(error) << "Failed to apply the new values of the global parameters. Restoring the previous ones.";
+        m_global_parameters = previous;
+        applyGlobalParameters(changed);
+
+        throw;
+    }
+}
+
+void MoMEMta::applyGlobalParameters(const std::vector<std::string>& changed) {
+    auto& description = m_pool->m_description;
+
+    // Elements of the path used by a module, or nullptr if the module does not use any path
+    auto pathOf = [](const Configuration::Module& module) -> PathElements* {
+        if (!module.parameters || !module.parameters->existsAs<Path>("path"))
+            return nullptr;
+
+        return module.parameters->get<Path>("path").elements_;
+    };
+
+    // Update the parameters of all the modules, and find the ones depending on the changed parameters
+    std::set<std::string> pending;
+    for (auto& d: description) {
+        if (!d.second.module.parameters)
+            continue;
+
+        bool depends = d.second.module.parameters->updateReferences(m_global_parameters, changed);
+
+        auto reads = m_global_parameters_reads.find(d.first);
+        if (reads != m_global_parameters_reads.end()) {
+            depends |= std::any_of(changed.begin(), changed.end(),
+                                   [&reads](const std::string& name) { return reads->second.count(name); });
+        }
+
+        if (depends && findModule(d.first))
+            pending.insert(d.first);
+    }
+
+    // Loopers hold the modules of their path: they must be re-created when one of them is
+    bool added = true;
+    while (added) {
+        added = false;
+        for (const auto& d: description) {
+            PathElements* path = pathOf(d.second.module);
+            if (!path || pending.count(d.first) || !findModule(d.first))
+                continue;
+
+            if (std::any_of(path->modules.begin(), path->modules.end(),
+                            [&pending](const ModulePtr& m) { return pending.count(m->name()); })) {
+                pending.insert(d.first);
+                added = true;
+            }
+        }
+    }
+
+    // Modules inside a path are re-created before the looper holding them
+    std::vector<std::string> recreated;
+    while (!pending.empty()) {
+        for (auto it = pending.begin(); it != pending.end();) {
+            PathElements* path = pathOf(description.at(*it).module);
+            if (path && std::any_of(path->modules.begin(), path->modules.end(),
+                                    [&pending](const ModulePtr& m) { return pending.count(m->name()); })) {
+                ++it;
+                continue;
+            }
+
+            LOG(debug) << "Re-creating module " << *it << " after an update of the global parameters";
+            recreateModule(*it);
+            recreated.push_back(*it);
+            it = pending.erase(it);
+        }
+    }
+
+    // Modules inside a path are configured by their looper
+    for (const auto& module: m_modules) {
+        if (std::find(recreated.begin(), recreated.end(), module->name()) != recreated.end())
+            module->configure();
+    }
+}
+
+ModulePtr* MoMEMta::findModule(const std::string& name) {
+    auto has_name = [&name](const ModulePtr& module) { return module->name() == name; };
+
+    auto it = std::find_if(m_modules.begin(), m_modules.end(), has_name);
+    if (it != m_modules.end())
+        return &*it;
+
+    for (const auto& path: m_paths) {
+        it = std::find_if(path->modules.begin(), path->modules.end(), has_name);
+        if (it != path->modules.end())
+            return &*it;
+    }
+
+    return nullptr;
+}
+
+void MoMEMta::recreateModule(const std::string& name) {
+    Description& description = m_pool->m_description.at(name);
+    ModulePtr& slot = *findModule(name);
+
+    // Restored if the creation fails
+    const Description previous = description;
+    std::vector<InputTag> existing;
+    for (const auto& block: m_pool->m_storage)
+        existing.push_back(block.first);
+
+    // The new module produces its outputs in the same memory blocks, already used by the other modules
+    for (const auto& output: previous.outputs) {
+        PoolContent& block = m_pool->m_storage.at(InputTag(name, output));
+        block.valid = false;
+        block.reproduced = true;
+    }
+    description.inputs.clear();
+    description.outputs.clear();
+
+    m_pool->m_frozen = false;
+    m_pool->current_module(description.module);
+
+    ModulePtr module;
+    try {
+        module = ModuleFactory::get().create(description.module.type, m_pool, *description.module.parameters);
+    } catch (...) {
+        LOG(fatal) << "Exception while trying to re-create module " << description.module.type << "::" << name
+                   << ". See message above for a (possible) more detailed description of the error.";
+
+        // Blocks requested by the new module only
+        for (auto it = m_pool->m_storage.begin(); it != m_pool->m_storage.end();) {
+            if (std::find(existing.begin(), existing.end(), it->first) == existing.end())
+                it = m_pool->m_storage.erase(it);
+            else
+                ++it;
+        }
+
+        for (const auto& output: previous.outputs) {
+            PoolContent& block = m_pool->m_storage.at(InputTag(name, output));
+            block.valid = true;
+            block.reproduced = false;
+        }
+        description = previous;
+        m_pool->freeze();
+
+        std::rethrow_exception(std::current_exception());
+    }
+
+    for (const auto& output: previous.outputs)
+        m_pool->m_storage.at(InputTag(name, output)).reproduced = false;
+
+    m_pool->freeze();
+
+    m_global_parameters_reads[name] = description.module.parameters->globalParametersReads();
+
+#ifdef DEBUG_TIMING
+    m_module_timing.erase(slot.get());
+#endif
+
+    slot = module;
+}
+
 std::vector<std::pair<double, double>> MoMEMta::computeWeights(const std::vector<momemta::Particle>& particles, const LorentzVector& met) {
 
     if (particles.size() != m_inputs_p4.size()) {
@@ -170,14 +481,209 @@ std::vector<std::pair<double, double>> MoMEMta::computeWeights(const std::vector
 
     *m_met = met;
 
-    for (const auto& module: m_modules) {
-        module->beginIntegration();
+    std::vector<double> values(m_n_components);
+    std::vector<double> errors(m_n_components);
+    integrate(values.data(), errors.data());
+
+    std::vector<std::pair<double, double>> result;
+    for (size_t i = 0; i < m_n_components; i++) {
+        result.push_back( std::make_pair(values[i], errors[i]) );
     }
 
-    std::unique_ptr<double[]> mcResult(new double[m_n_components]);
-    std::unique_ptr<double[]> error(new double[m_n_components]);
+    return result;
+}
 
-    for (size_t i = 0; i < m_n_components; i++) {
+MoMEMta::InputHandle MoMEMta::getInputHandle(const std::string& name) const {
+    auto it = std::find(m_input_names.begin(), m_input_names.end(), name);
+    if (it == m_input_names.end()) {
+        auto exception = invalid_inputs(name + " is not a declared input");
+        LOG(fatal) << exception.what();
+        throw exception;
+    }
+
+    return it - m_input_names.begin();
+}
+
+std::size_t MoMEMta::getNumberOfInputs() const {
+    return m_input_names.size();
+}
+
+std::size_t MoMEMta::getNumberOfComponents() const {
+    return m_n_components;
+}
+
+void MoMEMta::computeWeights(const LorentzVector* p4, const int64_t* types, const LorentzVector& met,
+                             double* values, double* errors) {
+
+    setInputs(p4, types, met);
+    integrate(values, errors);
+}
+
+size_t MoMEMta::computeWeightsLockStep(size_t n_events, const LorentzVector* p4, const int64_t* types,
+                                       const LorentzVector* met, double* values, double* errors,
+                                       IntegrationStatus* status) {
+
+    if (n_events == 0)
+        return 0;
+
+    if (n_events * m_n_components > CUBA_MAX_COMPONENTS) {
+        auto exception = invalid_inputs("Too many events integrated in lock-step: at most "
+                                        + std::to_string(CUBA_MAX_COMPONENTS / m_n_components) + " are supported");
+        LOG(fatal) << exception.what();
+        throw exception;
+    }
+
+    createCopies(n_events - 1);
+
+    const size_t n_inputs = m_inputs_p4_by_handle.size();
+    for (size_t event = 0; event < n_events; event++) {
+        MoMEMta& engine = (event == 0) ? *this : *m_copies[event - 1];
+        engine.setInputs(p4 + event * n_inputs, types ? types + event * n_inputs : nullptr,
+                         met ? met[event] : LorentzVector());
+        engine.m_lock_step_aborted = false;
+        m_lock_step_engines.push_back(&engine);
+    }
+
+    // Integrand components of all the events, event after event, reordered below
+    try {
+        integrate(values, errors);
+    } catch (...) {
+        m_lock_step_engines.clear();
+        throw;
+    }
+    m_lock_step_engines.clear();
+
+    size_t aborted = 0;
+    for (size_t event = 0; event < n_events; event++) {
+        MoMEMta& engine = (event == 0) ? *this : *m_copies[event - 1];
+        if (engine.m_lock_step_aborted) {
+            aborted++;
+            std::fill(values + event * m_n_components, values + (event + 1) * m_n_components, 0.);
+            std::fill(errors + event * m_n_components, errors + (event + 1) * m_n_components, 0.);
+        }
+
+        if (status)
+            status[event] = engine.m_lock_step_aborted ? IntegrationStatus::ABORTED : integration_status;
+    }
+
+    // From event after event to component after component
+    if (m_n_components > 1) {
+        m_lock_step_buffer.resize(n_events * m_n_components);
+        for (double* output: {values, errors}) {
+            std::copy(output, output + n_events * m_n_components, m_lock_step_buffer.begin());
+            for (size_t event = 0; event < n_events; event++) {
+                for (size_t i = 0; i < m_n_components; i++)
+                    output[i * n_events + event] = m_lock_step_buffer[event * m_n_components + i];
+            }
+        }
+    }
+
+    return aborted;
+}
+
+void MoMEMta::setInputs(const LorentzVector* p4, const int64_t* types, const LorentzVector& met) {
+    for (size_t handle = 0; handle < m_inputs_p4_by_handle.size(); handle++) {
+        checkIfPhysical(p4[handle]);
+
+        *m_inputs_p4_by_handle[handle] = p4[handle];
+        *m_inputs_type_by_handle[handle] = types ? types[handle] : 0;
+    }
+
+    *m_met = met;
+}
+
+void MoMEMta::createCopies(size_t n) {
+    while (m_copies.size() < n)
+        m_copies.push_back(clone());
+}
+
+size_t MoMEMta::computeWeightsBulk(size_t n_events, const LorentzVector* p4, const int64_t* types,
+                                   const LorentzVector* met, double* values, size_t threads) {
+
+    if (m_n_dimensions > 0) {
+        auto exception = unsupported_configuration_error("Bulk evaluation is only possible for configurations "
+                                                         "without integration dimension");
+        LOG(fatal) << exception.what();
+        throw exception;
+    }
+
+    threads = std::max<size_t>(threads, 1);
+
+    // Lane 0 is this instance, the other lanes use their own copy
+    if (threads > 1 && (!m_bulk_team || m_bulk_team->size() != threads))
+        m_bulk_team.reset(new ThreadTeam(threads));
+
+    createCopies(threads - 1);
+
+    // Events are distributed in chunks, so that lanes finishing early take over the remaining events
+    std::atomic<size_t> next_event(0);
+    std::atomic<size_t> aborted(0);
+    auto job = [&](size_t lane) {
+        MoMEMta& engine = (lane == 0) ? *this : *m_copies[lane - 1];
+
+        size_t lane_aborted = 0;
+        for (size_t begin = next_event.fetch_add(BULK_CHUNK_SIZE); begin < n_events;
+             begin = next_event.fetch_add(BULK_CHUNK_SIZE)) {
+            size_t end = std::min(begin + BULK_CHUNK_SIZE, n_events);
+            lane_aborted += engine.evaluateEvents(begin, end, n_events, p4, types, met, values);
+        }
+
+        aborted += lane_aborted;
+    };
+
+    if (threads > 1)
+        m_bulk_team->run(job);
+    else
+        job(0);
+
+    integration_status = aborted ? IntegrationStatus::ABORTED : IntegrationStatus::SUCCESS;
+
+    return aborted;
+}
+
+size_t MoMEMta::evaluateEvents(size_t begin, size_t end, size_t n_events, const LorentzVector* p4,
+                               const int64_t* types, const LorentzVector* met, double* values) {
+
+    const size_t n_inputs = m_inputs_p4_by_handle.size();
+    m_bulk_results.resize(m_n_components);
+    double* results = m_bulk_results.data();
+
+    size_t aborted = 0;
+    for (size_t event = begin; event < end; event++) {
+        setInputs(p4 + event * n_inputs, types ? types + event * n_inputs : nullptr,
+                  met ? met[event] : LorentzVector());
+
+        for (const auto& module: m_modules)
+            module->beginIntegration();
+
+        if (integrand(nullptr, results, nullptr) != CUBA_OK)
+            aborted++;
+
+        for (const auto& module: m_modules)
+            module->endIntegration();
+
+        for (size_t i = 0; i < m_n_components; i++)
+            values[i * n_events + event] = results[i];
+    }
+
+    return aborted;
+}
+
+void MoMEMta::integrate(double* mcResult, double* error) {
+
+    // In lock-step mode, the components of all the events are integrated at once
+    MoMEMta* const self = this;
+    MoMEMta* const* engines = m_lock_step_engines.empty() ? &self : m_lock_step_engines.data();
+    const size_t n_engines = m_lock_step_engines.empty() ? 1 : m_lock_step_engines.size();
+    const size_t n_components = n_engines * m_n_components;
+
+    for (size_t engine = 0; engine < n_engines; engine++) {
+        for (const auto& module: engines[engine]->m_modules) {
+            module->beginIntegration();
+        }
+    }
+
+    for (size_t i = 0; i < n_components; i++) {
         mcResult[i] = 0;
         error[i] = 0;
     }
@@ -208,16 +714,21 @@ std::vector<std::pair<double, double>> MoMEMta::computeWeights(const std::vector
 
         unsigned int flags = cuba::createFlagsBitset(verbosity, subregion, retainStateFile, level, smoothing, takeOnlyGridFromFile);
 
-        int64_t ncores = m_cuba_configuration.get<int64_t>("ncores", 0);
-        int64_t pcores = m_cuba_configuration.get<int64_t>("pcores", 1000000);
-        cubacores(ncores, pcores);
+        // The setting is global to cuba: under the scheduler, it's set once by Scheduler::computeWeights() before
+        // the workers start integrating
+        if (!m_points_evaluator) {
+            int64_t ncores = m_cuba_configuration.get<int64_t>("ncores", 0);
+            int64_t pcores = m_cuba_configuration.get<int64_t>("pcores", 1000000);
+            cubacores(ncores, pcores);
+        }
 
         // Output from cuba
         long long int neval = 0;
         int nfail = 0;
-        std::unique_ptr<double[]> prob(new double[m_n_components]);
+        m_cuba_probabilities.resize(n_components);
+        double* prob = m_cuba_probabilities.data();
 
-        for (size_t i = 0; i < m_n_components; i++) {
+        for (size_t i = 0; i < n_components; i++) {
             prob[i] = 0;
         }
 
@@ -229,10 +740,10 @@ std::vector<std::pair<double, double>> MoMEMta::computeWeights(const std::vector
 
             llVegas(
                     m_n_dimensions,         // (int) dimensions of the integrated volume
-                    m_n_components,         // (int) dimensions of the integrand
+                    n_components,           // (int) dimensions of the integrand
                     (integrand_t) CUBAIntegrandWeighted,  // (integrand_t) integrand (cast to integrand_t)
                     (void *) this,           // (void*) pointer to additional arguments passed to integrand
-                    1,                      // (int) maximum number of points given the integrand in each invocation (=> SIMD) ==> PS points = vector of sets of points (x[ndim][nvec]), integrand returns vector of vector values (f[ncomp][nvec])
+                    m_points_per_call,      // (int) maximum number of points given the integrand in each invocation (=> SIMD) ==> PS points = vector of sets of points (x[ndim][nvec]), integrand returns vector of vector values (f[ncomp][nvec])
                     relative_accuracy,      // (double) requested relative accuracy  /
                     absolute_accuracy,      // (double) requested absolute accuracy /-> error < max(rel*value,abs)
                     flags,                  // (int) various control flags in binary format, see setFlags function
@@ -247,9 +758,9 @@ std::vector<std::pair<double, double>> MoMEMta::computeWeights(const std::vector
                     nullptr,                   // (int*) "spinning cores": -1 || NULL <=> integrator takes care of starting & stopping child processes (other value => keep or retrieve child processes, probably not useful here)
                     &neval,                 // (int*) actual number of evaluations done
                     &nfail,                 // 0=desired accuracy was reached; -1=dimensions out of range; >0=accuracy was not reached
-                    mcResult.get(),         // (double*) integration result ([ncomp])
-                    error.get(),            // (double*) integration error ([ncomp])
-                    prob.get()              // (double*) Chi-square p-value that error is not reliable (ie should be <0.95) ([ncomp])
+                    mcResult,               // (double*) integration result ([ncomp])
+                    error,                  // (double*) integration error ([ncomp])
+                    prob                    // (double*) Chi-square p-value that error is not reliable (ie should be <0.95) ([ncomp])
             );
         } else if (algorithm == "suave") {
             int64_t n_new = m_cuba_configuration.get<int64_t>("n_new", 1000);
@@ -260,10 +771,10 @@ std::vector<std::pair<double, double>> MoMEMta::computeWeights(const std::vector
 
             llSuave(
                     m_n_dimensions,
-                    m_n_components,
+                    n_components,
                     (integrand_t) CUBAIntegrandWeighted,
                     (void *) this,
-                    1,
+                    m_points_per_call,
                     relative_accuracy,
                     absolute_accuracy,
                     flags,
@@ -278,9 +789,9 @@ std::vector<std::pair<double, double>> MoMEMta::computeWeights(const std::vector
                     &nregions,
                     &neval,
                     &nfail,
-                    mcResult.get(),
-                    error.get(),
-                    prob.get()
+                    mcResult,
+                    error,
+                    prob
             );
         } else if (algorithm == "divonne") {
             int64_t key1 = m_cuba_configuration.get<int64_t>("key1", 47);
@@ -295,10 +806,10 @@ std::vector<std::pair<double, double>> MoMEMta::computeWeights(const std::vector
 
             llDivonne(
                     m_n_dimensions,
-                    m_n_components,
+                    n_components,
                     (integrand_t) CUBAIntegrand,
                     (void *) this,
-                    1,
+                    m_points_per_call,
                     relative_accuracy,
                     absolute_accuracy,
                     flags,
@@ -320,9 +831,9 @@ std::vector<std::pair<double, double>> MoMEMta::computeWeights(const std::vector
                     &nregions,
                     &neval,
                     &nfail,
-                    mcResult.get(),
-                    error.get(),
-                    prob.get()
+                    mcResult,
+                    error,
+                    prob
             );
         } else if (algorithm == "cuhre") {
             int64_t key = m_cuba_configuration.get<int64_t>("key", 0);
@@ -331,10 +842,10 @@ std::vector<std::pair<double, double>> MoMEMta::computeWeights(const std::vector
 
             llCuhre(
                     m_n_dimensions,
-                    m_n_components,
+                    n_components,
                     (integrand_t) CUBAIntegrand,
                     (void *) this,
-                    1,
+                    m_points_per_call,
                     relative_accuracy,
                     absolute_accuracy,
                     flags,
@@ -346,9 +857,9 @@ std::vector<std::pair<double, double>> MoMEMta::computeWeights(const std::vector
                     &nregions,
                     &neval,
                     &nfail,
-                    mcResult.get(),
-                    error.get(),
-                    prob.get()
+                    mcResult,
+                    error,
+                    prob
             );
         } else {
             throw cuba_configuration_error("Integration algorithm " + algorithm + " is not supported");
@@ -368,7 +879,7 @@ std::vector<std::pair<double, double>> MoMEMta::computeWeights(const std::vector
         LOG(debug) << "No integration dimension requested, bypassing integration.";
 
         // Directly call integrand
-        int status = integrand(nullptr, mcResult.get(), nullptr);
+        int status = evaluate(nullptr, mcResult, nullptr);
 
         if (status == CUBA_OK) {
             integration_status = IntegrationStatus::SUCCESS;
@@ -384,20 +895,47 @@ std::vector<std::pair<double, double>> MoMEMta::computeWeights(const std::vector
     }
 #endif
 
-    for (const auto& module: m_modules) {
-        module->endIntegration();
+    for (size_t engine = 0; engine < n_engines; engine++) {
+        for (const auto& module: engines[engine]->m_modules) {
+            module->endIntegration();
+        }
     }
 
-    std::vector<std::pair<double, double>> result;
-    for (size_t i = 0; i < m_n_components; i++) {
-        result.push_back( std::make_pair(mcResult[i], error[i]) );
+    const momemta::Arena& arena = m_pool->arena();
+    LOG(debug) << "Per-point memory arena: peak usage of " << arena.peakUsage() << " bytes, "
+               << arena.allocations() << " allocations, " << arena.systemAllocations() << " blocks allocated";
+}
+
+int MoMEMta::evaluate(const double* psPoints, double* results, const double* weights) {
+    if (m_lock_step_engines.empty())
+        return integrand(psPoints, results, weights);
+
+    // Same phase-space point for all the events, each one filling its own components. An aborted event no longer
+    // contributes, and the integration is only aborted once all the events are.
+    size_t aborted = 0;
+    for (size_t i = 0; i < m_lock_step_engines.size(); i++) {
+        MoMEMta& engine = *m_lock_step_engines[i];
+        double* engine_results = results + i * m_n_components;
+
+        if (!engine.m_lock_step_aborted && engine.integrand(psPoints, engine_results, weights) != CUBA_OK) {
+            LOG(debug) << "Evaluation of event " << i << " aborted, the integration of the other events goes on";
+            engine.m_lock_step_aborted = true;
+        }
+
+        if (engine.m_lock_step_aborted) {
+            std::fill(engine_results, engine_results + m_n_components, 0.);
+            aborted++;
+        }
     }
 
-    return result;
+    return (aborted == m_lock_step_engines.size()) ? CUBA_ABORT : CUBA_OK;
 }
 
 int MoMEMta::integrand(const double* psPoints, double* results, const double* weights=nullptr) {
 
+    // Temporaries of the previous point are no longer used
+    m_pool->arena().reset();
+
     // Store phase-space points into the pool
     std::memcpy(m_ps_points->data(), psPoints, sizeof(double) * m_n_dimensions);
 
@@ -441,22 +979,34 @@ int MoMEMta::integrand(const double* psPoints, double* results, const double* we
     return CUBA_OK;
 }
 
+int MoMEMta::evaluatePoints(const double* psPoints, double* results, const double* weights, size_t n) {
+    if (m_points_evaluator)
+        return m_points_evaluator(psPoints, results, weights, n);
+
+    const size_t n_components = std::max<size_t>(m_lock_step_engines.size(), 1) * m_n_components;
+    for (size_t i = 0; i < n; i++) {
+        int status = evaluate(psPoints + i * m_n_dimensions, results + i * n_components, weights ? weights + i : nullptr);
+        if (status != CUBA_OK)
+            return status;
+    }
+
+    return CUBA_OK;
+}
+
 int MoMEMta::CUBAIntegrand(const int *nDim, const double* psPoint, const int *nComp, double *value, void *inputs, const int *nVec, const int *core) {
     UNUSED(nDim);
     UNUSED(nComp);
-    UNUSED(nVec);
     UNUSED(core);
 
-    return static_cast<MoMEMta*>(inputs)->integrand(psPoint, value);
+    return static_cast<MoMEMta*>(inputs)->evaluatePoints(psPoint, value, nullptr, *nVec);
 }
 
 int MoMEMta::CUBAIntegrandWeighted(const int *nDim, const double* psPoint, const int *nComp, double *value, void *inputs, const int *nVec, const int *core, const double *weight) {
     UNUSED(nDim);
     UNUSED(nComp);
-    UNUSED(nVec);
     UNUSED(core);
 
-    return static_cast<MoMEMta*>(inputs)->integrand(psPoint, value, weight);
+    return static_cast<MoMEMta*>(inputs)->evaluatePoints(psPoint, value, weight, *nVec);
 }
 
 void MoMEMta::cuba_logging(const char* s) {
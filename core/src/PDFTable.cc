@@ -0,0 +1,85 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <momemta/PDFTable.h>
+
+#include <stdexcept>
+
+namespace momemta {
+
+PDFTable::PDFTable(const std::vector<int>& flavours, double x_min, double x_max, size_t n_points,
+                   const Evaluator& xfx) {
+
+    if (n_points < 4)
+        throw std::invalid_argument("A PDF table needs at least 4 nodes");
+
+    if (!(x_min > 0 && x_min < x_max && x_max < 1))
+        throw std::invalid_argument("Invalid range for PDF table: 0 < x_min < x_max < 1 is required");
+
+    m_x_min = x_min;
+    m_x_max = x_max;
+    m_n_points = n_points;
+
+    m_u_min = toGrid(x_min);
+    const double step = (toGrid(x_max) - m_u_min) / (n_points - 1);
+    m_inv_step = 1. / step;
+
+    std::fill(std::begin(m_slots), std::end(m_slots), -1);
+    for (int pdg_id: flavours) {
+        if (pdg_id == 0)
+            pdg_id = 21;
+
+        if (pdg_id < MIN_PDG_ID || pdg_id > MAX_PDG_ID || hasFlavour(pdg_id))
+            continue;
+
+        m_slots[pdg_id - MIN_PDG_ID] = m_flavours.size();
+        m_flavours.push_back(pdg_id);
+    }
+
+    m_values.resize(m_flavours.size() * n_points);
+    for (size_t f = 0; f < m_flavours.size(); f++) {
+        for (size_t i = 0; i < n_points; i++) {
+            const double u = m_u_min + i * step;
+            const double x = 1. / (1. + std::exp(-u));
+            m_values[f * n_points + i] = xfx(m_flavours[f], x);
+        }
+    }
+}
+
+double PDFTable::validate(const Evaluator& xfx, double threshold) const {
+    const double step = 1. / m_inv_step;
+
+    double max_deviation = 0;
+    for (int pdg_id: m_flavours) {
+        for (size_t i = 0; i < m_n_points - 1; i++) {
+            const double u = m_u_min + (i + 0.5) * step;
+            const double x = 1. / (1. + std::exp(-u));
+
+            const double reference = xfx(pdg_id, x);
+            double deviation = std::abs(this->xfx(pdg_id, x) - reference);
+            if (std::abs(reference) > threshold)
+                deviation /= std::abs(reference);
+
+            max_deviation = std::max(max_deviation, deviation);
+        }
+    }
+
+    return max_deviation;
+}
+
+}
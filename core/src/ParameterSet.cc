@@ -18,6 +18,8 @@
 
 #include <momemta/ParameterSet.h>
 
+#include <algorithm>
+
 #include <momemta/Unused.h>
 
 #include <lua/LazyTable.h>
@@ -29,6 +31,8 @@ ParameterSet::ParameterSet(const std::string& module_type, const std::string& mo
 }
 
 const momemta::any& ParameterSet::rawGet(const std::string& name) const {
+    recordRead(name);
+
     auto value = m_set.find(name);
     if (value == m_set.end())
         throw not_found_error("Parameter '" + name + "' not found.");
@@ -41,6 +45,8 @@ bool ParameterSet::lazy() const {
 }
 
 bool ParameterSet::exists(const std::string& name) const {
+    recordRead(name);
+
     auto value = m_set.find(name);
     return (value != m_set.end());
 }
@@ -68,7 +74,11 @@ void ParameterSet::freeze() {
             if (element.lazy) {
                 element.lazy = false;
                 if (element.value.type() == typeid(lua::LazyFunction)) {
-                    element.value = momemta::any_cast<lua::LazyFunction>(element.value)();
+                    const auto& function = momemta::any_cast<const lua::LazyFunction&>(element.value);
+                    if (!function.parameter.empty())
+                        m_references[p.first] = function.parameter;
+
+                    element.value = function();
                 } else if (element.value.type() == typeid(lua::LazyTableField)) {
                     element.value = momemta::any_cast<lua::LazyTableField>(element.value)();
                 }
@@ -90,6 +100,40 @@ void ParameterSet::freeze() {
     }
 }
 
+bool ParameterSet::updateReferences(const ParameterSet& global_parameters, const std::vector<std::string>& names) {
+    bool updated = false;
+
+    for (auto& p: m_set) {
+        auto& value = p.second.value;
+
+        if (p.first == "@global_parameters") {
+            value = global_parameters;
+        } else if (value.type() == typeid(ParameterSet)) {
+            updated |= momemta::any_cast<ParameterSet&>(value).updateReferences(global_parameters, names);
+        } else if (value.type() == typeid(std::vector<ParameterSet>)) {
+            for (auto& set: momemta::any_cast<std::vector<ParameterSet>&>(value))
+                updated |= set.updateReferences(global_parameters, names);
+        }
+    }
+
+    for (const auto& reference: m_references) {
+        if (std::find(names.begin(), names.end(), reference.second) == names.end())
+            continue;
+
+        m_set.at(reference.first).value = global_parameters.rawGet(reference.second);
+        updated = true;
+    }
+
+    return updated;
+}
+
+std::set<std::string> ParameterSet::globalParametersReads() const {
+    auto it = m_set.find("@global_parameters");
+    const ParameterSet& global = (it == m_set.end()) ? *this : momemta::any_cast<const ParameterSet&>(it->second.value);
+
+    return global.m_record_reads ? global.m_reads : std::set<std::string>();
+}
+
 void ParameterSet::setGlobalParameters(const ParameterSet& parameters) {
     m_set.emplace("@global_parameters", Element(parameters, false));
 }
@@ -101,6 +145,7 @@ ParameterSet* ParameterSet::clone() const {
 std::vector<std::string> ParameterSet::getNames() const {
     std::vector<std::string> names;
     for (const auto& it: m_set) {
+        recordRead(it.first);
         names.push_back(it.first);
     }
 
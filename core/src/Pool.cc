@@ -20,6 +20,11 @@
 
 #include <momemta/Logging.h>
 
+Pool::Pool(std::shared_ptr<const Pool> parent):
+    m_parent(parent), m_arena(new momemta::Arena(parent->arena().blockSize(), parent->arena().hugePages())) {
+    // Empty
+}
+
 void Pool::remove(const InputTag& tag, bool force/* = true*/) {
     auto it = m_storage.find(tag);
     if (it == m_storage.end())
@@ -42,7 +47,7 @@ momemta::any Pool::reserve(const InputTag& tag) {
         // Reserve a slot, but mark it as invalid.
         // Once a module inform the pool it produces such a tag, the slot will
         // be flagged as valid.
-        PoolContent content { momemta::any(), false };
+        PoolContent content { momemta::any(), false, false };
         it = m_storage.emplace(tag, content).first;
     }
 
@@ -0,0 +1,317 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <momemta/Scheduler.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include <cuba.h>
+
+#include <momemta/Logging.h>
+
+#include <ThreadTeam.h>
+
+#define CUBA_ABORT -999
+#define CUBA_OK 0
+
+namespace momemta {
+
+struct Scheduler::Batch {
+    size_t event;
+    const double* points;
+    double* results;
+    const double* weights;
+    size_t n_points;
+
+    size_t n_chunks;
+    size_t next_chunk; ///< First chunk not yet taken by a worker
+    size_t done_chunks;
+    int status;
+};
+
+constexpr size_t Scheduler::NO_EVENT;
+
+Scheduler::Scheduler(MoMEMta& engine, size_t threads, size_t chunk_size):
+        m_chunk_size(std::max<size_t>(chunk_size, 1)) {
+
+    if (engine.m_cuba_configuration.get<int64_t>("ncores", 0) != 0) {
+        auto exception = invalid_configuration_error("The scheduler handles the threads itself: the `ncores` option "
+                                                     "of cuba must be 0");
+        LOG(fatal) << exception.what();
+        throw exception;
+    }
+
+    threads = std::max<size_t>(threads, 1);
+
+    m_engines.push_back(&engine);
+    for (size_t i = 1; i < threads; i++) {
+        m_copies.push_back(engine.clone());
+        m_engines.push_back(m_copies.back().get());
+    }
+
+    m_current_events.assign(threads, NO_EVENT);
+    m_team.reset(new ThreadTeam(threads));
+}
+
+Scheduler::~Scheduler() = default;
+
+void Scheduler::computeWeights(size_t n_events, const LorentzVector* p4, const int64_t* types,
+                               const LorentzVector* met, double* values, double* errors,
+                               MoMEMta::IntegrationStatus* status, double* times) {
+
+    m_n_events = n_events;
+    m_p4 = p4;
+    m_types = types;
+    m_met = met;
+    m_values = values;
+    m_errors = errors;
+    m_status = status;
+    m_times = times;
+
+    m_next_event = 0;
+    m_finished_events = 0;
+    m_exception = nullptr;
+
+    // Give enough points to each call of the integrand to keep all the workers busy
+    for (size_t lane = 0; lane < m_engines.size(); lane++) {
+        MoMEMta& engine = *m_engines[lane];
+        engine.m_points_per_call = m_chunk_size * m_engines.size();
+        engine.m_points_evaluator = [this, lane](const double* points, double* results, const double* weights,
+                                                 size_t n) {
+            Batch batch;
+            batch.event = m_current_events[lane];
+            batch.points = points;
+            batch.results = results;
+            batch.weights = weights;
+            batch.n_points = n;
+            batch.n_chunks = (n + m_chunk_size - 1) / m_chunk_size;
+            batch.next_chunk = 0;
+            batch.done_chunks = 0;
+            batch.status = CUBA_OK;
+
+            return evaluate(lane, batch);
+        };
+    }
+
+    // Global to cuba: set before the workers start, instead of by each integration
+    cubacores(0, m_engines.front()->m_cuba_configuration.get<int64_t>("pcores", 1000000));
+
+    m_team->run([this](size_t lane) { work(lane); });
+
+    for (auto* engine: m_engines) {
+        engine->m_points_per_call = 1;
+        engine->m_points_evaluator = nullptr;
+    }
+
+    if (m_exception)
+        std::rethrow_exception(m_exception);
+}
+
+void Scheduler::work(size_t lane) {
+
+    // Event-level tasks first
+    while (true) {
+        size_t event;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_exception || m_next_event == m_n_events)
+                break;
+
+            event = m_next_event++;
+        }
+
+        integrate(lane, event);
+    }
+
+    // No event left to start: help the workers still integrating
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_changed.wait(lock, [this]() { return !m_batches.empty() || m_finished_events == m_next_event; });
+        if (m_batches.empty())
+            break;
+
+        // Steal from the batch with the most work left
+        Batch* batch = *std::max_element(m_batches.begin(), m_batches.end(), [](const Batch* a, const Batch* b) {
+                return a->n_chunks - a->next_chunk < b->n_chunks - b->next_chunk;
+            });
+
+        size_t chunk;
+        takeChunk(*batch, chunk);
+
+        lock.unlock();
+        evaluateChunk(lane, *batch, chunk);
+        lock.lock();
+    }
+    lock.unlock();
+
+    release(lane);
+}
+
+void Scheduler::integrate(size_t lane, size_t event) {
+    MoMEMta& engine = *m_engines[lane];
+
+    release(lane);
+    m_current_events[lane] = event;
+
+    const size_t n_inputs = engine.getNumberOfInputs();
+    const size_t n_components = engine.getNumberOfComponents();
+
+    std::vector<double> values(n_components);
+    std::vector<double> errors(n_components);
+    auto start = std::chrono::steady_clock::now();
+    try {
+        engine.computeWeights(m_p4 + event * n_inputs, m_types ? m_types + event * n_inputs : nullptr,
+                              m_met ? m_met[event] : LorentzVector(), values.data(), errors.data());
+
+        for (size_t i = 0; i < n_components; i++) {
+            m_values[i * m_n_events + event] = values[i];
+            m_errors[i * m_n_events + event] = errors[i];
+        }
+
+        if (m_status)
+            m_status[event] = engine.getIntegrationStatus();
+
+        if (m_times)
+            m_times[event] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_exception)
+            m_exception = std::current_exception();
+    }
+
+    // Modules were already notified of the end of the integration by the instance
+    m_current_events[lane] = NO_EVENT;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished_events++;
+    }
+    m_changed.notify_all();
+}
+
+int Scheduler::evaluate(size_t lane, Batch& batch) {
+
+    if (batch.n_chunks > 1) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_batches.push_back(&batch);
+        }
+        m_changed.notify_all();
+    }
+
+    while (true) {
+        size_t chunk;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!takeChunk(batch, chunk))
+                break;
+        }
+
+        evaluateChunk(lane, batch, chunk);
+    }
+
+    // Wait for the chunks stolen by other workers
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_changed.wait(lock, [&batch]() { return batch.done_chunks == batch.n_chunks; });
+
+    return batch.status;
+}
+
+bool Scheduler::takeChunk(Batch& batch, size_t& chunk) {
+    if (batch.next_chunk == batch.n_chunks)
+        return false;
+
+    chunk = batch.next_chunk++;
+
+    if (batch.next_chunk == batch.n_chunks) {
+        auto it = std::find(m_batches.begin(), m_batches.end(), &batch);
+        if (it != m_batches.end())
+            m_batches.erase(it);
+    }
+
+    return true;
+}
+
+void Scheduler::evaluateChunk(size_t lane, Batch& batch, size_t chunk) {
+    MoMEMta& engine = *m_engines[lane];
+
+    const size_t n_dimensions = engine.m_n_dimensions;
+    const size_t n_components = engine.m_n_components;
+
+    const size_t begin = chunk * m_chunk_size;
+    const size_t end = std::min(begin + m_chunk_size, batch.n_points);
+
+    int status = CUBA_OK;
+    try {
+        prepare(lane, batch.event);
+
+        for (size_t i = begin; i < end && status == CUBA_OK; i++) {
+            status = engine.evaluate(batch.points + i * n_dimensions, batch.results + i * n_components,
+                                     batch.weights ? batch.weights + i : nullptr);
+        }
+    } catch (...) {
+        status = CUBA_ABORT;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_exception)
+            m_exception = std::current_exception();
+    }
+
+    bool done;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (status != CUBA_OK)
+            batch.status = status;
+
+        done = (++batch.done_chunks == batch.n_chunks);
+    }
+
+    if (done)
+        m_changed.notify_all();
+}
+
+void Scheduler::prepare(size_t lane, size_t event) {
+    if (m_current_events[lane] == event)
+        return;
+
+    release(lane);
+
+    MoMEMta& engine = *m_engines[lane];
+    const size_t n_inputs = engine.getNumberOfInputs();
+    engine.setInputs(m_p4 + event * n_inputs, m_types ? m_types + event * n_inputs : nullptr,
+                     m_met ? m_met[event] : LorentzVector());
+
+    for (const auto& module: engine.m_modules)
+        module->beginIntegration();
+
+    m_current_events[lane] = event;
+}
+
+void Scheduler::release(size_t lane) {
+    if (m_current_events[lane] == NO_EVENT)
+        return;
+
+    for (const auto& module: m_engines[lane]->m_modules)
+        module->endIntegration();
+
+    m_current_events[lane] = NO_EVENT;
+}
+
+}
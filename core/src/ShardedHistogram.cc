@@ -0,0 +1,119 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <ShardedHistogram.h>
+
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/mman.h>
+
+namespace {
+constexpr size_t CACHE_LINE_SIZE = 64;
+}
+
+ShardedHistogram::ShardedHistogram(size_t n_histograms, size_t n_bins, double min, double max, size_t n_shards):
+        m_axis(n_bins, min, max), m_n_histograms(n_histograms), m_n_shards(n_shards) {
+
+    static_assert(sizeof(std::atomic<double>) == sizeof(double), "Atomic doubles must have the layout of doubles");
+    static_assert(sizeof(std::atomic<pid_t>) == sizeof(pid_t), "Atomic pids must have the layout of pids");
+
+    if (n_histograms == 0 || n_shards == 0)
+        throw std::invalid_argument("At least one histogram and one shard are needed");
+
+    const size_t doubles_per_line = CACHE_LINE_SIZE / sizeof(double);
+    m_histogram_size = 2 * (n_bins + 2) + 1;
+    m_shard_size = ((n_histograms * m_histogram_size + doubles_per_line - 1) / doubles_per_line) * doubles_per_line;
+
+    const size_t owners_size = ((n_shards * sizeof(pid_t) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE;
+    m_memory_size = owners_size + n_shards * m_shard_size * sizeof(double);
+
+    // Anonymous shared mapping: inherited by forked processes, and filled with zeros
+    m_memory = mmap(nullptr, m_memory_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (m_memory == MAP_FAILED) {
+        m_memory = nullptr;
+        throw std::system_error(errno, std::system_category(), "Cannot allocate shared memory for histograms");
+    }
+
+    m_owners = static_cast<std::atomic<pid_t>*>(m_memory);
+    m_shards = reinterpret_cast<std::atomic<double>*>(static_cast<char*>(m_memory) + owners_size);
+}
+
+ShardedHistogram::~ShardedHistogram() {
+    if (m_memory)
+        munmap(m_memory, m_memory_size);
+}
+
+void ShardedHistogram::claim(pid_t pid) {
+    m_shard_pid = pid;
+
+    for (size_t i = 0; i < m_n_shards; i++) {
+        pid_t owner = 0;
+        if (m_owners[i].compare_exchange_strong(owner, pid) || owner == pid) {
+            m_shard = m_shards + i * m_shard_size;
+            return;
+        }
+    }
+
+    // All the shards are taken: share one of them
+    m_shard = m_shards + (pid % m_n_shards) * m_shard_size;
+}
+
+void ShardedHistogram::absorb(ShardedHistogram& other) {
+    if (other.m_n_histograms != m_n_histograms || other.m_histogram_size != m_histogram_size)
+        throw std::invalid_argument("Cannot absorb an accumulator with a different layout");
+
+    // Nothing was filled by this process
+    if (other.m_shard_pid != getpid())
+        return;
+
+    std::atomic<double>* from = other.m_shard;
+    std::atomic<double>* to = shard();
+    for (size_t i = 0; i < m_n_histograms * m_histogram_size; i++) {
+        const double value = from[i].exchange(0., std::memory_order_relaxed);
+        if (value != 0)
+            add(to[i], value);
+    }
+}
+
+void ShardedHistogram::reset() {
+    for (size_t i = 0; i < m_n_shards; i++)
+        m_owners[i] = 0;
+
+    for (size_t i = 0; i < m_n_shards * m_shard_size; i++)
+        m_shards[i].store(0., std::memory_order_relaxed);
+
+    m_shard_pid = 0;
+    m_shard = nullptr;
+}
+
+momemta::Histogram ShardedHistogram::merge(size_t histogram) const {
+    momemta::Histogram result(m_axis.nBins(), m_axis.min(), m_axis.max());
+
+    // Always sum the shards in the same order
+    for (size_t s = 0; s < m_n_shards; s++) {
+        const std::atomic<double>* bins = m_shards + s * m_shard_size + histogram * m_histogram_size;
+        for (size_t bin = 0; bin < m_axis.nBins() + 2; bin++)
+            result.add(bin, bins[2 * bin].load(std::memory_order_relaxed), bins[2 * bin + 1].load(std::memory_order_relaxed));
+        result.addEntries(bins[m_histogram_size - 1].load(std::memory_order_relaxed));
+    }
+
+    return result;
+}
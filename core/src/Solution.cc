@@ -18,7 +18,11 @@
 
 #include <momemta/Solution.h>
 
-std::ostream& operator<<(std::ostream& stream, const Solution& solution) {
+#include <algorithm>
+
+namespace {
+template <typename T>
+void print(std::ostream& stream, const T& solution) {
     size_t index = 1;
     for (const auto& p: solution.values) {
         stream << "{p" << index << ": " << p;
@@ -28,6 +32,56 @@ std::ostream& operator<<(std::ostream& stream, const Solution& solution) {
         index++;
     }
     stream << "; jacobian: " << solution.jacobian << "}";
+}
+}
+
+std::ostream& operator<<(std::ostream& stream, const Solution& solution) {
+    print(stream, solution);
+    return stream;
+}
 
+std::ostream& operator<<(std::ostream& stream, const SolutionCollection::View& solution) {
+    print(stream, solution);
     return stream;
 }
+
+std::ostream& operator<<(std::ostream& stream, const SolutionCollection& solutions) {
+    stream << "{";
+    for (size_t i = 0; i < solutions.size(); i++) {
+        stream << solutions[i];
+        if (i + 1 != solutions.size())
+            stream << ", ";
+    }
+    stream << "}";
+
+    return stream;
+}
+
+void SolutionCollection::reserve(size_t max_solutions, size_t n_particles) {
+    m_size = 0;
+    m_n_particles = n_particles;
+
+    m_values.resize(max_solutions * n_particles);
+    m_jacobians.resize(max_solutions);
+    m_valid.resize(max_solutions);
+}
+
+void SolutionCollection::push_back(const LorentzVector* values, size_t n_particles, double jacobian, bool valid) {
+    if (m_size == 0 && capacity() == 0)
+        m_n_particles = n_particles;
+
+    if (n_particles != m_n_particles)
+        throw std::invalid_argument("All the solutions of a collection must have the same number of particles");
+
+    if (m_size == capacity()) {
+        const size_t new_capacity = std::max<size_t>(2 * capacity(), 1);
+        m_values.resize(new_capacity * m_n_particles);
+        m_jacobians.resize(new_capacity);
+        m_valid.resize(new_capacity);
+    }
+
+    std::copy(values, values + n_particles, m_values.begin() + m_size * m_n_particles);
+    m_jacobians[m_size] = jacobian;
+    m_valid[m_size] = valid;
+    m_size++;
+}
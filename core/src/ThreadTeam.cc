@@ -0,0 +1,87 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ThreadTeam.h>
+
+ThreadTeam::ThreadTeam(size_t size) {
+    for (size_t lane = 1; lane < size; lane++)
+        m_threads.emplace_back(&ThreadTeam::loop, this, lane);
+}
+
+ThreadTeam::~ThreadTeam() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+
+    for (auto& thread: m_threads)
+        thread.join();
+}
+
+void ThreadTeam::run(const Job& job) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_pending = m_threads.size();
+        m_exception = nullptr;
+        m_generation++;
+    }
+    m_start.notify_all();
+
+    execute(job, 0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_pending == 0; });
+    m_job = nullptr;
+
+    if (m_exception)
+        std::rethrow_exception(m_exception);
+}
+
+void ThreadTeam::loop(size_t lane) {
+    size_t generation = 0;
+    while (true) {
+        const Job* job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [this, generation]() { return m_stop || m_generation != generation; });
+            if (m_stop)
+                return;
+
+            generation = m_generation;
+            job = m_job;
+        }
+
+        execute(*job, lane);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pending == 0)
+            m_done.notify_one();
+    }
+}
+
+void ThreadTeam::execute(const Job& job, size_t lane) {
+    try {
+        job(lane);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_exception)
+            m_exception = std::current_exception();
+    }
+}
@@ -81,14 +81,16 @@ const std::vector<logger::sink_ptr>& logger::logger::sinks() const {
 }
 
 ::logger::ostream_wrapper::ostream_wrapper(::logger::logger& l, logging::level::level_enum lvl):
-        _valid(true),
+        _valid(l.should_log(lvl)),
+        _enabled(_valid),
         _logger(l),
         _lvl(lvl) {
     // Empty
 }
 
 ::logger::ostream_wrapper::~ostream_wrapper() {
-    _logger.log(_lvl, _stream.str());
+    if (_enabled)
+        _logger.log(_lvl, _stream.str());
     _valid = false;
 }
 
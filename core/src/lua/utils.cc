@@ -26,6 +26,7 @@
 #include <momemta/ModuleFactory.h>
 #include <momemta/ParameterSet.h>
 #include <momemta/Utils.h>
+#include <momemta/config.h>
 
 #include <LibraryManager.h>
 #include <lua/ParameterSetParser.h>
@@ -41,9 +42,19 @@ namespace lua {
         this->L = L;
     }
 
+    /// Name of the registry table mapping the functions created by `parameter()` to the name of the parameter
+    const char* const PARAMETER_FUNCTIONS = "momemta_parameter_functions";
+
     LazyFunction::LazyFunction(lua_State* L, int index): Lazy(L) {
         auto absolute_index = get_index(L, index);
 
+        // Check if the function was created by `parameter()`
+        luaL_getsubtable(L, LUA_REGISTRYINDEX, PARAMETER_FUNCTIONS);
+        lua_pushvalue(L, absolute_index);
+        if (lua_gettable(L, -2) == LUA_TSTRING)
+            parameter = lua_tostring(L, -1);
+        lua_pop(L, 2);
+
         // Duplicate the function on the top of the stack. This ensure the stack size won't change
         lua_pushvalue(L, absolute_index);
 
@@ -407,7 +418,32 @@ namespace lua {
         const char *path = luaL_checkstring(L, 1);
         LibraryManager::get().registerLibrary(path);
 
+        ILuaCallback* callback = static_cast<ILuaCallback*>(cfg_ptr);
+        callback->onLibraryLoaded(path);
+
+        register_modules(L, cfg_ptr);
+
+        return 0;
+    }
+
+    int load_root_plugin(lua_State* L) {
+        int n = lua_gettop(L);
+        if (n != 0) {
+            luaL_error(L, "invalid number of arguments: 0 expected, got %d", n);
+        }
+
+#ifdef ROOT_FREE_CORE
+        void* cfg_ptr = lua_touserdata(L, lua_upvalueindex(1));
+
+        if (!LibraryManager::get().loadROOTPlugin()) {
+            luaL_error(L, "failed to load the ROOT plugin");
+        }
+
+        ILuaCallback* callback = static_cast<ILuaCallback*>(cfg_ptr);
+        callback->onLibraryLoaded(ROOT_PLUGIN_NAME);
+
         register_modules(L, cfg_ptr);
+#endif
 
         return 0;
     }
@@ -426,6 +462,13 @@ namespace lua {
         std::string code = "return function() return parameters['" + parameter_name + "'] end";
         luaL_dostring(L, code.c_str());
 
+        // Remember which parameter the function returns, see LazyFunction::parameter
+        luaL_getsubtable(L, LUA_REGISTRYINDEX, PARAMETER_FUNCTIONS);
+        lua_pushvalue(L, -2);
+        lua_pushstring(L, parameter_name.c_str());
+        lua_settable(L, -3);
+        lua_pop(L, 1);
+
         return 1;
     }
 
@@ -503,6 +546,10 @@ namespace lua {
         lua_pushcclosure(L, load_modules, 1);
         lua_setglobal(L, "load_modules");
 
+        lua_pushlightuserdata(L, ptr);
+        lua_pushcclosure(L, load_root_plugin, 1);
+        lua_setglobal(L, "load_root_plugin");
+
         lua_pushlightuserdata(L, ptr);
         lua_pushcclosure(L, parameter, 1);
         lua_setglobal(L, "parameter");
@@ -144,6 +144,7 @@ struct convert_py_root_to_cpp_root {
 #endif
 
 // Overloads for MoMEMta::computeWeights
+using ComputeWeightsFromParticles = std::vector<std::pair<double, double>> (MoMEMta::*)(const std::vector<Particle>&, const LorentzVector&);
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(MoMEMta_computeWeights_overloads, MoMEMta::computeWeights, 1, 2)
 
 BOOST_PYTHON_MODULE(momemta) {
@@ -208,10 +209,10 @@ BOOST_PYTHON_MODULE(momemta) {
             .add_property("p4", make_getter(&Particle::p4, return_value_policy<return_by_value>()), &Particle::p4)
             .def_readwrite("type", &Particle::type);
 
-    class_<MoMEMta>("MoMEMta", init<Configuration>())
+    class_<MoMEMta, boost::noncopyable>("MoMEMta", init<Configuration>())
             .def("getIntegrationStatus", &MoMEMta::getIntegrationStatus)
             //.def("getPool", &MoMEMta::getPool, return_value_policy<copy_const_reference>())
             .def("computeWeights", MoMEMta_computeWeights)
             .def("computeWeights", MoMEMta_computeWeights_MET)
-            .def("computeWeights", &MoMEMta::computeWeights, MoMEMta_computeWeights_overloads());
+            .def("computeWeights", static_cast<ComputeWeightsFromParticles>(&MoMEMta::computeWeights), MoMEMta_computeWeights_overloads());
 }
@@ -1,5 +1,8 @@
 -- Note: USE_PERM and USE_TF are defined in the C++ code and injected in lua before parsing this file
 
+-- DMEM depends on ROOT: make it available when MoMEMta is built with ROOT_FREE_CORE
+load_root_plugin()
+
 -- Register inputs
 local electron = declare_input("electron")
 local muon = declare_input("muon")
@@ -0,0 +1,163 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace momemta {
+
+/**
+ * \brief Monotonic memory arena, reset for each phase-space point
+ *
+ * Memory is handed out by bumping a pointer inside large blocks, and is never freed individually: reset() makes the
+ * whole arena available again, keeping the blocks. Once the blocks are large enough to hold what is needed for one
+ * phase-space point (usually after the first point), allocating from the arena never calls `malloc`.
+ *
+ * The arena of the memory pool is reset by MoMEMta at the beginning of each phase-space point: modules can use it for
+ * the temporary containers needed during Module::work() (see Module::allocator()), but nothing allocated from it may
+ * be kept from one point to the next.
+ *
+ * Blocks can optionally be backed by huge pages, reducing TLB misses when the per-point memory is large. Explicit huge
+ * pages (`MAP_HUGETLB`) are used if the system provides some, transparent huge pages otherwise.
+ */
+class Arena {
+public:
+    /**
+     * \brief Create an empty arena
+     *
+     * \param block_size Minimal size of the blocks, in bytes
+     * \param huge_pages If true, back the blocks with huge pages when the system supports them
+     */
+    explicit Arena(size_t block_size = 1 << 20, bool huge_pages = false);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /// Allocate \p size bytes, aligned on \p alignment (a power of two)
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+        if (m_current < m_blocks.size()) {
+            // Align the address itself: blocks are only guaranteed to be aligned for std::max_align_t
+            const uintptr_t base = reinterpret_cast<uintptr_t>(m_blocks[m_current].data);
+            const size_t offset = ((base + m_offset + alignment - 1) & ~(uintptr_t(alignment) - 1)) - base;
+            if (offset + size > m_blocks[m_current].size)
+                return allocateSlow(size, alignment);
+
+            m_offset = offset + size;
+            m_used += size;
+            m_allocations++;
+            return m_blocks[m_current].data + offset;
+        }
+
+        return allocateSlow(size, alignment);
+    }
+
+    /// Make all the memory available again. Everything allocated before is invalidated.
+    void reset();
+
+    size_t blockSize() const { return m_block_size; }
+    bool hugePages() const { return m_huge_pages; }
+
+    /// \return The number of bytes allocated since the last reset
+    size_t used() const { return m_used; }
+
+    /// \return The largest number of bytes allocated between two resets
+    size_t peakUsage() const;
+
+    /// \return The number of allocations since the arena creation
+    size_t allocations() const { return m_allocations; }
+
+    /// \return The number of blocks requested from the system since the arena creation
+    size_t systemAllocations() const { return m_blocks.size(); }
+
+    /// \return The total size of the blocks, in bytes
+    size_t capacity() const;
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+        bool mapped; ///< True if allocated using `mmap`
+    };
+
+    void* allocateSlow(size_t size, size_t alignment);
+    Block newBlock(size_t size);
+
+    size_t m_block_size;
+    bool m_huge_pages;
+
+    std::vector<Block> m_blocks;
+    size_t m_current = 0; ///< Index of the block currently used
+    size_t m_offset = 0; ///< Offset of the first free byte in the current block
+
+    size_t m_used = 0;
+    size_t m_peak = 0;
+    size_t m_allocations = 0;
+};
+
+/**
+ * \brief Standard allocator handing out memory from an Arena
+ *
+ * Deallocation is a no-op: memory is only reclaimed when the arena is reset. Containers using this allocator must thus
+ * not outlive the current phase-space point.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(Arena& arena): m_arena(&arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other): m_arena(other.arena()) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) {
+        // Memory is reclaimed when the arena is reset
+    }
+
+    Arena* arena() const {
+        return m_arena;
+    }
+
+private:
+    Arena* m_arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return !(a == b);
+}
+
+/// A `std::vector` allocated from an Arena
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}
@@ -0,0 +1,229 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+class TH2;
+
+namespace momemta {
+
+/**
+ * \brief Flat, read-only 2D lookup table
+ *
+ * Contiguous copy of the content of a 2D histogram, including underflow and overflow bins.
+ * Bins are numbered as in ROOT: bin 0 is the underflow, bins 1 to N the regular bins and bin N + 1 the
+ * overflow, and the global bin number is \f$ b_x + (N_x + 2) b_y \f$. Looking up a value is thus
+ * equivalent to `TH2::GetBinContent(TH2::FindFixBin(x, y))`, without any virtual call.
+ *
+ * Tables are cheap to copy: the bin contents are shared between copies.
+ *
+ * ### Native file format
+ *
+ * Tables can be saved in a native binary format (see save()), designed to be loaded using `mmap`: the bin contents
+ * are used directly from the mapped memory, so all the tables loaded from the same file share a single read-only
+ * copy, which is also shared between processes through the page cache. A file can hold several tables, identified
+ * by their name. The format, using the native byte order, is:
+ *   - a file header: `char magic[8]`, `uint32_t version`, `uint32_t byte_order`, `uint64_t n_tables`
+ *   - one table header per table: `char name[64]`, `uint64_t n_bins[2]`, `uint64_t variable[2]`, `double min[2]`,
+ *     `double max[2]`, `uint64_t offset`
+ *   - for each table, starting at `offset` bytes from the beginning of the file: the edges of the variable axes (x
+ *     first), followed by the \f$ (N_x + 2)(N_y + 2) \f$ bin contents.
+ *
+ * Use the `momemta-convert-tf` tool to convert the TH2s of a ROOT file into this format.
+ */
+class BinnedTable2D {
+public:
+    /**
+     * \brief Binning of one dimension of the table
+     *
+     * Bins are either uniform, in which case the bin is computed directly, or defined by arbitrary
+     * edges, in which case a binary search is used. In both cases, bins are found exactly as
+     * `TAxis::FindFixBin` does, including for values on the bin edges.
+     */
+    class Axis {
+    public:
+        /// Uniform binning of \p n_bins bins between \p min and \p max
+        Axis(size_t n_bins, double min, double max);
+
+        /// Variable binning. \p edges contains the \f$ N + 1 \f$ bin edges, in increasing order.
+        explicit Axis(const std::vector<double>& edges);
+
+        /**
+         * \brief Find the bin containing \p x
+         *
+         * \return 0 if \p x is below the axis range, \f$ N + 1 \f$ if above, the bin number otherwise
+         */
+        size_t findBin(double x) const {
+            if (x < m_min)
+                return 0;
+
+            if (!(x < m_max))
+                return m_n_bins + 1;
+
+            // Same operations as ROOT, so that rounding at the bin edges gives the same bin
+            if (m_uniform)
+                return 1 + static_cast<size_t>(m_n_bins * (x - m_min) / (m_max - m_min));
+
+            return std::upper_bound(m_edges.begin(), m_edges.end(), x) - m_edges.begin();
+        }
+
+        size_t nBins() const { return m_n_bins; }
+        double min() const { return m_min; }
+        double max() const { return m_max; }
+        bool isUniform() const { return m_uniform; }
+
+        /// \return The lower edge of bin \p bin (1 <= \p bin <= N + 1)
+        double lowEdge(size_t bin) const {
+            return m_uniform ? m_min + (bin - 1) * m_width : m_edges[bin - 1];
+        }
+
+        /// \return The upper edge of bin \p bin (1 <= \p bin <= N)
+        double upEdge(size_t bin) const {
+            return lowEdge(bin + 1);
+        }
+
+        /// \return The center of bin \p bin (1 <= \p bin <= N)
+        double binCenter(size_t bin) const {
+            return (lowEdge(bin) + upEdge(bin)) / 2.;
+        }
+
+    private:
+        size_t m_n_bins;
+        double m_min;
+        double m_max;
+        bool m_uniform;
+        double m_width; ///< Width of the bins, for uniform binning
+        std::vector<double> m_edges; ///< Bins edges, for variable binning
+    };
+
+    /**
+     * \brief Create a table
+     *
+     * \param x, y Binning of the table
+     * \param contents Content of each bin, indexed by the global bin number. The size must be \f$ (N_x + 2)(N_y + 2) \f$.
+     */
+    BinnedTable2D(const Axis& x, const Axis& y, const std::vector<double>& contents);
+
+    /**
+     * \brief Load a table from a file
+     *
+     * The file can either be in the native format, in which case it's mapped in memory, or a ROOT file,
+     * in which case the TH2 named \p name is converted into a table. Tables are cached: loading several
+     * times the same table returns the same instance as long as it is in use.
+     *
+     * \param path Path of the file
+     * \param name Name of the table (or of the TH2 for ROOT files)
+     */
+    static std::shared_ptr<const BinnedTable2D> load(const std::string& path, const std::string& name);
+
+    /// Load table \p name from a file which is not in the native format
+    using Loader = std::function<std::shared_ptr<const BinnedTable2D>(const std::string& path, const std::string& name)>;
+
+    /**
+     * \brief Set the loader used by load() for files not in the native format
+     *
+     * The ROOT support of MoMEMta registers a loader reading the TH2s of ROOT files. When MoMEMta is built with the
+     * `ROOT_FREE_CORE` option, this support lives in the ROOT plugin, which is loaded the first time a file not in
+     * the native format is requested.
+     */
+    static void setFallbackLoader(const Loader& loader);
+
+    /**
+     * \brief Save tables using the native file format
+     *
+     * \param path Path of the output file
+     * \param tables Tables to save, along with their name (at most 63 characters)
+     */
+    static void save(const std::string& path, const std::vector<std::pair<std::string, const BinnedTable2D*>>& tables);
+
+    /// \return The global bin number of the bin containing (\p x, \p y)
+    size_t findBin(double x, double y) const {
+        return m_x.findBin(x) + m_stride * m_y.findBin(y);
+    }
+
+    /// \return The content of the global bin \p bin
+    double binContent(size_t bin) const {
+        return m_contents[bin];
+    }
+
+    /// \return The content of the bin containing (\p x, \p y)
+    double operator()(double x, double y) const {
+        return m_contents[findBin(x, y)];
+    }
+
+    /**
+     * \brief Evaluate the table on a batch of points
+     *
+     * \param x, y Coordinates of the \p n points
+     * \param[out] out Content of the bin containing each point
+     */
+    void evaluate(const double* x, const double* y, double* out, size_t n) const;
+
+    const Axis& xAxis() const { return m_x; }
+    const Axis& yAxis() const { return m_y; }
+
+    /// \return The number of bins, including underflow and overflow
+    size_t size() const {
+        return m_stride * (m_y.nBins() + 2);
+    }
+
+    class file_not_found_error: public std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    class table_not_found_error: public std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    class invalid_file_error: public std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+private:
+    /// Create a table viewing \p contents, whose lifetime is bound to \p storage
+    BinnedTable2D(const Axis& x, const Axis& y, const double* contents, std::shared_ptr<const void> storage);
+
+    static std::shared_ptr<const BinnedTable2D> loadNative(const std::string& path, const std::string& name);
+
+    Axis m_x;
+    Axis m_y;
+    size_t m_stride;
+
+    std::shared_ptr<const void> m_storage; ///< Memory holding the bin contents
+    const double* m_contents;
+};
+
+/**
+ * \brief Convert a ROOT 2D histogram into a flat table
+ *
+ * Both uniform and variable binnings are supported. Underflow and overflow bins are copied as well.
+ *
+ * \note Part of the ROOT plugin when MoMEMta is built with the `ROOT_FREE_CORE` option.
+ */
+BinnedTable2D toBinnedTable(const TH2& th2);
+
+}
@@ -0,0 +1,90 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <momemta/BinnedTable2D.h>
+
+namespace momemta {
+
+/**
+ * \brief Sample the Y coordinate of a BinnedTable2D following its content
+ *
+ * The cumulative distribution along the Y axis is precomputed for each regular bin of the X axis (each column of the
+ * table), assuming the content of each bin is a constant density. Negative bin contents are treated as 0.
+ *
+ * sample() inverts this cumulative distribution, restricted to a sub-range of the Y axis and mixed with a uniform
+ * distribution over this sub-range: the uniform component ensures that every point of the sub-range can be sampled,
+ * even where the column used for sampling is empty. The mixture is still piecewise linear, so the inversion is exact
+ * and only costs a binary search on the bins of the column.
+ */
+class BinnedTableSampler {
+public:
+    /// Precompute the cumulative distributions of all the columns of \p table
+    explicit BinnedTableSampler(std::shared_ptr<const BinnedTable2D> table);
+
+    /// \return The regular bin (between 1 and \f$ N_x \f$) of the column closest to \p x
+    size_t column(double x) const {
+        const auto& axis = m_table->xAxis();
+        size_t bin = axis.findBin(x);
+        return std::min(std::max<size_t>(bin, 1), axis.nBins());
+    }
+
+    /// \return The integral of column \p column between the lower edge of the Y axis and \p y
+    double cumulative(size_t column, double y) const;
+
+    /**
+     * \brief Map a number in \f$ [0, 1] \f$ onto \f$ [y_{min}, y_{max}] \f$
+     *
+     * The number is mapped through the inverse of the cumulative distribution
+     * \f$ F(y) = (1 - \alpha) \frac{C(y) - C(y_{min})}{C(y_{max}) - C(y_{min})} + \alpha \frac{y - y_{min}}{y_{max} - y_{min}} \f$
+     * where \f$ C \f$ is the cumulative distribution of column \p column and \f$ \alpha \f$ the fraction of uniform
+     * sampling. If the column is empty over the range, the sampling is uniform.
+     *
+     * \param column Column used for the sampling, see column()
+     * \param y_min, y_max Range of the sampling, included in the Y axis range, with \f$ y_{min} < y_{max} \f$
+     * \param uniform_fraction Fraction \f$ \alpha \f$ of uniform sampling, between 0 and 1. With \f$ \alpha = 0 \f$,
+     *        the bins of the column which are empty are never sampled.
+     * \param u Number to map
+     * \param[out] density Probability density of the returned value, i.e. the inverse of the jacobian of the mapping.
+     *        It can be zero at the edges of the empty regions when \f$ \alpha = 0 \f$.
+     *
+     * \return The sampled value
+     */
+    double sample(size_t column, double y_min, double y_max, double uniform_fraction, double u, double& density) const;
+
+private:
+    size_t yBin(double y) const {
+        const auto& axis = m_table->yAxis();
+        return std::min(std::max<size_t>(axis.findBin(y), 1), axis.nBins());
+    }
+
+    std::shared_ptr<const BinnedTable2D> m_table;
+
+    /// Density in each regular bin, column after column
+    std::vector<double> m_density;
+    /// Cumulative distribution at each edge of the Y axis (\f$ N_y + 1 \f$ values), column after column
+    std::vector<double> m_cumulative;
+};
+
+}
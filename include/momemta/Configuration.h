@@ -18,7 +18,9 @@
 
 #pragma once
 
+#include <iosfwd>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -32,6 +34,12 @@ struct PathElements;
  * \brief A frozen snapshot of the configuration file.
  *
  * All the parameters are enforced to be static (ie, all lua::Lazy parameters are evaluated)
+ *
+ * ### Binary format
+ *
+ * A frozen configuration can be saved in a compact binary format (see save()) and loaded back without any lua
+ * interpreter (see load()). The format uses the native byte order and is not meant to be portable: it's a cache, see
+ * ConfigurationReader::readCached().
  */
 class Configuration {
     public:
@@ -83,6 +91,28 @@ class Configuration {
 
         Configuration& operator=(Configuration);
 
+        /**
+         * \brief Save the configuration in the binary format
+         *
+         * Shared libraries loaded by the configuration file using `load_modules` are saved by path, and loaded again
+         * by load(): relative paths are thus resolved against the working directory of the process loading the file.
+         *
+         * \param path Path of the output file
+         */
+        void save(const std::string& path) const;
+
+        /**
+         * \brief Load a configuration saved with save()
+         *
+         * \param path Path of the file
+         * \return The frozen configuration
+         */
+        static Configuration load(const std::string& path);
+
+        class invalid_file_error: public std::runtime_error {
+            using std::runtime_error::runtime_error;
+        };
+
     private:
         friend class ConfigurationReader;
         Configuration(): n_dimensions(0) {};
@@ -90,11 +120,21 @@ class Configuration {
         /// Return a frozen copy of this configuration
         Configuration freeze() const;
 
+        void save(std::ostream& stream) const;
+        static Configuration load(std::istream& stream);
+
+        static void saveParameterSet(std::ostream& stream, const ParameterSet& set,
+                                     const std::vector<PathElements*>& paths);
+        static void loadParameterSet(std::istream& stream, ParameterSet& set,
+                                     const std::vector<PathElements*>& paths);
+
         std::vector<Module> modules;
         std::shared_ptr<ParameterSet> global_parameters;
         std::shared_ptr<ParameterSet> cuba_configuration;
         std::vector<InputTag> integrands;
         std::vector<PathElements*> paths;
+        std::vector<std::shared_ptr<PathElements>> owned_paths; ///< Storage of the paths of a loaded configuration
         std::vector<std::string> inputs;
+        std::vector<std::string> libraries; ///< Shared libraries loaded by the configuration file
         std::size_t n_dimensions;
 };
@@ -52,6 +52,7 @@ class ConfigurationReader: public ILuaCallback {
         virtual void onNewPath(PathElements* path) override;
         virtual void addIntegrationDimension() override;
         virtual void onNewInputDeclared(const std::string& name) override;
+        virtual void onLibraryLoaded(const std::string& path) override;
 
         ParameterSet& getGlobalParameters();
         ParameterSet& getCubaConfiguration();
@@ -63,6 +64,28 @@ class ConfigurationReader: public ILuaCallback {
          */
         Configuration freeze() const;
 
+        /**
+         * \brief Read and freeze a configuration file, using a binary cache
+         *
+         * The frozen configuration is cached in \p cache_directory using the binary format of Configuration,
+         * under a name derived from a hash of the version of MoMEMta, of the names of the registered modules, of the
+         * content of \p file and of \p parameters. If the cache exists, the configuration is loaded from it, without
+         * starting any lua interpreter. Otherwise, the file is parsed as usual and the cache is created. Many jobs
+         * sharing the same configuration thus only parse it once (see the `--cache` option of `momemta-run`).
+         *
+         * \warning Only the content of \p file is hashed: changes to files it includes (using `dofile` for
+         * example), to the shared libraries it loads using `load_modules`, or lua code depending on the environment,
+         * do not invalidate the cache.
+         *
+         * \param file Path of the lua configuration file
+         * \param parameters Parameters injected into the lua runtime before parsing (see ConfigurationReader())
+         * \param cache_directory Directory holding the cache files. It must exist.
+         *
+         * \return The frozen configuration
+         */
+        static Configuration readCached(const std::string& file, const ParameterSet& parameters,
+                                        const std::string& cache_directory);
+
     private:
         friend class Configuration;
 
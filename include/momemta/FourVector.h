@@ -0,0 +1,300 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include <momemta/config.h>
+
+#ifndef ROOT_FREE_CORE
+#include <momemta/Types.h>
+#endif
+
+namespace momemta {
+
+/**
+ * \brief Lightweight four-momentum, in cartesian coordinates
+ *
+ * A plain, trivially copyable \f$ (p_x, p_y, p_z, E) \f$ vector, with the same accessors as LorentzVector so that it
+ * can be used with the same templated helpers (see for instance dP_over_dE()). Conversions from and to LorentzVector
+ * are exact, and are meant to happen at the boundary of modules: inputs are converted once, all the intermediate
+ * kinematics is done on this type, and outputs are converted back.
+ *
+ * Compared to LorentzVector, the kernels modifying a momentum (rescaling, boosts) work directly in cartesian
+ * coordinates, without going through angles: changing the energy of a particle while keeping its direction costs one
+ * square root, instead of computing \f$ \eta \f$ and \f$ \phi \f$ and their trigonometric functions.
+ *
+ * When MoMEMta is built with the `ROOT_FREE_CORE` option, LorentzVector is an alias of this type.
+ */
+class FourVector {
+public:
+    using Scalar = double;
+
+    FourVector() = default;
+
+    FourVector(double px, double py, double pz, double e):
+        m_px(px), m_py(py), m_pz(pz), m_e(e) {}
+
+#ifndef ROOT_FREE_CORE
+    explicit FourVector(const LorentzVector& v):
+        m_px(v.Px()), m_py(v.Py()), m_pz(v.Pz()), m_e(v.E()) {}
+
+    LorentzVector toLorentzVector() const {
+        return LorentzVector(m_px, m_py, m_pz, m_e);
+    }
+#else
+    const FourVector& toLorentzVector() const {
+        return *this;
+    }
+#endif
+
+    void SetPxPyPzE(double px, double py, double pz, double e) {
+        m_px = px;
+        m_py = py;
+        m_pz = pz;
+        m_e = e;
+    }
+
+    void SetXYZT(double x, double y, double z, double t) { SetPxPyPzE(x, y, z, t); }
+    void SetCoordinates(double x, double y, double z, double t) { SetPxPyPzE(x, y, z, t); }
+
+    double Px() const { return m_px; }
+    double Py() const { return m_py; }
+    double Pz() const { return m_pz; }
+    double E() const { return m_e; }
+
+    double X() const { return m_px; }
+    double Y() const { return m_py; }
+    double Z() const { return m_pz; }
+    double T() const { return m_e; }
+
+    double P2() const { return m_px * m_px + m_py * m_py + m_pz * m_pz; }
+    double P() const { return std::sqrt(P2()); }
+    double Pt2() const { return m_px * m_px + m_py * m_py; }
+    double Pt() const { return std::sqrt(Pt2()); }
+    double M2() const { return m_e * m_e - P2(); }
+
+    /// Invariant mass. As for LorentzVector, space-like vectors have a negative mass \f$ -\sqrt{-m^2} \f$.
+    double M() const {
+        const double m2 = M2();
+        return m2 < 0 ? -std::sqrt(-m2) : std::sqrt(m2);
+    }
+
+    double Phi() const { return (m_px == 0 && m_py == 0) ? 0 : std::atan2(m_py, m_px); }
+    double Theta() const { return (m_px == 0 && m_py == 0 && m_pz == 0) ? 0 : std::atan2(Pt(), m_pz); }
+
+    /// \return \f$ \cos\theta \f$, without any trigonometric function
+    double CosTheta() const {
+        const double p = P();
+        return p == 0 ? 1 : m_pz / p;
+    }
+
+    /// \return \f$ \sin\theta \f$, without any trigonometric function
+    double SinTheta() const {
+        const double p = P();
+        return p == 0 ? 0 : Pt() / p;
+    }
+
+    double Eta() const {
+        const double pt = Pt();
+        if (pt > 0)
+            return std::asinh(m_pz / pt);
+
+        // Along the beam axis, same conventions as LorentzVector
+        if (m_pz == 0)
+            return 0;
+
+        return m_pz > 0 ? m_pz + 22756. : m_pz - 22756.;
+    }
+
+    double Rapidity() const {
+        return 0.5 * std::log((m_e + m_pz) / (m_e - m_pz));
+    }
+
+    double Dot(const FourVector& other) const {
+        return m_e * other.m_e - m_px * other.m_px - m_py * other.m_py - m_pz * other.m_pz;
+    }
+
+    /**
+     * \brief Same direction, different momentum
+     *
+     * \param p New norm of the momentum
+     * \param e New energy
+     */
+    FourVector withMomentum(double p, double e) const {
+        const double norm = P();
+        const double scale = norm == 0 ? 0 : p / norm;
+        return {scale * m_px, scale * m_py, scale * m_pz, e};
+    }
+
+    /**
+     * \brief Same direction, different transverse momentum
+     *
+     * \param pt New transverse momentum
+     * \param e New energy
+     */
+    FourVector withPt(double pt, double e) const {
+        const double norm = Pt();
+        const double scale = norm == 0 ? 0 : pt / norm;
+        return {scale * m_px, scale * m_py, scale * m_pz, e};
+    }
+
+    /**
+     * \brief Apply a Lorentz boost of velocity \f$ \vec{\beta} = (b_x, b_y, b_z) \f$
+     *
+     * Same convention as `ROOT::Math::Boost`: boosting a vector at rest gives it a velocity \f$ \vec{\beta} \f$.
+     */
+    FourVector boosted(double bx, double by, double bz) const {
+        const double b2 = bx * bx + by * by + bz * bz;
+        const double gamma = 1. / std::sqrt(1. - b2);
+        const double bp = bx * m_px + by * m_py + bz * m_pz;
+        const double gamma2 = b2 > 0 ? (gamma - 1.) / b2 : 0.;
+        const double factor = gamma2 * bp + gamma * m_e;
+
+        return {m_px + factor * bx, m_py + factor * by, m_pz + factor * bz, gamma * (m_e + bp)};
+    }
+
+    FourVector& operator+=(const FourVector& other) {
+        m_px += other.m_px;
+        m_py += other.m_py;
+        m_pz += other.m_pz;
+        m_e += other.m_e;
+        return *this;
+    }
+
+    FourVector& operator-=(const FourVector& other) {
+        m_px -= other.m_px;
+        m_py -= other.m_py;
+        m_pz -= other.m_pz;
+        m_e -= other.m_e;
+        return *this;
+    }
+
+    FourVector& operator*=(double a) {
+        m_px *= a;
+        m_py *= a;
+        m_pz *= a;
+        m_e *= a;
+        return *this;
+    }
+
+    FourVector& operator/=(double a) {
+        return *this *= 1. / a;
+    }
+
+    FourVector operator-() const {
+        return {-m_px, -m_py, -m_pz, -m_e};
+    }
+
+    bool operator==(const FourVector& other) const {
+        return m_px == other.m_px && m_py == other.m_py && m_pz == other.m_pz && m_e == other.m_e;
+    }
+
+    bool operator!=(const FourVector& other) const {
+        return !(*this == other);
+    }
+
+private:
+    double m_px = 0;
+    double m_py = 0;
+    double m_pz = 0;
+    double m_e = 0;
+};
+
+inline FourVector operator+(FourVector a, const FourVector& b) { return a += b; }
+inline FourVector operator-(FourVector a, const FourVector& b) { return a -= b; }
+inline FourVector operator*(FourVector a, double s) { return a *= s; }
+inline FourVector operator*(double s, FourVector a) { return a *= s; }
+inline FourVector operator/(FourVector a, double s) { return a /= s; }
+
+/// Same format as LorentzVector: `(px,py,pz,E)`
+inline std::ostream& operator<<(std::ostream& stream, const FourVector& v) {
+    return stream << "(" << v.Px() << "," << v.Py() << "," << v.Pz() << "," << v.E() << ")";
+}
+
+/**
+ * \brief Structure-of-arrays batch of four-momenta
+ *
+ * Each component is stored in its own contiguous array, so that the kernels below, applied on all the vectors of the
+ * batch, are vectorized by the compiler.
+ */
+class FourVectorBatch {
+public:
+    FourVectorBatch() = default;
+    explicit FourVectorBatch(size_t size);
+
+    void reserve(size_t size);
+    void resize(size_t size);
+    void clear();
+
+    void push_back(const FourVector& v) {
+        m_px.push_back(v.Px());
+        m_py.push_back(v.Py());
+        m_pz.push_back(v.Pz());
+        m_e.push_back(v.E());
+    }
+
+    void set(size_t i, const FourVector& v) {
+        m_px[i] = v.Px();
+        m_py[i] = v.Py();
+        m_pz[i] = v.Pz();
+        m_e[i] = v.E();
+    }
+
+    FourVector operator[](size_t i) const {
+        return {m_px[i], m_py[i], m_pz[i], m_e[i]};
+    }
+
+    size_t size() const { return m_e.size(); }
+
+    const double* px() const { return m_px.data(); }
+    const double* py() const { return m_py.data(); }
+    const double* pz() const { return m_pz.data(); }
+    const double* e() const { return m_e.data(); }
+
+    /// Compute the invariant mass squared of each vector
+    void masses2(double* out) const;
+
+    /// Compute the invariant mass of each vector (negative for space-like vectors)
+    void masses(double* out) const;
+
+    /// Compute the transverse momentum of each vector
+    void pts(double* out) const;
+
+    /// Compute the norm of the momentum of each vector
+    void momenta(double* out) const;
+
+    /// Compute the invariant mass squared of the sum of each vector with the same vector of \p other
+    void pairMasses2(const FourVectorBatch& other, double* out) const;
+
+    /// Boost all the vectors (see FourVector::boosted())
+    void boost(double bx, double by, double bz);
+
+private:
+    std::vector<double> m_px;
+    std::vector<double> m_py;
+    std::vector<double> m_pz;
+    std::vector<double> m_e;
+};
+
+}
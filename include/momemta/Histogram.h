@@ -0,0 +1,110 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <momemta/BinnedTable2D.h>
+
+class TH1D;
+
+namespace momemta {
+
+/**
+ * \brief Lightweight 1D histogram
+ *
+ * Uniform binning, with underflow (bin 0) and overflow (bin N + 1) bins as in ROOT. For each bin, the sum of the
+ * weights and the sum of the squared weights are stored. Unlike a `TH1D`, filling a histogram never involves a virtual
+ * call nor any global state: a `TH1D` is only created on request, using toTH1D().
+ */
+class Histogram {
+public:
+    /// Create an empty histogram of \p n_bins uniform bins between \p min and \p max
+    Histogram(size_t n_bins, double min, double max);
+
+    void fill(double x, double weight = 1.) {
+        const size_t bin = m_axis.findBin(x);
+        m_sumw[bin] += weight;
+        m_sumw2[bin] += weight * weight;
+        m_entries++;
+    }
+
+    /// Add \p sumw and \p sumw2 to the content of bin \p bin
+    void add(size_t bin, double sumw, double sumw2) {
+        m_sumw[bin] += sumw;
+        m_sumw2[bin] += sumw2;
+    }
+
+    /**
+     * \brief Add the content of \p other to this histogram
+     *
+     * \throws std::invalid_argument if the binnings differ
+     */
+    Histogram& operator+=(const Histogram& other);
+
+    /// Add \p entries to the number of entries, without changing the content of the bins
+    void addEntries(double entries) {
+        m_entries += entries;
+    }
+
+    /// Set the content of all the bins, and the number of entries, to 0
+    void reset();
+
+    size_t nBins() const { return m_axis.nBins(); }
+    double min() const { return m_axis.min(); }
+    double max() const { return m_axis.max(); }
+    const BinnedTable2D::Axis& axis() const { return m_axis; }
+
+    /// \return The sum of the weights in bin \p bin (0 <= \p bin <= N + 1)
+    double binContent(size_t bin) const { return m_sumw[bin]; }
+
+    /// \return The sum of the squared weights in bin \p bin (0 <= \p bin <= N + 1)
+    double binSumw2(size_t bin) const { return m_sumw2[bin]; }
+
+    /// \return The number of calls to fill(), underflow and overflow included
+    double entries() const { return m_entries; }
+
+    /// \return The sum of the weights of the regular bins (underflow and overflow excluded)
+    double integral() const;
+
+    /**
+     * \brief Convert this histogram into a ROOT histogram
+     *
+     * Bin contents and errors are copied, underflow and overflow included, as well as the number of entries. The
+     * histogram is not attached to any directory.
+     *
+     * \note Part of the ROOT plugin when MoMEMta is built with the `ROOT_FREE_CORE` option.
+     */
+    std::unique_ptr<TH1D> toTH1D(const std::string& name, const std::string& title = "") const;
+
+    /// Copy the content and the number of entries of this histogram into \p hist, which must have the same number of bins
+    void fillTH1D(TH1D& hist) const;
+
+private:
+    BinnedTable2D::Axis m_axis;
+    std::vector<double> m_sumw;
+    std::vector<double> m_sumw2;
+    double m_entries = 0;
+};
+
+}
@@ -98,4 +98,22 @@ class ILuaCallback {
         * will result in a call to this function with \p name equals to `lepton`
         */
         virtual void onNewInputDeclared(const std::string& name) = 0;
+
+        /** \brief A shared library was loaded by the configuration file
+        *
+        * This function is called when the user calls the `load_modules` lua function, or the `load_root_plugin` one
+        * when MoMEMta is built with the `ROOT_FREE_CORE` option (\p path is then the name of the ROOT plugin)
+        *
+        * A lua code like
+        * ```
+        * load_modules("libmodules.so")
+        * ```
+        *
+        * will result in a call to this function with \p path equals to `libmodules.so`
+        *
+        * The default implementation does nothing.
+        */
+        virtual void onLibraryLoaded(const std::string& /* path */) {
+            // Empty
+        }
 };
@@ -39,6 +39,16 @@ namespace momemta {
 
             void setParameter(const std::string& name, double value);
 
+            /// \return True if the parameter \p name exists
+            bool hasParameter(const std::string& name) const;
+
+            /**
+             * \brief Current value of a parameter
+             *
+             * \throw std::out_of_range if the parameter does not exist
+             */
+            double getParameter(const std::string& name) const;
+
         protected:
             std::unordered_map<std::string, double> m_card_parameters;
     };
@@ -18,9 +18,19 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
+#include <momemta/config.h>
+
+#ifndef ROOT_FREE_CORE
+#include <Math/DistFunc.h>
+#endif
+
 /// Compute \f$ x^2 \f$
 #define SQ(x) ((x) * (x))
 /// Compute \f$ x^3 \f$
@@ -70,6 +80,68 @@ inline double cosXpm2PI3(const double x, const double pm) {
     return -0.5 * (std::cos(x) + pm * std::sin(x) * std::sqrt(3.));
 }
 
+/**
+ * \brief Fixed-capacity container for the real roots of a polynomial
+ *
+ * Holds at most 4 values, stored inline: filling it never allocates memory. It can be used instead of a
+ * `std::vector<double>` with all the polynomial solvers below, which never return more than 4 roots.
+ */
+class Roots {
+public:
+    static constexpr size_t capacity = 4;
+
+    using value_type = double;
+    using iterator = double*;
+    using const_iterator = const double*;
+
+    /// Append \p x. Throws `std::length_error` if the container is full.
+    void push_back(double x) {
+        if (m_size == capacity)
+            throw std::length_error("Too many roots");
+        m_values[m_size++] = x;
+    }
+
+    /// Remove the value pointed to by \p position
+    iterator erase(const_iterator position) {
+        iterator it = begin() + (position - begin());
+        for (iterator next = it + 1; next != end(); ++next)
+            *(next - 1) = *next;
+        m_size--;
+        return it;
+    }
+
+    void clear() { m_size = 0; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    double& operator[](size_t i) { return m_values[i]; }
+    double operator[](size_t i) const { return m_values[i]; }
+
+    double at(size_t i) const {
+        if (i >= m_size)
+            throw std::out_of_range("Invalid root index");
+        return m_values[i];
+    }
+
+    iterator begin() { return m_values; }
+    iterator end() { return m_values + m_size; }
+    const_iterator begin() const { return m_values; }
+    const_iterator end() const { return m_values + m_size; }
+
+private:
+    double m_values[capacity];
+    size_t m_size = 0;
+};
+
+/**
+ * \name Polynomial solvers
+ *
+ * The solutions are appended to a container, which can either be a `std::vector<double>` or a Roots. The latter
+ * is preferred when the solvers are called for each phase-space point, since it never allocates memory.
+ */
+///@{
+
 /**
  * \brief Finds the real solutions to \f$ a*x^2 + b*x + c = 0 \f$
  *
@@ -85,7 +157,8 @@ inline double cosXpm2PI3(const double x, const double pm) {
  *
  * \return True if a solution has been found, false otherwise
  */
-bool solveQuadratic(const double a, const double b, const double c, std::vector<double>& roots,
+template <typename Container>
+bool solveQuadratic(const double a, const double b, const double c, Container& roots,
                     bool verbose = false);
 
 /**
@@ -105,8 +178,9 @@ bool solveQuadratic(const double a, const double b, const double c, std::vector<
  *
  * \return True if a solution has been found, false otherwise
  */
+template <typename Container>
 bool solveCubic(const double a, const double b, const double c, const double d,
-                std::vector<double>& roots, bool verbose = false);
+                Container& roots, bool verbose = false);
 
 // Finds the real solutions to a*x^4 + b*x^3 + c*x^2 + d*x + e = 0
 // Handles special case a=0.
@@ -144,8 +218,9 @@ bool solveCubic(const double a, const double b, const double c, const double d,
  *
  * \return True if a solution has been found, false otherwise
  */
+template <typename Container>
 bool solveQuartic(const double a, const double b, const double c, const double d, const double e,
-                  std::vector<double>& roots, bool verbose = false);
+                  Container& roots, bool verbose = false);
 
 /**
  * \brief Solve a system of two quadratic equations
@@ -160,8 +235,8 @@ bool solveQuartic(const double a, const double b, const double c, const double d
  * 
  * Which corresponds to finding the intersection points of two conics.
  * 
- * Appends the (x,y) solutions to the std::vectors E1, E2, making no attempt to check
- * whether these vectors are empty.
+ * Appends the (x,y) solutions to E1, E2, making no attempt to check
+ * whether these containers are empty.
  *
  * In most cases it simply comes down to solving a quartic equation:
  *   - eliminate the \f$ E_1^2 \f$ term
@@ -172,10 +247,11 @@ bool solveQuartic(const double a, const double b, const double c, const double d
  * The procedure becomes tricky in some special cases (intersections aligned along x- or y-axis,
  * degenerate conics, ...)
  */
+template <typename Container>
 bool solve2Quads(const double a20, const double a02, const double a11, const double a10,
                  const double a01, const double a00, const double b20, const double b02,
                  const double b11, const double b10, const double b01, const double b00,
-                 std::vector<double>& E1, std::vector<double>& E2, bool verbose = false);
+                 Container& E1, Container& E2, bool verbose = false);
 
 /**
  * \brief Solve a system of two degenerated quadratic equations
@@ -190,13 +266,14 @@ bool solve2Quads(const double a20, const double a02, const double a11, const dou
  * 
  * Which corresponds to finding the intersection points of two conics.
  * 
- * Appends the (x,y) solutions to the std::vectors E1, E2, making no attempt to check
- * whether these vectors are empty.
+ * Appends the (x,y) solutions to E1, E2, making no attempt to check
+ * whether these containers are empty.
  *
  */
+template <typename Container>
 bool solve2QuadsDeg(const double a11, const double a10, const double a01, const double a00,
                     const double b11, const double b10, const double b01, const double b00,
-                    std::vector<double>& E1, std::vector<double>& E2, bool verbose = false);
+                    Container& E1, Container& E2, bool verbose = false);
 
 /**
  * \brief Solve a system of two linear equations
@@ -209,14 +286,119 @@ bool solve2QuadsDeg(const double a11, const double a10, const double a01, const
  *   \end{align*}
  * \f]
  * 
- * Appends the (x,y) solutions to the std::vectors E1, E2, making no attempt to check
- * whether these vectors are empty.
+ * Appends the (x,y) solutions to E1, E2, making no attempt to check
+ * whether these containers are empty.
  */
+template <typename Container>
 bool solve2Linear(const double a10, const double a01, const double a00, const double b10,
-                  const double b01, const double b00, std::vector<double>& E1,
-                  std::vector<double>& E2, bool verbose = false);
+                  const double b01, const double b00, Container& E1,
+                  Container& E2, bool verbose = false);
+
+/**
+ * \brief Finds the real solutions to a batch of quartic equations
+ *
+ * Equivalent to calling solveQuartic() on each equation \f$ a_i*x^4 + b_i*x^3 + c_i*x^2 + d_i*x + e_i = 0 \f$,
+ * the solutions being stored in \p roots[i] (which is cleared first).
+ *
+ * The coefficients are passed as separate arrays, and equations are solved in chunks: the reduction to the
+ * resolvent cubic and its solution are computed for the whole chunk in loops without any branch, which the
+ * compiler can vectorize. Only the special cases (\f$ a_i = 0 \f$ or \f$ b_i = d_i = 0 \f$) are solved one by one.
+ *
+ * \param n Number of equations
+ * \param a, b, c, d, e Coefficients of the equations (\p n values each)
+ * \param[out] roots Roots of each equation (\p n containers)
+ */
+void solveQuarticBatch(size_t n, const double* a, const double* b, const double* c, const double* d,
+                       const double* e, Roots* roots);
+
+///@}
 
 /**
  * \brief A relativist Breit-Wigner distribution
  */
 double BreitWigner(const double s, const double m, const double g);
+
+/**
+ * \name Normal distribution
+ *
+ * Wrappers around the corresponding `ROOT::Math` functions (`normal_pdf`, `normal_cdf` and `normal_quantile`). When
+ * MoMEMta is built with the `ROOT_FREE_CORE` option, the same functions are implemented without ROOT.
+ */
+///@{
+
+/// Probability density of a normal distribution of mean \p mean and standard deviation \p sigma
+inline double normalPdf(double x, double sigma = 1, double mean = 0) {
+#ifndef ROOT_FREE_CORE
+    return ROOT::Math::normal_pdf(x, sigma, mean);
+#else
+    const double z = (x - mean) / sigma;
+    return std::exp(-0.5 * z * z) / (std::sqrt(2 * M_PI) * std::abs(sigma));
+#endif
+}
+
+/// Cumulative distribution function of a normal distribution of mean \p mean and standard deviation \p sigma
+inline double normalCdf(double x, double sigma = 1, double mean = 0) {
+#ifndef ROOT_FREE_CORE
+    return ROOT::Math::normal_cdf(x, sigma, mean);
+#else
+    return 0.5 * std::erfc(-(x - mean) / (sigma * M_SQRT2));
+#endif
+}
+
+#ifdef ROOT_FREE_CORE
+/**
+ * \brief Quantile of a normal distribution of mean 0 and standard deviation 1
+ *
+ * Computed using the algorithm AS241 of M. Wichura, accurate to about 1 part in \f$ 10^{16} \f$.
+ */
+double normalQuantileAS241(double p);
+#endif
+
+/**
+ * \brief Quantile of a normal distribution of mean 0 and standard deviation \p sigma
+ *
+ * \return \f$ -\infty \f$ if \p p <= 0, and \f$ +\infty \f$ if \p p >= 1
+ */
+inline double normalQuantile(double p, double sigma = 1) {
+    if (p <= 0)
+        return -std::numeric_limits<double>::infinity();
+    if (p >= 1)
+        return std::numeric_limits<double>::infinity();
+
+#ifndef ROOT_FREE_CORE
+    return ROOT::Math::normal_quantile(p, sigma);
+#else
+    return normalQuantileAS241(p) * sigma;
+#endif
+}
+
+///@}
+
+/**
+ * \brief Cosine of the angle between the 3-momenta of \p v1 and \p v2
+ *
+ * Same as `ROOT::Math::VectorUtil::CosTheta`, for any type providing `Px()`, `Py()` and `Pz()`
+ */
+template <typename T> inline double cosTheta(const T& v1, const T& v2) {
+    const double p2 = (SQ(v1.Px()) + SQ(v1.Py()) + SQ(v1.Pz())) * (SQ(v2.Px()) + SQ(v2.Py()) + SQ(v2.Pz()));
+    if (p2 <= 0)
+        return 0;
+
+    const double cos_theta = (v1.Px() * v2.Px() + v1.Py() * v2.Py() + v1.Pz() * v2.Pz()) / std::sqrt(p2);
+    return std::max(-1., std::min(1., cos_theta));
+}
+
+/**
+ * \brief Azimuthal angle between \p v1 and \p v2, in \f$ [-\pi, \pi] \f$
+ *
+ * Same as `ROOT::Math::VectorUtil::DeltaPhi`, for any type providing `Phi()`
+ */
+template <typename T> inline double deltaPhi(const T& v1, const T& v2) {
+    double dphi = v2.Phi() - v1.Phi();
+    if (dphi > M_PI)
+        dphi -= 2 * M_PI;
+    else if (dphi <= -M_PI)
+        dphi += 2 * M_PI;
+
+    return dphi;
+}
@@ -19,7 +19,11 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <momemta/config.h>
@@ -31,6 +35,12 @@
 
 class Configuration;
 class SharedLibrary;
+class ThreadTeam;
+
+namespace momemta {
+class Scheduler;
+}
+struct PathElements;
 
 #ifdef DEBUG_TIMING
 #include <chrono>
@@ -54,6 +64,9 @@ class MoMEMta {
             NONE ///< No integration was performed
         };
 
+        /// Index of an input declared in the configuration, see getInputHandle()
+        using InputHandle = std::size_t;
+
         /** \brief Create a new MoMEMta instance
          *
          * \param configuration A frozen snapshot of the configuration, usually obtained by ConfigurationReader::freeze
@@ -64,6 +77,27 @@ class MoMEMta {
         /// Destructor
         virtual ~MoMEMta();
 
+        /**
+         * \brief Create an independent copy of this instance
+         *
+         * The copy has its own memory pool and its own modules, and can thus be used concurrently with this
+         * instance, for example in another thread. It's much cheaper than creating a new instance from the
+         * configuration:
+         *   - the resolved execution graph is re-used: modules removed from the configuration are not created at all,
+         *     and the graph is not built again,
+         *   - heavy read-only resources are shared between the instances instead of being loaded again: transfer
+         *     function tables, PDF sets and PDF interpolation tables.
+         *
+         * The global parameters of the copy are the current ones of this instance (see updateParameters()).
+         *
+         * \note Matrix elements, including their parameters, are not shared: each copy creates its own. The generated
+         *       matrix elements change their state while computing: the helicity filter disables the helicities found
+         *       to give no contribution, the event-dependent parameters and couplings are computed again, and the
+         *       momenta and wave functions are stored in the instance. Sharing them would make concurrent evaluations
+         *       race on this state.
+         */
+        std::unique_ptr<MoMEMta> clone() const;
+
         /** \brief Compute the weights in the current configuration.
          *
          * This function is traditionally called from the main event loop.
@@ -76,6 +110,91 @@ class MoMEMta {
         std::vector<std::pair<double, double>> computeWeights(const std::vector<momemta::Particle>& particles,
                                                               const LorentzVector& met = LorentzVector());
 
+        /**
+         * \brief Resolve the handle of an input declared in the configuration
+         *
+         * Handles are the indices of the inputs in the arrays given to
+         * computeWeights(const LorentzVector*, const int64_t*, const LorentzVector&, double*, double*). They are
+         * resolved once, typically right after the creation of the instance, and stay valid for its whole lifetime.
+         * Inputs are numbered in the order of their declaration in the configuration.
+         *
+         * \param name Name of the input, as declared in the configuration using `declare_input`
+         */
+        InputHandle getInputHandle(const std::string& name) const;
+
+        /// \return The number of inputs declared in the configuration, i.e. the size of the input arrays
+        std::size_t getNumberOfInputs() const;
+
+        /// \return The number of components of the integrand, i.e. the size of the result arrays
+        std::size_t getNumberOfComponents() const;
+
+        /**
+         * \brief Compute the weights for an event given as flat arrays
+         *
+         * Same as computeWeights(const std::vector<momemta::Particle>&, const LorentzVector&), without any name
+         * lookup: the inputs are given by handle (see getInputHandle()) and the weights are written to buffers owned by
+         * the caller. If the configuration does not request any integration dimension, no memory is allocated.
+         *
+         * \param p4 4-momenta of the inputs, indexed by handle (getNumberOfInputs() entries)
+         * \param types Types of the inputs, indexed by handle. If null, all the types are set to 0.
+         * \param met Missing transverse energy of the event.
+         * \param[out] values Value of each weight (getNumberOfComponents() entries)
+         * \param[out] errors Absolute error on each weight (getNumberOfComponents() entries)
+         */
+        void computeWeights(const LorentzVector* p4, const int64_t* types, const LorentzVector& met,
+                            double* values, double* errors);
+
+        /**
+         * \brief Evaluate the weights of many events at once
+         *
+         * Only available for configurations without integration dimension, where the integrand is evaluated once per
+         * event. Events are split in chunks, evaluated concurrently by \p threads lanes: this instance and copies of it
+         * (see clone()), kept from one call to the next. Compared to calling computeWeights() for each event, the
+         * per-event overhead is reduced to the evaluation of the modules.
+         *
+         * \param n_events Number of events
+         * \param p4 4-momenta of the inputs, event after event. The inputs of event `i` start at
+         *        `p4[i * getNumberOfInputs()]` and are indexed by handle (see getInputHandle()).
+         * \param types Types of the inputs, with the same layout as \p p4. If null, all the types are set to 0.
+         * \param met Missing transverse energy of each event. If null, the MET is set to 0 for all the events.
+         * \param[out] values Weights, component after component: the weight of event `i` for component `c` is stored
+         *        in `values[c * n_events + i]`. Events whose evaluation was aborted have a weight of 0.
+         * \param threads Number of lanes used for the evaluation
+         *
+         * \return The number of events whose evaluation was aborted
+         */
+        size_t computeWeightsBulk(size_t n_events, const LorentzVector* p4, const int64_t* types,
+                                  const LorentzVector* met, double* values, size_t threads = 1);
+
+        /**
+         * \brief Integrate several events at once
+         *
+         * All the events are integrated in a single integration: each phase-space point drawn by the integrator is
+         * evaluated for all the events in turn, using this instance for the first event and copies of it (see
+         * clone()) for the others. Each event has its own integrand components, and thus its own results and
+         * errors, but the adaptive grid of the integrator is shared between the events, and the integration stops
+         * once all the events have reached the requested accuracy. This is well suited to events with a similar
+         * topology, for which the integrand peaks in the same regions of the phase-space.
+         *
+         * The arguments have the same layout as for computeWeightsBulk(). If a module aborts the evaluation of an event,
+         * only this event is aborted: its integrand is 0 for the remaining points, and its weights and errors are set
+         * to 0. The integration of the other events goes on. The status returned by getIntegrationStatus() is the one of
+         * the integration, common to all the events not aborted.
+         *
+         * \param n_events Number of events. At most 1024 integrand components (events times components) are supported.
+         * \param p4 4-momenta of the inputs, event after event, indexed by handle (see getInputHandle())
+         * \param types Types of the inputs, with the same layout as \p p4. If null, all the types are set to 0.
+         * \param met Missing transverse energy of each event. If null, the MET is set to 0 for all the events.
+         * \param[out] values Weights: the weight of event `i` for component `c` is stored in `values[c * n_events + i]`
+         * \param[out] errors Absolute errors on the weights, with the same layout as \p values
+         * \param[out] status Status of the integration of each event. Optional.
+         *
+         * \return The number of events whose evaluation was aborted
+         */
+        size_t computeWeightsLockStep(size_t n_events, const LorentzVector* p4, const int64_t* types,
+                                      const LorentzVector* met, double* values, double* errors,
+                                      IntegrationStatus* status = nullptr);
+
         /** \brief Return the status of the integration
          *
          * \return The status of the integration
@@ -91,7 +210,33 @@ class MoMEMta {
          */
         const Pool& getPool() const;
 
+        /**
+         * \brief Change the value of global parameters
+         *
+         * Only the modules depending on the parameters which actually changed are re-created, using the new values:
+         *   - modules with a parameter bound to one of them using the `parameter()` lua function,
+         *   - modules which read one of them directly when they were created (see ParameterSet::globalParameters()),
+         *   - loopers whose path contains a re-created module.
+         *
+         * Re-created modules produce their outputs in the same memory blocks as the modules they replace, so that
+         * the other modules keep reading them.
+         *
+         * All the other modules are kept as is, along with their state (PDFs, transfer function tables, ...). This
+         * makes scans over a global parameter, like the mass of a particle, much cheaper than creating a new
+         * instance for each value.
+         *
+         * \param parameters New values of the global parameters. Only parameters declared in the `parameters` table
+         *        of the configuration can be updated.
+         *
+         * If an exception is thrown while re-creating a module, the previous values of the global parameters are
+         * restored, along with the modules depending on them, before the exception is propagated: the instance stays
+         * usable.
+         */
+        void updateParameters(const ParameterSet& parameters);
+
     private:
+        friend class momemta::Scheduler;
+
         class integrands_output_error: public std::runtime_error {
             using std::runtime_error::runtime_error;
         };
@@ -108,6 +253,12 @@ class MoMEMta {
         class invalid_inputs: public std::runtime_error {
             using std::runtime_error::runtime_error;
         };
+        class unknown_parameter_error: public std::runtime_error {
+            using std::runtime_error::runtime_error;
+        };
+        class unsupported_configuration_error: public std::runtime_error {
+            using std::runtime_error::runtime_error;
+        };
 
         /**
          * \brief Test if a LorentzVector is physical or not
@@ -118,8 +269,55 @@ class MoMEMta {
          */
         void checkIfPhysical(const LorentzVector& p4);
 
+        /// Used by clone()
+        MoMEMta(const MoMEMta& other);
+        MoMEMta& operator=(const MoMEMta&) = delete;
+
+        /// Create the memory pool, and the blocks for the phase-space point and the inputs
+        void initPool(const ParameterSet& cuba_configuration, const std::vector<std::string>& inputs);
+
+        /// Make the paths used in \p parameters point to the elements given by \p paths
+        static void retargetPaths(ParameterSet& parameters,
+                                  const std::unordered_map<PathElements*, PathElements*>& paths);
+
+        /// Set the inputs of the current event, indexed by handle
+        void setInputs(const LorentzVector* p4, const int64_t* types, const LorentzVector& met);
+
+        /// Make sure at least \p n copies of this instance are available in m_copies
+        void createCopies(size_t n);
+
+        /**
+         * \brief Integrate the current event, writing the weights in \p values and their errors in \p errors
+         *
+         * In lock-step mode, the events of all the instances of m_lock_step_engines are integrated.
+         */
+        void integrate(double* values, double* errors);
+
+        /// Evaluate the integrand for a phase-space point, for all the events integrated together
+        int evaluate(const double* psPoints, double* results, const double* weights);
+
+        /// Evaluate the integrand for the \p n phase-space points given by cuba in a single call
+        int evaluatePoints(const double* psPoints, double* results, const double* weights, size_t n);
+
+        /// Evaluate events [\p begin, \p end[ for computeWeightsBulk(). \return The number of aborted evaluations
+        size_t evaluateEvents(size_t begin, size_t end, size_t n_events, const LorentzVector* p4, const int64_t* types,
+                              const LorentzVector* met, double* values);
+
         int integrand(const double* psPoints, double* results, const double* weights);
 
+        /// \return The slot holding the module named \p name, either in the main path or in a path, or nullptr
+        ModulePtr* findModule(const std::string& name);
+
+        /// Update the modules depending on the global parameters \p changed, after a change of m_global_parameters
+        void applyGlobalParameters(const std::vector<std::string>& changed);
+
+        /**
+         * \brief Re-create the module \p name using its description in the pool
+         *
+         * If the creation fails, the module and the pool are left as they were.
+         */
+        void recreateModule(const std::string& name);
+
         static int CUBAIntegrand(const int *nDim, const double* psPoint, const int *nComp, double *value, void *inputs, const int *nVec, const int *core);
         static int CUBAIntegrandWeighted(const int *nDim, const double* psPoint, const int *nComp, double *value, void *inputs, const int *nVec, const int *core, const double *weight);
         static void cuba_logging(const char*);
@@ -127,12 +325,33 @@ class MoMEMta {
         PoolPtr m_pool;
         std::vector<ModulePtr> m_modules;
 
+        ParameterSet m_global_parameters;
+        std::vector<std::shared_ptr<PathElements>> m_paths; ///< Resolved copies of the paths of the configuration
+        /// Global parameters read directly by each module, when it was created
+        std::unordered_map<std::string, std::set<std::string>> m_global_parameters_reads;
+
         using SharedLibraryPtr = std::shared_ptr<SharedLibrary>;
         std::vector<SharedLibraryPtr> m_libraries;
 
         std::size_t m_n_dimensions;
         std::size_t m_n_components;
         ParameterSet m_cuba_configuration;
+        std::vector<double> m_cuba_probabilities; ///< Output of cuba, not used
+
+        /// Number of consecutive events evaluated by a lane of computeWeightsBulk()
+        static constexpr size_t BULK_CHUNK_SIZE = 256;
+        std::unique_ptr<ThreadTeam> m_bulk_team;
+        std::vector<std::unique_ptr<MoMEMta>> m_copies; ///< Copies used by computeWeightsBulk() and computeWeightsLockStep()
+        std::vector<MoMEMta*> m_lock_step_engines; ///< Instances integrated together, this one first
+        bool m_lock_step_aborted = false; ///< The evaluation of the event of this instance was aborted in lock-step mode
+        std::vector<double> m_lock_step_buffer; ///< Used to reorder the results of computeWeightsLockStep()
+
+        /// Largest number of phase-space points given by cuba to the integrand at once
+        size_t m_points_per_call = 1;
+        /// Evaluate \p n phase-space points at once. Set by momemta::Scheduler to share the points between threads.
+        using PointsEvaluator = std::function<int(const double* psPoints, double* results, const double* weights, size_t n)>;
+        PointsEvaluator m_points_evaluator;
+        std::vector<double> m_bulk_results; ///< Integrand of the current event
 
         IntegrationStatus integration_status = IntegrationStatus::NONE;
 
@@ -142,7 +361,12 @@ class MoMEMta {
 
         std::unordered_map<std::string, std::shared_ptr<LorentzVector>> m_inputs_p4;
         std::unordered_map<std::string, std::shared_ptr<int64_t>> m_inputs_type;
+        std::vector<std::string> m_input_names; ///< In order of declaration
         std::shared_ptr<LorentzVector> m_met;
+        // Same inputs, indexed by handle
+        std::vector<LorentzVector*> m_inputs_p4_by_handle;
+        std::vector<int64_t*> m_inputs_type_by_handle;
+        std::vector<InputTag> m_integrand_tags;
         std::vector<Value<double>> m_integrands;
 
 #ifdef DEBUG_TIMING
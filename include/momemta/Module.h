@@ -120,6 +120,17 @@ class Module {
          */
         virtual void finish() { };
 
+        /**
+         * \brief Merge the results of a copy of this module into this module
+         *
+         * When the solutions of a Looper are evaluated concurrently, each thread runs its own copy of the modules
+         * of the path. At the end of the loop, the copies are merged into the original modules, always in the same
+         * order. Modules accumulating a result over the solutions of a loop must implement this method.
+         *
+         * \param other A copy of this module, created with the same parameters
+         */
+        virtual void merge(const Module& /* other */) {};
+
         /**
          * \brief Check if module produces an output or not
          *
@@ -188,6 +199,31 @@ class Module {
             return m_pool->get<T>(tag);
         }
 
+        /**
+         * \brief Return the memory arena of the current phase-space point
+         *
+         * \sa momemta::Arena
+         */
+        momemta::Arena& arena() const {
+            return m_pool->arena();
+        }
+
+        /**
+         * \brief Return an allocator for temporary containers
+         *
+         * Memory is taken from the arena of the memory pool, which is reset at the beginning of each phase-space
+         * point: containers using this allocator must not be kept from one point to the next.
+         *
+         * Example:
+         * ```
+         * // In work()
+         * momemta::ArenaVector<double> values(allocator<double>());
+         * ```
+         */
+        template<typename T> momemta::ArenaAllocator<T> allocator() const {
+            return momemta::ArenaAllocator<T>(m_pool->arena());
+        }
+
     private:
         
         const std::string m_name;
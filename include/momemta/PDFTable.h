@@ -0,0 +1,137 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace momemta {
+
+/**
+ * \brief Interpolation table of \f$ x f(x) \f$ at a fixed factorisation scale
+ *
+ * The table is filled once from an external PDF evaluator (typically LHAPDF) on a grid uniform in
+ * \f$ u = \ln\left(\frac{x}{1 - x}\right) \f$, which resolves both the low-\f$x\f$ and the high-\f$x\f$
+ * regions. Values are stored contiguously for each flavour and evaluated using a four-point
+ * Lagrange (cubic) interpolation, without any branching apart from the range check.
+ *
+ * Evaluations outside of the table range are not supported: use covers() to check if the table
+ * can be used for a given \f$ x \f$, and fall back to the original evaluator otherwise.
+ */
+class PDFTable {
+public:
+    /// Evaluate \f$ x f(x) \f$ for a given parton PDG id and Björken-\f$ x \f$
+    using Evaluator = std::function<double(int, double)>;
+
+    /**
+     * \brief Fill the table
+     *
+     * \param flavours PDG ids of the partons to tabulate. 0 and 21 both refer to the gluon.
+     * \param x_min, x_max Range in \f$ x \f$ covered by the table. \f$ x_{max} \f$ must be strictly less than 1.
+     * \param n_points Number of nodes of the grid (at least 4)
+     * \param xfx Function used to fill the table
+     */
+    PDFTable(const std::vector<int>& flavours, double x_min, double x_max, size_t n_points, const Evaluator& xfx);
+
+    /// \return True if \p pdg_id has been tabulated
+    bool hasFlavour(int pdg_id) const {
+        return slot(pdg_id) >= 0;
+    }
+
+    /// \return True if \p x is inside the table range
+    bool covers(double x) const {
+        return x >= m_x_min && x <= m_x_max;
+    }
+
+    /**
+     * \brief Interpolate \f$ x f(x) \f$
+     *
+     * \warning Neither the flavour nor the range are checked. Use hasFlavour() and covers() first.
+     */
+    double xfx(int pdg_id, double x) const {
+        return interpolate(&m_values[slot(pdg_id) * m_n_points], x);
+    }
+
+    /**
+     * \brief Compare the table with a reference evaluator
+     *
+     * For each flavour, the table is compared to \p xfx half-way between each pair of nodes,
+     * where the interpolation error is the largest.
+     *
+     * \return The largest relative deviation found. Reference values smaller than \p threshold
+     *         in absolute value are compared using an absolute deviation instead.
+     */
+    double validate(const Evaluator& xfx, double threshold = 1e-6) const;
+
+    size_t size() const {
+        return m_n_points;
+    }
+
+private:
+    static constexpr int MIN_PDG_ID = -6;
+    static constexpr int MAX_PDG_ID = 22;
+
+    int slot(int pdg_id) const {
+        if (pdg_id == 0)
+            pdg_id = 21;
+
+        if (pdg_id < MIN_PDG_ID || pdg_id > MAX_PDG_ID)
+            return -1;
+
+        return m_slots[pdg_id - MIN_PDG_ID];
+    }
+
+    static double toGrid(double x) {
+        return std::log(x / (1. - x));
+    }
+
+    double interpolate(const double* values, double x) const {
+        const double u = (toGrid(x) - m_u_min) * m_inv_step;
+
+        // First node of the stencil, kept inside the grid
+        std::ptrdiff_t i = static_cast<std::ptrdiff_t>(u) - 1;
+        i = std::min<std::ptrdiff_t>(std::max<std::ptrdiff_t>(i, 0), static_cast<std::ptrdiff_t>(m_n_points) - 4);
+
+        const double t = u - i;
+        const double t1 = t - 1.;
+        const double t2 = t - 2.;
+        const double t3 = t - 3.;
+
+        const double* v = values + i;
+        return (- v[0] * t1 * t2 * t3 + 3. * t * t2 * t3 * v[1] - 3. * t * t1 * t3 * v[2] + t * t1 * t2 * v[3]) / 6.;
+    }
+
+    double m_x_min;
+    double m_x_max;
+    double m_u_min;
+    double m_inv_step;
+    size_t m_n_points;
+
+    std::vector<int> m_flavours;
+    int m_slots[MAX_PDG_ID - MIN_PDG_ID + 1];
+
+    /// Values of \f$ x f(x) \f$, flavour after flavour
+    std::vector<double> m_values;
+};
+
+}
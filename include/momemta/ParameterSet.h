@@ -21,7 +21,9 @@
 
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <vector>
 
 #include <momemta/any.h>
 #include <momemta/InputTag.h>
@@ -31,6 +33,7 @@
 
 class ConfigurationReader;
 class Configuration;
+class MoMEMta;
 
 /**
  * \brief A class encapsulating a lua table.
@@ -76,6 +79,8 @@ class ParameterSet {
         ParameterSet() = default;
 
         template<typename T> const T& get(const std::string& name) const {
+            recordRead(name);
+
             auto value = m_set.find(name);
             if (value == m_set.end())
                 throw not_found_error("Parameter '" + name + "' not found.");
@@ -93,6 +98,8 @@ class ParameterSet {
         }
 
         template<typename T> const T& get(const std::string& name, const T& defaultValue) const {
+            recordRead(name);
+
             auto value = m_set.find(name);
             if (value == m_set.end())
                 return defaultValue;
@@ -120,6 +127,8 @@ class ParameterSet {
 
         bool exists(const std::string& name) const;
         template<typename T> bool existsAs(const std::string& name) const {
+            recordRead(name);
+
             auto value = m_set.find(name);
             return (value != m_set.end() && value->second.value.type() == typeid(T));
         }
@@ -204,12 +213,21 @@ class ParameterSet {
             return get<std::string>("@type", "");
         }
 
+        /**
+         * \brief The global parameters of the configuration
+         *
+         * The names of the parameters read from the returned set are recorded, so that only the modules reading a
+         * global parameter are re-created when it changes (see MoMEMta::updateParameters()).
+         */
         const ParameterSet& globalParameters() const {
+            const ParameterSet* global = this;
+
             auto it = m_set.find("@global_parameters");
-            if (it == m_set.end())
-                return *this;
+            if (it != m_set.end())
+                global = &momemta::any_cast<const ParameterSet&>(it->second.value);
 
-            return momemta::any_cast<const ParameterSet&>(it->second.value);
+            global->m_record_reads = true;
+            return *global;
         }
 
         /**
@@ -226,6 +244,7 @@ class ParameterSet {
     protected:
         friend class ConfigurationReader;
         friend class Configuration;
+        friend class MoMEMta;
         friend class ParameterSetParser;
 
         /// A small wrapper around a momemta::any value
@@ -265,10 +284,38 @@ class ParameterSet {
 
         virtual void freeze();
 
+        /**
+         * \brief Update the parameters bound to a global parameter
+         *
+         * Parameters declared using the `parameter()` lua function keep track of the global parameter they refer to
+         * when the set is frozen. The attached global parameters (see globalParameters()) are replaced as well.
+         *
+         * \param global_parameters The new global parameters
+         * \param names Names of the global parameters which changed
+         *
+         * \return True if at least one parameter of this set, or of a nested set, refers to one of \p names
+         */
+        bool updateReferences(const ParameterSet& global_parameters, const std::vector<std::string>& names);
+
         std::map<std::string, Element> m_set;
 
+        /// Parameters bound to a global parameter using `parameter()`, with the name of the global parameter
+        std::map<std::string, std::string> m_references;
+
+        /// \return The names of the parameters read through globalParameters()
+        std::set<std::string> globalParametersReads() const;
+
+        /// If true, the names of the parameters read from this set are recorded in #m_reads
+        mutable bool m_record_reads = false;
+        mutable std::set<std::string> m_reads;
+
     private:
 
+        void recordRead(const std::string& name) const {
+            if (m_record_reads)
+                m_reads.insert(name);
+        }
+
         class not_found_error: public std::runtime_error {
             using std::runtime_error::runtime_error;
         };
@@ -22,6 +22,8 @@
 #include <string>
 #include <vector>
 
+class Configuration;
+class MoMEMta;
 class Module;
 
 /**
@@ -89,6 +91,9 @@ class Path {
         void freeze();
 
     private:
+        friend class Configuration;
+        friend class MoMEMta;
+
         PathElementsPtr elements_ = nullptr;
         bool frozen = false;
         std::vector<std::shared_ptr<Module>> modules_;
@@ -21,8 +21,10 @@
 
 #include <assert.h>
 #include <memory>
+#include <type_traits>
 #include <unordered_map>
 
+#include <momemta/Arena.h>
 #include <momemta/any.h>
 #include <momemta/impl/InputTag_fwd.h>
 #include <momemta/Configuration.h>
@@ -36,6 +38,7 @@
 struct PoolContent {
     momemta::any ptr; /// Pointer to the memory allocated for this block
     bool valid; /// The state of the memory block. If false, it means that a module requested this block in read-mode, but no module actually provides the block.
+    bool reproduced; /// If true, the module producing this block is re-created: the block is initialized again when produced, at the same address.
 };
 
 // FIXME: Use a more descriptive name, like "ModuleDependencies"
@@ -51,6 +54,17 @@ class Pool {
 
         Pool() = default;
 
+        /**
+         * \brief Create a pool layered on top of another one
+         *
+         * Blocks are first looked up in this pool, then in \p parent. Blocks produced in this pool thus shadow the
+         * ones of \p parent, while all the other blocks are shared. This allows to create independent copies of a
+         * set of modules, using the same inputs as the original modules.
+         *
+         * \param parent The pool in which blocks not produced in this pool are looked up
+         */
+        explicit Pool(std::shared_ptr<const Pool> parent);
+
         /**
          * \brief Allocate a new block in the memory pool.
          *
@@ -83,6 +97,16 @@ class Pool {
             return m_description;
         }
 
+        /**
+         * \brief Return the memory arena of this pool
+         *
+         * The arena is reset at the beginning of each phase-space point. Pools layered on top of another one
+         * have their own arena.
+         */
+        momemta::Arena& arena() const {
+            return *m_arena;
+        }
+
     private:
         friend class MoMEMta;
         friend class Module;
@@ -104,6 +128,12 @@ class Pool {
         template<typename T, typename... Args> PoolStorage::iterator create(const InputTag& tag,
                 bool valid, Args&&... args) const;
 
+        /// Initialize again a block produced by a re-created module, keeping its address
+        template<typename T, typename... Args> static void reinitialize(std::true_type /* assignable */, T& block,
+                const InputTag& tag, Args&&... args);
+        template<typename T, typename... Args> static void reinitialize(std::false_type /* assignable */, T& block,
+                const InputTag& tag, Args&&... args);
+
     public:
         /**
          * \brief Inform the pool of which module is currently created.
@@ -161,6 +191,9 @@ private:
         Configuration::Module m_current_module; /// Module currently created.
         bool m_frozen = false; /// If true, no modification of the pool is allowed
 
+        std::shared_ptr<const Pool> m_parent; /// Pool in which missing blocks are looked up, if any
+        std::unique_ptr<momemta::Arena> m_arena {new momemta::Arena()}; /// Memory for the temporaries of one phase-space point
+
         mutable PoolStorage m_storage;
         mutable DescriptionMap m_description; /// Mutable so that get() can be marked const
 };
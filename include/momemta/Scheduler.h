@@ -0,0 +1,158 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <momemta/MoMEMta.h>
+#include <momemta/Types.h>
+
+class ThreadTeam;
+
+namespace momemta {
+
+/**
+ * \brief Integrate many events using a fixed budget of threads
+ *
+ * Each thread (worker) uses its own instance: the one given to the scheduler, or one of its copies (see
+ * MoMEMta::clone()). Workers take the events one by one. Once no event is left to start, idle workers help the
+ * workers still integrating: the phase-space points requested by the integrator are split in chunks, evaluated by
+ * the owner of the event and stolen by the idle workers. The few events taking much longer than the others are thus
+ * finished using all the threads, instead of leaving most of them idle at the end of the batch.
+ *
+ * Results are deterministic: they don't depend on the number of threads nor on which worker evaluates a point, since
+ * the integrator receives exactly the same integrand values as when integrating the events one after the other. This
+ * only holds if the value computed by each module for a point depends on this point and the event alone: a module
+ * keeping a state from one point to the next (a cache, a random number generator, a counter...) sees a different
+ * sequence of points in each instance, and may give different results depending on the number of threads.
+ *
+ * \note The configuration must not use the parallelisation of Cuba (`ncores` must be 0), and Loopers should run on
+ *       a single thread, so that the number of threads stays within the budget. Modules accumulating results over the
+ *       whole integration (like DMEM) only see the points evaluated by their own instance.
+ *
+ * \warning Copies of the instance are created along with the scheduler: create a new scheduler after calling
+ *          MoMEMta::updateParameters().
+ */
+class Scheduler {
+public:
+    /**
+     * \brief Create a scheduler
+     *
+     * \param engine Instance used by the first worker, and copied for the others
+     * \param threads Number of workers, including the calling thread
+     * \param chunk_size Number of phase-space points in a chunk
+     */
+    Scheduler(MoMEMta& engine, size_t threads, size_t chunk_size = 64);
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    /**
+     * \brief Integrate a set of events
+     *
+     * The arguments have the same layout as for MoMEMta::computeWeightsLockStep().
+     *
+     * \param n_events Number of events
+     * \param p4 4-momenta of the inputs, event after event, indexed by handle (see MoMEMta::getInputHandle())
+     * \param types Types of the inputs, with the same layout as \p p4. If null, all the types are set to 0.
+     * \param met Missing transverse energy of each event. If null, the MET is set to 0 for all the events.
+     * \param[out] values Weights: the weight of event `i` for component `c` is stored in `values[c * n_events + i]`
+     * \param[out] errors Absolute errors on the weights, with the same layout as \p values
+     * \param[out] status Status of the integration of each event. Optional.
+     * \param[out] times Wall-clock time spent integrating each event, in seconds. Optional.
+     */
+    void computeWeights(size_t n_events, const LorentzVector* p4, const int64_t* types, const LorentzVector* met,
+                        double* values, double* errors, MoMEMta::IntegrationStatus* status = nullptr,
+                        double* times = nullptr);
+
+    /// \return The number of workers
+    size_t threads() const {
+        return m_engines.size();
+    }
+
+    class invalid_configuration_error: public std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+private:
+    /// Phase-space points given by the integrator of an event, split in chunks
+    struct Batch;
+
+    /// Job of the worker \p lane: integrate events, then help the other workers
+    void work(size_t lane);
+
+    /// Integrate \p event using the instance of \p lane
+    void integrate(size_t lane, size_t event);
+
+    /// Split the points of \p batch in chunks and evaluate them, with the help of idle workers
+    int evaluate(size_t lane, Batch& batch);
+
+    /**
+     * \brief Take the next chunk of \p batch
+     *
+     * \warning m_mutex must be held
+     *
+     * \return False if all the chunks of the batch are already taken
+     */
+    bool takeChunk(Batch& batch, size_t& chunk);
+
+    /// Evaluate \p chunk of \p batch using the instance of \p lane
+    void evaluateChunk(size_t lane, Batch& batch, size_t chunk);
+
+    /// Make the instance of \p lane ready to evaluate points of \p event
+    void prepare(size_t lane, size_t event);
+
+    /// Integration of \p lane's current event (if any) is over
+    void release(size_t lane);
+
+    static constexpr size_t NO_EVENT = static_cast<size_t>(-1);
+
+    std::vector<MoMEMta*> m_engines; ///< One instance per worker
+    std::vector<std::unique_ptr<MoMEMta>> m_copies;
+    std::vector<size_t> m_current_events; ///< Event for which each instance is prepared
+    std::unique_ptr<ThreadTeam> m_team;
+    size_t m_chunk_size;
+
+    // State of the current call to computeWeights()
+    size_t m_n_events;
+    const LorentzVector* m_p4;
+    const int64_t* m_types;
+    const LorentzVector* m_met;
+    double* m_values;
+    double* m_errors;
+    MoMEMta::IntegrationStatus* m_status;
+    double* m_times;
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed; ///< Notified when a batch is published or completed, or an event is over
+    std::vector<Batch*> m_batches; ///< Batches with chunks left to evaluate
+    size_t m_next_event; ///< Next event to integrate
+    size_t m_finished_events;
+    std::exception_ptr m_exception;
+};
+
+}
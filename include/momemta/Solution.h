@@ -20,7 +20,11 @@
 
 #include <momemta/Types.h>
 
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
 #include <ostream>
+#include <stdexcept>
 #include <vector>
 
 /** \brief Generic solution structure representing a set of particles, along with its jacobian
@@ -33,4 +37,129 @@ struct Solution {
     friend std::ostream& operator<< (std::ostream& stream, const Solution& solution);
 };
 
-using SolutionCollection = std::vector<Solution>;
+/**
+ * \brief Collection of solutions produced by a block
+ *
+ * All the solutions of a collection have the same number of particles. Particles, jacobians and validity flags
+ * are stored in separate contiguous arrays, sized once by reserve(): as long as the capacity is not exceeded,
+ * filling the collection never allocates memory, and clearing it keeps the memory for the next phase-space point.
+ * Blocks should thus call reserve() in their constructor with their maximal number of solutions.
+ *
+ * Solutions are accessed through lightweight views (SolutionCollection::View) pointing directly into the
+ * collection, exposing the same members as a Solution.
+ */
+class SolutionCollection {
+public:
+    /// Read-only view on the particles of a solution
+    class Particles {
+    public:
+        using const_iterator = const LorentzVector*;
+
+        Particles(const LorentzVector* values, size_t size): m_values(values), m_size(size) {}
+
+        const LorentzVector& operator[](size_t i) const { return m_values[i]; }
+        const LorentzVector& at(size_t i) const {
+            if (i >= m_size)
+                throw std::out_of_range("Invalid particle index");
+            return m_values[i];
+        }
+
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        const_iterator begin() const { return m_values; }
+        const_iterator end() const { return m_values + m_size; }
+
+    private:
+        const LorentzVector* m_values;
+        size_t m_size;
+    };
+
+    /// View on a solution of the collection. Only valid as long as the collection is not modified.
+    struct View {
+        Particles values; ///< Values
+        double jacobian; ///< Jacobian associated with the solution
+        bool valid; ///< Is the solution valid?
+
+        friend std::ostream& operator<< (std::ostream& stream, const View& solution);
+    };
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = View;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const View*;
+        using reference = View;
+
+        const_iterator(const SolutionCollection* collection, size_t index): m_collection(collection), m_index(index) {}
+
+        View operator*() const { return (*m_collection)[m_index]; }
+        const_iterator& operator++() { m_index++; return *this; }
+        const_iterator operator++(int) { const_iterator it = *this; m_index++; return it; }
+        bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+
+    private:
+        const SolutionCollection* m_collection;
+        size_t m_index;
+    };
+
+    /**
+     * \brief Allocate memory for \p max_solutions solutions of \p n_particles particles each
+     *
+     * The collection is cleared. Exceeding the capacity is still possible, at the price of a memory allocation.
+     */
+    void reserve(size_t max_solutions, size_t n_particles);
+
+    /**
+     * \brief Append a solution
+     *
+     * \param values Particles of the solution. Their number must match the one given to reserve(),
+     *                or the one of the first solution if reserve() was not called.
+     */
+    void push_back(std::initializer_list<LorentzVector> values, double jacobian, bool valid = true) {
+        push_back(values.begin(), values.size(), jacobian, valid);
+    }
+
+    /// Append a copy of \p solution
+    void push_back(const Solution& solution) {
+        push_back(solution.values.data(), solution.values.size(), solution.jacobian, solution.valid);
+    }
+
+    /// Append a solution made of the \p n_particles particles starting at \p values
+    void push_back(const LorentzVector* values, size_t n_particles, double jacobian, bool valid = true);
+
+    /// Remove all the solutions, keeping the memory
+    void clear() { m_size = 0; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    size_t capacity() const { return m_jacobians.size(); }
+
+    /// \return The number of particles of each solution
+    size_t particlesPerSolution() const { return m_n_particles; }
+
+    View operator[](size_t i) const {
+        return {Particles(&m_values[i * m_n_particles], m_n_particles), m_jacobians[i], m_valid[i] != 0};
+    }
+
+    View at(size_t i) const {
+        if (i >= m_size)
+            throw std::out_of_range("Invalid solution index");
+        return (*this)[i];
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, m_size); }
+
+    friend std::ostream& operator<< (std::ostream& stream, const SolutionCollection& solutions);
+
+private:
+    size_t m_size = 0;
+    size_t m_n_particles = 0;
+
+    std::vector<LorentzVector> m_values; ///< Particles, solution after solution
+    std::vector<double> m_jacobians;
+    std::vector<char> m_valid;
+};
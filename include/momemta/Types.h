@@ -19,10 +19,20 @@
 
 #pragma once
 
+#include <momemta/config.h>
+
+#ifdef ROOT_FREE_CORE
+#include <momemta/FourVector.h>
+#else
 #include <Math/Vector4D.h>
+#endif
 
 #include <functional>
 #include <vector>
 
+#ifdef ROOT_FREE_CORE
+using LorentzVector = momemta::FourVector;
+#else
 using LorentzVector = ROOT::Math::LorentzVector<ROOT::Math::PxPyPzE4D<double>>;
+#endif
 using LorentzVectorRefCollection = std::vector<std::reference_wrapper<const LorentzVector>>;
\ No newline at end of file
@@ -35,6 +35,20 @@ template <class T> std::vector<typename T::Scalar> toVector(const T& v) {
     return {v.E(), v.Px(), v.Py(), v.Pz()};
 }
 
+/*!
+ * \brief Convert a LorentzVector to a vector of real number, reusing the memory of \p out
+ *
+ * \param v The LorentzVector to convert
+ * \param out Filled with 4 entries: [E, Px, Py, Pz]. No memory is allocated if it already has 4 entries.
+ */
+template <class T> void toVector(const T& v, std::vector<typename T::Scalar>& out) {
+    out.resize(4);
+    out[0] = v.E();
+    out[1] = v.Px();
+    out[2] = v.Py();
+    out[3] = v.Pz();
+}
+
 /*!
  * Compute the array of permutation needed to go from vector `from` to vector `to`
  *
@@ -23,6 +23,7 @@
 
 #include <assert.h>
 #include <memory>
+#include <type_traits>
 #include <unordered_map>
 
 #include <momemta/any.h>
@@ -37,6 +38,9 @@ template <typename T> Value<T> Pool::get(const InputTag& tag) const {
 
     auto it = m_storage.find(tag);
     if (it == m_storage.end()) {
+        if (m_parent && m_parent->exists(tag))
+            return Value<T>(ValueProxy<const T>::create(m_parent.get(), tag));
+
         if (tag.isIndexed()) {
             it = create<std::vector<T>>(tag, false);
         } else {
@@ -58,8 +62,12 @@ template <typename T> Value<T> Pool::get(const InputTag& tag) const {
 template <typename T> std::shared_ptr<const T> Pool::raw_get(const InputTag& tag) const {
 
     auto it = m_storage.find(tag);
-    if (it == m_storage.end())
+    if (it == m_storage.end()) {
+        if (m_parent)
+            return m_parent->raw_get<T>(tag);
+
         throw tag_not_found_error("No such tag in pool: " + tag.toString());
+    }
 
     PoolContent& v = it->second;
 
@@ -82,12 +90,20 @@ template <typename T, typename... Args> std::shared_ptr<T> Pool::put(const Input
     if (it != m_storage.end()) {
         if (it->second.valid)
             throw duplicated_tag_error("A module already produced the tag '" + tag.toString() + "'");
-        // A module already requested this block in read-mode. This will only work if the block does not require a non-trivial constructor:
-        if (sizeof...(Args))
-            throw constructor_tag_error("A module already requested the tag '" + tag.toString()
-                                                + "' which seems to require a constructor call. This is currently not supported.");
+        if (sizeof...(Args)) {
+            // A module already requested this block in read-mode. This will only work if the block does not require a non-trivial constructor,
+            // unless the block is produced again by a re-created module: it is then initialized again in place
+            if (!it->second.reproduced || it->second.ptr.empty())
+                throw constructor_tag_error("A module already requested the tag '" + tag.toString()
+                                                    + "' which seems to require a constructor call. This is currently not supported.");
+
+            T& block = *momemta::any_cast<std::shared_ptr<T>&>(it->second.ptr);
+            reinitialize(std::integral_constant<bool, std::is_move_assignable<T>::value>(), block, tag,
+                         std::forward<Args>(args)...);
+        }
         // Since the memory is allocated, simply consider the block as valid.
         it->second.valid = true;
+        it->second.reproduced = false;
 
         // If the block is empty, it's a delayed instantiation. Simply flag the block as valid, and allocate memory for it
         if (it->second.ptr.empty()) {
@@ -110,7 +126,18 @@ template <typename T, typename... Args> Pool::PoolStorage::iterator Pool::create
         const InputTag& tag, bool valid/* = true*/, Args&&... args) const {
 
     auto ptr = std::make_shared<T>(std::forward<Args>(args)...);
-    PoolContent content = {momemta::any(ptr), valid};
+    PoolContent content = {momemta::any(ptr), valid, false};
 
     return m_storage.emplace(tag, content).first;
 }
+
+template <typename T, typename... Args> void Pool::reinitialize(std::true_type, T& block, const InputTag&,
+        Args&&... args) {
+    block = T(std::forward<Args>(args)...);
+}
+
+template <typename T, typename... Args> void Pool::reinitialize(std::false_type, T&, const InputTag& tag,
+        Args&&...) {
+    throw constructor_tag_error("The tag '" + tag.toString() + "' requires a constructor call, but its type cannot be "
+                                "assigned: the module producing it cannot be re-created.");
+}
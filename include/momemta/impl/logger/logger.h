@@ -84,6 +84,7 @@ public:
 
 private:
     bool _valid;
+    bool _enabled; ///< False if the level of the message is filtered: the message is neither formatted nor logged
     ::logger::logger& _logger;
     ::logging::level::level_enum _lvl;
     std::ostringstream _stream;
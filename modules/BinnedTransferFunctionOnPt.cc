@@ -16,20 +16,23 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <momemta/FourVector.h>
+#include <momemta/BinnedTable2D.h>
+#include <momemta/BinnedTableSampler.h>
 #include <momemta/Logging.h>
 #include <momemta/Module.h>
 #include <momemta/ParameterSet.h>
 #include <momemta/Types.h>
 #include <momemta/Math.h>
 
-#include <TFile.h>
-#include <TH2.h>
-#include <TAxis.h>
-
 /** \brief Helper class for binned transfer function modules
  *
  * Base class helping to binned define TF modules having different behaviours (allowing either to integrate over a TF, or simply evaluate it).
- * The class handles opening the TFile, loading the histograms, computing the ranges, ...
+ * The class handles loading the table, computing the ranges, ...
+ *
+ * The TF is evaluated using a flat lookup table (see momemta::BinnedTable2D), loaded either from a ROOT file
+ * (the TH2 is converted when the module is created) or from a file in the native binary format (mapped in memory).
+ * All the modules using the same table share a single copy.
  *
  * \sa BinnedTransferFunctionOnPt
  * \sa BinnedTransferFunctionOnPtEvaluator
@@ -43,41 +46,32 @@ class BinnedTransferFunctionOnPtBase: public Module {
             std::string file_path = parameters.get<std::string>("file");
             std::string th2_name = parameters.get<std::string>("th2_name");
 
-            std::unique_ptr<TFile> file(TFile::Open(file_path.c_str()));
-            if(!file->IsOpen() || file->IsZombie())
-                throw file_not_found_error("Could not open file " + file_path);
-
-            m_th2 = std::unique_ptr<TH2>(static_cast<TH2*>(file->Get(th2_name.c_str())));
-            if(!m_th2->InheritsFrom("TH2") || !m_th2.get())
-                throw th2_not_found_error("Could not retrieve object " + th2_name + " deriving from class TH2 in file " + file_path + ".");
-            m_th2->SetDirectory(0);
+            // Tables are shared between all the modules using the same file
+            m_table = momemta::BinnedTable2D::load(file_path, th2_name);
 
-            TAxis* yAxis = m_th2->GetYaxis();
-            m_deltaMin = yAxis->GetXmin();
-            m_deltaMax = yAxis->GetXmax();
+            const auto& yAxis = m_table->yAxis();
+            m_deltaMin = yAxis.min();
+            m_deltaMax = yAxis.max();
             m_deltaRange = m_deltaMax - m_deltaMin;
             
-            TAxis* xAxis = m_th2->GetXaxis();
+            const auto& xAxis = m_table->xAxis();
             double Pt_cut = parameters.get<double>("min_Pt", 0.);
-            m_PtgenMin = std::max(xAxis->GetXmin(), Pt_cut);
-            m_PtgenMax = xAxis->GetXmax();
+            m_PtgenMin = std::max(xAxis.min(), Pt_cut);
+            m_PtgenMax = xAxis.max();
 
             // Since we assume the TF continues as a constant for Pt->infty,
             // we need to be able to retrieve the X axis' last bin, to avoid
             // fetching the TH2's overflow bin.
-            m_fallBackPtgenMax = xAxis->GetBinCenter(xAxis->GetNbins());
+            m_fallBackPtgenMax = xAxis.binCenter(xAxis.nBins());
             
-            LOG(debug) << "Loaded TH2 " << th2_name << " from file " << file_path << ".";
+            LOG(debug) << "Using table " << th2_name << " from file " << file_path << ".";
             LOG(debug) << "\tDelta range is " << m_deltaMin << " to " << m_deltaMax << ".";
             LOG(debug) << "\tPt range is " << m_PtgenMin << " to " << m_PtgenMax << ".";
             LOG(debug) << "\tWill use values at Ptgen = " << m_fallBackPtgenMax << " for out-of-range values.";
-
-            file->Close();
-            file.reset();
         };
 
     protected:
-        std::unique_ptr<TH2> m_th2;
+        std::shared_ptr<const momemta::BinnedTable2D> m_table;
 
         double m_deltaMin, m_deltaMax, m_deltaRange;
         double m_PtgenMin, m_PtgenMax;
@@ -85,15 +79,6 @@ class BinnedTransferFunctionOnPtBase: public Module {
 
         // Input
         Value<LorentzVector> m_reco_input;
-
-    private:
-        class file_not_found_error: public std::runtime_error{
-            using std::runtime_error::runtime_error;
-        };
-        
-        class th2_not_found_error: public std::runtime_error{
-            using std::runtime_error::runtime_error;
-        };
 };
 
 /** \brief Integrate over a transfer function on Pt described by a 2D histogram retrieved from a ROOT file.
@@ -110,6 +95,16 @@ class BinnedTransferFunctionOnPtBase: public Module {
  * The integration is done over the whole width of the TF. The TF is assumed to continue asymptotically as a
  * constant for \f$P_T_{gen} \to \infty\f$.
  *
+ * ### Sampling
+ *
+ * By default, the phase-space point is mapped linearly onto the integration range. Binned TFs are often sharply
+ * peaked, so that most of the points are then spent in the tails of the TF. If `sampling` is set to `cdf`, the
+ * phase-space point is instead mapped through the inverse of the cumulative distribution, along the Y-axis, of the
+ * column of the histogram at \f$P_T_{gen} = P_T_{rec}\f$, restricted to the integration range. This distribution is
+ * mixed with a uniform distribution (with a weight set by `uniform_fraction`), so that regions where this column is
+ * empty but the TF is not are still sampled. The jacobian of this transformation almost cancels the TF, and the
+ * result of the integration is the same for both modes.
+ *
  * ### Integration dimension
  *
  * This module requires **1** phase-space point.
@@ -118,8 +113,10 @@ class BinnedTransferFunctionOnPtBase: public Module {
  *
  *   | Name | Type | %Description |
  *   |------|------|--------------|
- *   | `file` | string | Path to the ROOT file in which the transfer function is saved. |
- *   | `th2_name` | string | Name of the TH2 stored in file `file` |
+ *   | `file` | string | Path to the ROOT file in which the transfer function is saved, or to a file in the native table format (see momemta::BinnedTable2D). |
+ *   | `th2_name` | string | Name of the TH2 (or of the table) stored in file `file` |
+ *   | `sampling` | string, default `uniform` | How the phase-space point is mapped onto the integration range: `uniform` or `cdf` (see above explanation). |
+ *   | `uniform_fraction` | double, default `0.1` | Fraction of uniform sampling mixed with the TF distribution when `sampling` is `cdf`. Must be strictly positive, and at most 1. |
  *   | `min_Pt` | double | Optional: cut on Pt to avoid divergences |
  *
  * ### Inputs
@@ -144,34 +141,61 @@ class BinnedTransferFunctionOnPt: public BinnedTransferFunctionOnPtBase {
 
         BinnedTransferFunctionOnPt(PoolPtr pool, const ParameterSet& parameters): BinnedTransferFunctionOnPtBase(pool, parameters) {
             m_ps_point = get<double>(parameters.get<InputTag>("ps_point"));
+
+            std::string sampling = parameters.get<std::string>("sampling", "uniform");
+            if (sampling == "cdf") {
+                m_uniform_fraction = parameters.get<double>("uniform_fraction", 0.1);
+                // Without uniform sampling, regions where the TF is not zero but the column is empty would never be sampled
+                if (!(m_uniform_fraction > 0) || m_uniform_fraction > 1) {
+                    LOG(fatal) << "Invalid uniform fraction " << m_uniform_fraction << ". It must be in ]0, 1].";
+                    throw Module::invalid_configuration("Invalid uniform fraction");
+                }
+
+                m_sampler.reset(new momemta::BinnedTableSampler(m_table));
+            } else if (sampling != "uniform") {
+                LOG(fatal) << "Unknown sampling mode '" << sampling << "'. Valid modes are 'uniform' and 'cdf'.";
+                throw Module::invalid_configuration("Unknown sampling mode");
+            }
         }
         
         virtual Status work() override {
-            const double rec_Pt = m_reco_input->Pt();
-            const double cosh_eta = std::cosh(m_reco_input->Eta());
+            const momemta::FourVector reco(*m_reco_input);
+            const double rec_Pt = reco.Pt();
+            // cosh(eta) = |P| / Pt
+            const double cosh_eta = reco.P() / rec_Pt;
             const double range = GetDeltaRange(rec_Pt);
-            const double gen_Pt = rec_Pt - GetDeltaMax(rec_Pt) + range * (*m_ps_point);
+
+            double gen_Pt;
+            double jacobian;
+            if (m_sampler && range > 0) {
+                // Sample delta following the column of the TF at Pt_gen = Pt_rec
+                double density;
+                const size_t column = m_sampler->column(std::min(std::max(rec_Pt, m_PtgenMin), m_fallBackPtgenMax));
+                gen_Pt = rec_Pt - m_sampler->sample(column, m_deltaMin, GetDeltaMax(rec_Pt), m_uniform_fraction, *m_ps_point, density);
+                // A point in an empty region of the distribution has no weight
+                jacobian = (density > 0) ? 1. / density : 0.;
+            } else {
+                gen_Pt = rec_Pt - GetDeltaMax(rec_Pt) + range * (*m_ps_point);
+                jacobian = range;
+            }
             const double delta = rec_Pt - gen_Pt;
 
             // To change the particle's Pt without changing its direction and mass:
-            const double gen_E = std::sqrt(SQ(m_reco_input->M()) + SQ(cosh_eta * gen_Pt));
-            output->SetCoordinates(
-                    gen_Pt * std::cos(m_reco_input->Phi()),
-                    gen_Pt * std::sin(m_reco_input->Phi()),
-                    gen_Pt * std::sinh(m_reco_input->Eta()),
-                    gen_E);
+            const double gen_E = std::sqrt(SQ(reco.M()) + SQ(cosh_eta * gen_Pt));
+            *output = reco.withPt(gen_Pt, gen_E).toLorentzVector();
 
-            // The bin number is a ROOT "global bin number" using a 1D representation of the TH2
-            const int bin = m_th2->FindFixBin(std::min(gen_Pt, m_fallBackPtgenMax), delta);
-            
             // Compute TF*jacobian, where the jacobian includes the transformation of [0,1]->[range_min,range_max] and d|P|/dP_T = cosh(eta)
-            *TF_times_jacobian = m_th2->GetBinContent(bin) * range * cosh_eta;
+            *TF_times_jacobian = (*m_table)(std::min(gen_Pt, m_fallBackPtgenMax), delta) * jacobian * cosh_eta;
 
             return Status::OK;
         }
 
     private:
 
+        // Only set when sampling from the TF
+        std::unique_ptr<momemta::BinnedTableSampler> m_sampler;
+        double m_uniform_fraction;
+
         // Input
         Value<double> m_ps_point;
  
@@ -209,8 +233,8 @@ class BinnedTransferFunctionOnPt: public BinnedTransferFunctionOnPtBase {
  *
  *   | Name | Type | %Description |
  *   |------|------|--------------|
- *   | `file` | string | Path to the ROOT file in which the transfer function is saved. |
- *   | `th2_name` | string | Name of the TH2 stored in file `file` |
+ *   | `file` | string | Path to the ROOT file in which the transfer function is saved, or to a file in the native table format (see momemta::BinnedTable2D). |
+ *   | `th2_name` | string | Name of the TH2 (or of the table) stored in file `file` |
  *
  * ### Inputs
  *
@@ -244,11 +268,8 @@ class BinnedTransferFunctionOnPtEvaluator: public BinnedTransferFunctionOnPtBase
                 return Status::OK;
             }
 
-            // The bin number is a ROOT "global bin number" using a 1D representation of the TH2
-            const int bin = m_th2->FindFixBin(std::min(gen_Pt, m_fallBackPtgenMax), delta);
-            
             // Retrieve TF value
-            *TF_value = m_th2->GetBinContent(bin);
+            *TF_value = (*m_table)(std::min(gen_Pt, m_fallBackPtgenMax), delta);
 
             return Status::OK;
         }
@@ -93,6 +93,9 @@ class BlockA: public Module {
                 LOG(fatal) << exception.what();
                 throw exception;
             }
+
+            // At most 1 solution, with 2 particles each
+            solutions->reserve(1, 2);
         };
  
         virtual Status work() override {
@@ -120,8 +123,8 @@ class BlockA: public Module {
             //        p2x=modp2*sin(theta2)*cos(phi2), p2y=modp2*sin(theta2)*sin(phi2)
             // Get modp1, modp2 as solutions of this system
 
-            std::vector<double> modp1;
-            std::vector<double> modp2;
+            Roots modp1;
+            Roots modp2;
 
             const double sin_theta1 = std::sin(theta1);
             const double cos_phi1 = std::cos(phi1);
@@ -165,8 +168,7 @@ class BlockA: public Module {
             double jacobian = (SQ(mod_p1) * SQ(mod_p2)) / (8 * SQ(M_PI * sqrt_s) * E1 * E2);
             jacobian *= 1. / std::abs(cos_phi1 * sin_phi2 - sin_phi1 * cos_phi2);
 
-            Solution s = { {gen_p1, gen_p2}, jacobian, true };
-            solutions->push_back(s);
+            solutions->push_back({gen_p1, gen_p2}, jacobian);
 
             return Status::OK;
         }
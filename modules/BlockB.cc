@@ -113,6 +113,9 @@ class BlockB: public Module {
             }
 
             m_met = get<LorentzVector>(met_tag);
+
+            // At most 2 solutions, with 1 particle each
+            solutions->reserve(2, 1);
         };
 
         virtual Status work() override {
@@ -154,7 +157,7 @@ class BlockB: public Module {
             const double b = - 2 * A * B;
             const double c = C - SQ(A) - p11;
 
-            std::vector<double> E1;
+            Roots E1;
 
             solveQuadratic(a, b, c, E1, false);
 
@@ -179,8 +182,7 @@ class BlockB: public Module {
  
                 const double inv_jacobian = SQ(sqrt_s) * std::abs(p2->Pz() * e1 - p2->E() * p1.Pz());
 
-                Solution s { {p1}, M_PI/inv_jacobian, true };
-                solutions->push_back(s);
+                solutions->push_back({p1}, M_PI/inv_jacobian);
             }
 
             return solutions->size() > 0 ? Status::OK : Status::NEXT;
@@ -107,6 +107,9 @@ public:
             met_tag = InputTag({"met", "p4"});
         }
         m_met = get<LorentzVector>(met_tag);
+
+        // At most 4 solutions, with 2 particles each
+        solutions->reserve(4, 2);
     };
 
     virtual Status work() override {
@@ -196,7 +199,7 @@ public:
         const double b00 = gamma4 * (-gamma1 * sinthe3 * cosphi3 - gamma2 * sinthe3 * sinphi3 - gamma3 * costhe3);
 
         // Find the intersection of the 2 conics (at most 4 real solutions for (e1,ALPHA))
-        std::vector<double> e1, ALPHA;
+        Roots e1, ALPHA;
         solve2Quads(a11, a22, a12, a10, a01, a00, b11, b22, b12, b10, b01, b00, e1, ALPHA, false);
 
         // For each solution (e1,ALPHA), find the neutrino 4-momentum p1
@@ -243,8 +246,7 @@ public:
             double jacobian = E3 * sinthe3 / (16 * SQ(M_PI) * SQ(sqrt_s) *
                                               std::abs(chi * (E2 * p1z - E1 * p2z) + 2 * E2 * (A + B + C + D)));
 
-            Solution s{{p1, p3_sol}, jacobian, true};
-            solutions->push_back(s);
+            solutions->push_back({p1, p3_sol}, jacobian);
         }
 
         return solutions->size() > 0 ? Status::OK : Status::NEXT;
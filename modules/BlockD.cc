@@ -120,6 +120,9 @@ class BlockD: public Module {
             }
 
             m_met = get<LorentzVector>(met_tag);
+
+            // At most 4 solutions, with 2 particles each
+            solutions->reserve(4, 2);
         };
 
         virtual Status work() override {
@@ -227,7 +230,7 @@ class BlockD: public Module {
             const double b00 = SQ(gamma5) + SQ(gamma6) + SQ(gamma4) + p22;
 
             // Find the intersection of the 2 conics (at most 4 real solutions for (E1,E2))
-            std::vector<double> E1, E2;
+            Roots E1, E2;
             solve2Quads(a11, a22, a12, a10, a01, a00, b11, b22, b12, b10, b01, b00, E1, E2, false);
 
             // For each solution (E1,E2), find the neutrino 4-momenta p1,p2
@@ -265,8 +268,7 @@ class BlockD: public Module {
                     continue;
 
                 double jacobian = computeJacobian(p1, p2, p3, p4, p5, p6);
-                Solution s { {p1, p2}, jacobian, true };
-                solutions->push_back(s);
+                solutions->push_back({p1, p2}, jacobian);
             }
 
             return solutions->size() > 0 ? Status::OK : Status::NEXT;
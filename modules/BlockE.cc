@@ -112,6 +112,9 @@ class BlockE: public Module {
                 for (auto& t: branches_tags)
                     m_branches.push_back(get<LorentzVector>(t));
             }
+
+            // At most 2 solutions, with 2 particles each
+            solutions->reserve(2, 2);
         };
 
         virtual Status work() override {
@@ -132,7 +135,7 @@ class BlockE: public Module {
  
             const double p4x = p4->Px();
             const double p4y = p4->Py();
-            const double p4z = p4->pz();
+            const double p4z = p4->Pz();
             const double E4 = p4->E();
  
             const double sq_m1 = SQ(m1);
@@ -208,7 +211,7 @@ class BlockE: public Module {
             const double a01 = - 2 * (B1x * C1x + B1z * C1z + pby);
             const double a00 = SQ(Etot) - (SQ(C1x) + SQ(C1z) + SQ(pby) + sq_m1);
  
-            std::vector<double> p2y_sol;
+            Roots p2y_sol;
             const bool foundSolution = solveQuadratic(a02 + SQ(a) * a20 + a * a11, 
                                                 2 * a * b * a20 + b * a11 + a01 + a * a10,
                                                 SQ(b) * a20 + b * a10 + a00,
@@ -247,8 +250,7 @@ class BlockE: public Module {
 
                 const double jacobian = 1. / (64 * SQ(M_PI) * s * std::abs(E4*(p1z*p2y*p3x - p1y*p2z*p3x - p1z*p2x*p3y + p1x*p2z*p3y + p1y*p2x*p3z - p1x*p2y*p3z) +  E2*p1z*p3y*p4x - E1*p2z*p3y*p4x - E2*p1y*p3z*p4x + E1*p2y*p3z*p4x - E2*p1z*p3x*p4y + E1*p2z*p3x*p4y +  E2*p1x*p3z*p4y - E1*p2x*p3z*p4y + (E2*p1y*p3x - E1*p2y*p3x - E2*p1x*p3y + E1*p2x*p3y)*p4z + E3*(-(p1z*p2y*p4x) + p1y*p2z*p4x + p1z*p2x*p4y - p1x*p2z*p4y - p1y*p2x*p4z + p1x*p2y*p4z)));
                 
-                Solution s { {p1, p2}, jacobian, true };
-                solutions->push_back(s);
+                solutions->push_back({p1, p2}, jacobian);
             }
 
             return solutions->size() > 0 ? Status::OK : Status::NEXT;
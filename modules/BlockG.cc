@@ -17,6 +17,7 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <momemta/FourVector.h>
 #include <momemta/Logging.h>
 #include <momemta/ParameterSet.h>
 #include <momemta/Module.h>
@@ -25,8 +26,6 @@
 #include <momemta/Utils.h>
 #include <momemta/Math.h>
 
-#include <Math/GenVector/VectorUtil.h>
-
 /** \brief Final (main) Block G, describing \f$X + s_{12} (\to p_1 p_2) + s_{34} (\to p_3 p_4)\f$
  *
  * This Block addresses the change of variables needed to pass from the standard phase-space
@@ -96,6 +95,9 @@ class BlockG: public Module {
                 for (auto& t: branches_tags)
                     m_branches.push_back(get<LorentzVector>(t));
             }
+
+            // At most 4 solutions, with 4 particles each
+            solutions->reserve(4, 4);
         };
  
         virtual Status work() override {
@@ -147,12 +149,12 @@ class BlockG: public Module {
             const double beta_2 = sin_theta_4 * sin_phi_1_4 / denom_2;
             const double gamma_2 = ( std::sin(phi_1) * pbx - std::cos(phi_1) * pby ) / denom_2;
 
-            const double cos_theta_34 = ROOT::Math::VectorUtil::CosTheta(p3, p4);
-            const double cos_theta_12 = ROOT::Math::VectorUtil::CosTheta(p1, p2);
+            const double cos_theta_34 = cosTheta(p3, p4);
+            const double cos_theta_12 = cosTheta(p1, p2);
             const double X = 0.5 * (*s34) / (1 - cos_theta_34);
             const double Y = 0.5 * (*s12) / (1 - cos_theta_12);
 
-            std::vector<double> gen_p3_solutions;
+            Roots gen_p3_solutions;
             solveQuartic(
                     alpha_1 * alpha_2,
                     alpha_1 * gamma_2 + gamma_1 * alpha_2,
@@ -171,10 +173,11 @@ class BlockG: public Module {
                 if (p1_sol < 0 || p2_sol < 0 || p3_sol < 0 || p4_sol < 0)
                     continue;
                 
-                LorentzVector gen_p1(p1_sol * sin_theta_1 * std::cos(phi_1), p1_sol * sin_theta_1 * std::sin(phi_1), p1_sol * std::cos(p1.Theta()), p1_sol);
-                LorentzVector gen_p2(p2_sol * sin_theta_2 * std::cos(phi_2), p2_sol * sin_theta_2 * std::sin(phi_2), p2_sol * std::cos(p2.Theta()), p2_sol);
-                LorentzVector gen_p3(p3_sol * sin_theta_3 * std::cos(phi_3), p3_sol * sin_theta_3 * std::sin(phi_3), p3_sol * std::cos(p3.Theta()), p3_sol);
-                LorentzVector gen_p4(p4_sol * sin_theta_4 * std::cos(phi_4), p4_sol * sin_theta_4 * std::sin(phi_4), p4_sol * std::cos(p4.Theta()), p4_sol);
+                // Massless particles, along the direction of the visible ones
+                LorentzVector gen_p1 = momemta::FourVector(p1).withMomentum(p1_sol, p1_sol).toLorentzVector();
+                LorentzVector gen_p2 = momemta::FourVector(p2).withMomentum(p2_sol, p2_sol).toLorentzVector();
+                LorentzVector gen_p3 = momemta::FourVector(p3).withMomentum(p3_sol, p3_sol).toLorentzVector();
+                LorentzVector gen_p4 = momemta::FourVector(p4).withMomentum(p4_sol, p4_sol).toLorentzVector();
 
                 // Check if solutions are physical
                 LorentzVector tot = gen_p1 + gen_p2 + gen_p3 + gen_p4 + pb;
@@ -190,8 +193,7 @@ class BlockG: public Module {
                         ) * SQ(sqrt_s) * sin_phi_2_1 );
                 jacobian *= ( sin_theta_3 * sin_theta_4 * p1_sol * p2_sol * p3_sol * p4_sol ) / ( 16 * pow(2*M_PI, 8) );
 
-                Solution s = { { gen_p1, gen_p2, gen_p3, gen_p4 }, jacobian, true };
-                solutions->push_back(s);
+                solutions->push_back({gen_p1, gen_p2, gen_p3, gen_p4}, jacobian);
             }
 
             if (!solutions->size())
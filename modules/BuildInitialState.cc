@@ -18,9 +18,7 @@
 
 #include <functional>
 
-#include <Math/Vector3D.h>
-#include <Math/Boost.h>
-
+#include <momemta/FourVector.h>
 #include <momemta/Module.h>
 #include <momemta/ParameterSet.h>
 #include <momemta/Types.h>
@@ -88,7 +86,8 @@ class BuildInitialState: public Module {
 
             partons->clear();
 
-            LorentzVectorRefCollection particles;
+            ParticleRefs particles(allocator<ParticleRef>());
+            particles.reserve(input_particles.size());
             for (auto& p: input_particles) {
                 particles.push_back(std::ref(*p));
             }
@@ -103,12 +102,14 @@ class BuildInitialState: public Module {
         }
 
     private:
-        using compute_initials_signature = std::function<void(const LorentzVectorRefCollection&)>;
+        using ParticleRef = std::reference_wrapper<const LorentzVector>;
+        using ParticleRefs = momemta::ArenaVector<ParticleRef>;
+        using compute_initials_signature = std::function<void(const ParticleRefs&)>;
 
         compute_initials_signature do_compute_initials;
 
         compute_initials_signature compute_initials_trivial =
-            [&](const LorentzVectorRefCollection& particles) {
+            [&](const ParticleRefs& particles) {
                 LorentzVector tot;
                 for (const auto& p: particles)
                     tot += p.get();
@@ -121,30 +122,26 @@ class BuildInitialState: public Module {
             };
 
         compute_initials_signature compute_initials_boost =
-            [&](const LorentzVectorRefCollection& particles) {
-                LorentzVector tot;
+            [&](const ParticleRefs& particles) {
+                momemta::FourVector tot;
                 for (const auto& p: particles)
-                    tot += p.get();
-                
-                // Define boost that puts the transverse total momentum vector in its CoM frame 
-                LorentzVector transverse_tot = tot;
-                transverse_tot.SetPz(0);
-                ROOT::Math::XYZVector isr_deBoost_vector( transverse_tot.BoostToCM() );
+                    tot += momemta::FourVector(p.get());
+
+                // Define boost that puts the transverse total momentum vector in its CoM frame
+                const double isr_deBoost_x = -tot.Px() / tot.E();
+                const double isr_deBoost_y = -tot.Py() / tot.E();
 
                 // In the "transverse" CoM frame, use total Pz and E to define initial longitudinal quark momenta
-                const ROOT::Math::Boost isr_deBoost( isr_deBoost_vector );
-                const ROOT::Math::PxPyPzEVector new_tot( isr_deBoost * tot );
+                const momemta::FourVector new_tot = tot.boosted(isr_deBoost_x, isr_deBoost_y, 0);
 
                 double q1Pz = (new_tot.Pz() + new_tot.E()) / 2.;
                 double q2Pz = (new_tot.Pz() - new_tot.E()) / 2.;
 
-                partons->push_back(LorentzVector(0., 0., q1Pz, std::abs(q1Pz)));
-                partons->push_back(LorentzVector(0., 0., q2Pz, std::abs(q2Pz)));
-
                 // Boost initial parton momenta by the opposite of the transverse boost needed to put the whole system in its CoM
-                const ROOT::Math::Boost isr_boost( -isr_deBoost_vector );
-                (*partons)[0] = isr_boost * (*partons)[0];
-                (*partons)[1] = isr_boost * (*partons)[1];
+                const momemta::FourVector q1(0., 0., q1Pz, std::abs(q1Pz));
+                const momemta::FourVector q2(0., 0., q2Pz, std::abs(q2Pz));
+                partons->push_back(q1.boosted(-isr_deBoost_x, -isr_deBoost_y, 0).toLorentzVector());
+                partons->push_back(q2.boosted(-isr_deBoost_x, -isr_deBoost_y, 0).toLorentzVector());
             };
 
         double halved_sqrt_s;
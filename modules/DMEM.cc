@@ -18,13 +18,62 @@
 
 #include <TH1D.h>
 
+#include <memory>
+
+#include <momemta/Histogram.h>
+#include <momemta/Logging.h>
 #include <momemta/ParameterSet.h>
 #include <momemta/Module.h>
 #include <momemta/Types.h>
 
-/*
+#include <ShardedHistogram.h>
+
+/**
  * \brief Module implementing the Differential MEM
  *
+ * Histogram the integrand as a function of one or several observables: each phase-space point fills the histogram of
+ * each observable with a weight \f$ |M|^2 \times w_{ps} \f$, so that the integral of the histograms is the weight of
+ * the event, and their shape the contribution of each bin of the observable to this weight.
+ *
+ * The first observable is the invariant mass of the sum of `particles`, if set. Any other quantity can be added
+ * through `observables`. All the histograms share the same binning.
+ *
+ * Histograms are accumulated in memory shared between the processes, with one shard per process, so that filled bins
+ * are not lost when Cuba forks workers (`ncores` option). Shards are merged at the end of the integration, when the
+ * outputs are filled: `histograms` contains one momemta::Histogram per observable (use momemta::Histogram::toTH1D()
+ * to create a ROOT histogram), and `hist` a ROOT histogram of the first observable.
+ *
+ * When MoMEMta is built with the `ROOT_FREE_CORE` option, this module is part of the ROOT plugin: the configuration
+ * must call `load_root_plugin()` before declaring it.
+ *
+ * ### Integration dimension
+ *
+ * This module requires **0** phase-space point.
+ *
+ * ### Parameters
+ *
+ *   | Name | Type | %Description |
+ *   |------|------|--------------|
+ *   | `x_start` | double | Lower edge of the histograms. |
+ *   | `x_end` | double | Upper edge of the histograms. |
+ *   | `n_bins` | int | Number of bins of the histograms. |
+ *
+ * ### Inputs
+ *
+ *   | Name | Type | %Description |
+ *   |------|------|--------------|
+ *   | `particles` | vector(LorentzVector), optional | Particles whose invariant mass is histogrammed. |
+ *   | `observables` | vector(double), optional | Other observables to histogram. |
+ *   | `ps_weight` | double | Phase-space weight. |
+ *   | `me_output` | double | Output of the matrix element. |
+ *
+ * ### Outputs
+ *
+ *   | Name | Type | %Description |
+ *   |------|------|--------------|
+ *   | `hist` | TH1D | Histogram of the first observable, filled at the end of the integration. |
+ *   | `histograms` | vector(momemta::Histogram) | Histogram of each observable, filled at the end of the integration. |
+ *
  * \ingroup modules
  */
 
@@ -36,33 +85,70 @@ class DMEM: public Module {
             x_end = parameters.get<double>("x_end");
             n_bins = parameters.get<int64_t>("n_bins");
 
+            if (n_bins < 1 || !(x_start < x_end)) {
+                LOG(fatal) << "Invalid binning for DMEM module " << name() << ": " << n_bins << " bins between "
+                           << x_start << " and " << x_end << ".";
+                throw Module::invalid_configuration("Invalid binning");
+            }
+
             m_hist = produce<TH1D>("hist", (name() + "_DMEM").c_str(), (name() + "_DMEM").c_str(), n_bins, x_start, x_end);
             m_hist->SetDirectory(0);
 
-            auto particle_tags = parameters.get<std::vector<InputTag>>("particles");
+            auto particle_tags = parameters.get<std::vector<InputTag>>("particles", {});
             for (auto& t: particle_tags)
               m_particles.push_back(get<LorentzVector>(t));
 
+            auto observable_tags = parameters.get<std::vector<InputTag>>("observables", {});
+            for (auto& t: observable_tags)
+                m_observables.push_back(get<double>(t));
+
+            const size_t n_histograms = (m_particles.empty() ? 0 : 1) + m_observables.size();
+            if (n_histograms == 0) {
+                LOG(fatal) << "DMEM module " << name() << ": at least one of 'particles' or 'observables' must be set.";
+                throw Module::invalid_configuration("No observable to histogram");
+            }
+
+            m_accumulator = std::make_shared<ShardedHistogram>(n_histograms, n_bins, x_start, x_end);
+
             psWeight = get<double>(parameters.get<InputTag>("ps_weight"));
             meOutput = get<double>(parameters.get<InputTag>("me_output"));
         }
 
         virtual void beginIntegration() override {
-            m_hist->Reset();
+            m_accumulator->reset();
         }
 
         virtual Status work() override {
-            
-            LorentzVector tot;
-            for (const auto& v: m_particles)
-                tot += *v;
+            const double weight = *meOutput * (*psWeight);
+
+            size_t histogram = 0;
+            if (!m_particles.empty()) {
+                LorentzVector tot;
+                for (const auto& v: m_particles)
+                    tot += *v;
+
+                m_accumulator->fill(histogram++, tot.M(), weight);
+            }
 
-            // Fill histogram
-            m_hist->Fill(tot.M(), *meOutput * (*psWeight));
+            for (const auto& observable: m_observables)
+                m_accumulator->fill(histogram++, *observable, weight);
 
             return Status::OK;
         }
 
+        virtual void endIntegration() override {
+            m_histograms->clear();
+            for (size_t i = 0; i < m_accumulator->size(); i++)
+                m_histograms->push_back(m_accumulator->merge(i));
+
+            m_histograms->front().fillTH1D(*m_hist);
+        }
+
+        virtual void merge(const Module& other) override {
+            // Move what the copy filled for this process into our own accumulator
+            m_accumulator->absorb(*static_cast<const DMEM&>(other).m_accumulator);
+        }
+
         virtual bool leafModule() const override {
             return true;
         }
@@ -72,12 +158,16 @@ class DMEM: public Module {
         double x_start, x_end;
         int64_t n_bins;
 
+        std::shared_ptr<ShardedHistogram> m_accumulator;
+
         // Inputs
         std::vector<Value<LorentzVector>> m_particles;
+        std::vector<Value<double>> m_observables;
         Value<double> psWeight;
         Value<double> meOutput;
 
         // Outputs
         std::shared_ptr<TH1D> m_hist;
+        std::shared_ptr<std::vector<momemta::Histogram>> m_histograms = produce<std::vector<momemta::Histogram>>("histograms");
 };
 REGISTER_MODULE(DMEM);
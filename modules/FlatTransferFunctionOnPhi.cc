@@ -21,7 +21,7 @@
 #include <momemta/Types.h>
 #include <momemta/Utils.h>
 
-#include <Math/RotationZ.h>
+#include <cmath>
 
 /** \brief Flat transfer function on Phi (mainly for testing purposes). 
  *
@@ -68,9 +68,13 @@ class FlatTransferFunctionOnPhi: public Module {
             const double& ps_point = *m_ps_point;
             const LorentzVector& reco_particle = *m_input;
 
-            m_Rotation.SetAngle(2*M_PI*ps_point);
+            // Rotation around the Z axis
+            const double cos_phi = std::cos(2*M_PI*ps_point);
+            const double sin_phi = std::sin(2*M_PI*ps_point);
 
-            *output = m_Rotation*reco_particle;
+            output->SetPxPyPzE(cos_phi*reco_particle.Px() - sin_phi*reco_particle.Py(),
+                               sin_phi*reco_particle.Px() + cos_phi*reco_particle.Py(),
+                               reco_particle.Pz(), reco_particle.E());
             
             // Compute TF*jacobian, ie the jacobian of the transformation of [0,1]->[0,2pi]
             *TF_times_jacobian = 2*M_PI;
@@ -79,8 +83,6 @@ class FlatTransferFunctionOnPhi: public Module {
         }
 
     private:
-        ROOT::Math::RotationZ m_Rotation;
-
         // Inputs
         Value<double> m_ps_point;
         Value<LorentzVector> m_input;
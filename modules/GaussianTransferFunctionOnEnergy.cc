@@ -17,14 +17,13 @@
  */
 
 
+#include <momemta/FourVector.h>
 #include <momemta/Logging.h>
 #include <momemta/Module.h>
 #include <momemta/ParameterSet.h>
 #include <momemta/Types.h>
 #include <momemta/Math.h>
 
-#include <Math/DistFunc.h>
-
 /** \brief Helper class for Gaussian transfer function modules
  *
  * Base class helping to define TF modules having different behaviours (allowing either to integrate over a TF, or simply evaluate it).
@@ -63,6 +62,14 @@ class GaussianTransferFunctionOnEnergyBase: public Module {
  *
  * The range of the integration is determined using the width of the Gaussian at \f$E_{rec}\f$, integrating over a user-defined 'number of sigmas' `n`: \f$E_{gen} \in \pm n \cdot \sigma \cdot E_{rec}\f$.
  *
+ * ### Sampling
+ *
+ * By default, the phase-space point is mapped linearly onto the integration range. If `sampling` is set to `cdf`,
+ * the phase-space point is instead mapped through the inverse cumulative distribution function of a Gaussian centred on
+ * \f$E_{rec}\f$, with the width of the TF at \f$E_{rec}\f$, truncated to the integration range. The jacobian of this
+ * transformation almost cancels the TF, so that the integrand is nearly flat along this dimension, and the integrator
+ * does not need to learn the shape of the TF. The result of the integration is the same for both modes.
+ *
  * ### Integration dimension
  *
  * This module requires **1** phase-space point.
@@ -73,6 +80,7 @@ class GaussianTransferFunctionOnEnergyBase: public Module {
  *   |------|------|--------------|
  *   | `sigma` | double | Fraction of the energy yielding the width of the Gaussian distribution (with `sigma` at `0.1`, \f$\sigma_{gauss} = 0.1 \cdot E_{gen}\f$). |
  *   | `sigma_range` | double | Range of integration expressed in number of sigma. |
+ *   | `sampling` | string, default `uniform` | How the phase-space point is mapped onto the integration range: `uniform` or `cdf` (see above explanation). |
  *   | `min_E` | double | Optional: cut on energy to avoid divergences |
  * 
  * ### Inputs
@@ -96,35 +104,59 @@ class GaussianTransferFunctionOnEnergy: public GaussianTransferFunctionOnEnergyB
     public:
         GaussianTransferFunctionOnEnergy(PoolPtr pool, const ParameterSet& parameters): GaussianTransferFunctionOnEnergyBase(pool, parameters) {
             m_ps_point = get<double>(parameters.get<InputTag>("ps_point"));
+
+            std::string sampling = parameters.get<std::string>("sampling", "uniform");
+            if (sampling == "cdf") {
+                m_inverse_cdf = true;
+            } else if (sampling != "uniform") {
+                LOG(fatal) << "Unknown sampling mode '" << sampling << "'. Valid modes are 'uniform' and 'cdf'.";
+                throw Module::invalid_configuration("Unknown sampling mode");
+            }
         }
 
         virtual Status work() override {
+            const momemta::FourVector reco(*m_reco_input);
+            const double rec_M = reco.M();
+
             // Estimate the width over which to integrate using the width of the TF at E_rec ...
-            const double sigma_E_rec = m_reco_input->E() * m_sigma;
+            const double sigma_E_rec = reco.E() * m_sigma;
 
-            double range_min = std::max( { m_min_E, m_reco_input->M(), m_reco_input->E() - (m_sigma_range * sigma_E_rec) } );
-            double range_max = m_reco_input->E() + (m_sigma_range * sigma_E_rec);
+            double range_min = std::max( { m_min_E, rec_M, reco.E() - (m_sigma_range * sigma_E_rec) } );
+            double range_max = reco.E() + (m_sigma_range * sigma_E_rec);
             double range = (range_max - range_min);
 
-            double gen_E = range_min + range * (*m_ps_point);
-            double gen_pt = std::sqrt(SQ(gen_E) - SQ(m_reco_input->M())) / std::cosh(m_reco_input->Eta());
-
-            output->SetCoordinates(
-                    gen_pt * std::cos(m_reco_input->Phi()),
-                    gen_pt * std::sin(m_reco_input->Phi()),
-                    gen_pt * std::sinh(m_reco_input->Eta()),
-                    gen_E);
+            double gen_E;
+            double jacobian;
+            if (m_inverse_cdf) {
+                // Sample E_gen following a Gaussian of width sigma_E_rec centred on E_rec, truncated to the integration range
+                const double rec_E = reco.E();
+                const double cdf_min = normalCdf(range_min, sigma_E_rec, rec_E);
+                const double cdf_range = normalCdf(range_max, sigma_E_rec, rec_E) - cdf_min;
+
+                gen_E = rec_E + normalQuantile(cdf_min + cdf_range * (*m_ps_point), sigma_E_rec);
+                gen_E = std::min(std::max(gen_E, range_min), range_max);
+                jacobian = cdf_range / normalPdf(gen_E, sigma_E_rec, rec_E);
+            } else {
+                gen_E = range_min + range * (*m_ps_point);
+                jacobian = range;
+            }
+
+            // Keep the direction and the mass of the particle
+            const momemta::FourVector gen = reco.withMomentum(std::sqrt(SQ(gen_E) - SQ(rec_M)), gen_E);
+            *output = gen.toLorentzVector();
 
             // ... but compute the width of the TF at E_gen!
             const double sigma_E_gen = gen_E * m_sigma;
 
             // Compute TF*jacobian, where the jacobian includes the transformation of [0,1]->[range_min,range_max] and d|P|/dE
-            *TF_times_jacobian = ROOT::Math::normal_pdf(gen_E, sigma_E_gen, m_reco_input->E()) * range * dP_over_dE(*output);
+            *TF_times_jacobian = normalPdf(gen_E, sigma_E_gen, reco.E()) * jacobian * dP_over_dE(gen);
 
             return Status::OK;
         }
 
     private:
+        bool m_inverse_cdf = false;
+
         // Input
         Value<double> m_ps_point;
 
@@ -175,7 +207,7 @@ class GaussianTransferFunctionOnEnergyEvaluator: public GaussianTransferFunction
 
         virtual Status work() override {
             // Compute TF value
-            *TF_value = ROOT::Math::normal_pdf(m_gen_input->E(), m_gen_input->E() * m_sigma, m_reco_input->E());
+            *TF_value = normalPdf(m_gen_input->E(), m_gen_input->E() * m_sigma, m_reco_input->E());
 
             return Status::OK;
         }
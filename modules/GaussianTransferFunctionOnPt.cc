@@ -17,14 +17,13 @@
  */
 
 
+#include <momemta/FourVector.h>
 #include <momemta/Logging.h>
 #include <momemta/Module.h>
 #include <momemta/ParameterSet.h>
 #include <momemta/Types.h>
 #include <momemta/Math.h>
 
-#include <Math/DistFunc.h>
-
 /** \brief Helper class for Gaussian transfer function modules
  *
  * Base class helping to define TF modules having different behaviours (allowing either to integrate over a TF, or simply evaluate it).
@@ -63,6 +62,14 @@ class GaussianTransferFunctionOnPtBase: public Module {
  *
  * The range of the integration is determined using the width of the Gaussian at \f$P_T_{rec}\f$, integrating over a user-defined 'number of sigmas' `n`: \f$P_T_{gen} \in \pm n \cdot \sigma \cdot P_T_{rec}\f$.
  *
+ * ### Sampling
+ *
+ * By default, the phase-space point is mapped linearly onto the integration range. If `sampling` is set to `cdf`,
+ * the phase-space point is instead mapped through the inverse cumulative distribution function of a Gaussian centred on
+ * \f$P_T_{rec}\f$, with the width of the TF at \f$P_T_{rec}\f$, truncated to the integration range. The jacobian of this
+ * transformation almost cancels the TF, so that the integrand is nearly flat along this dimension, and the integrator
+ * does not need to learn the shape of the TF. The result of the integration is the same for both modes.
+ *
  * ### Integration dimension
  *
  * This module requires **1** phase-space point.
@@ -73,6 +80,7 @@ class GaussianTransferFunctionOnPtBase: public Module {
  *   |------|------|--------------|
  *   | `sigma` | double | Fraction of the Pt yielding the width of the Gaussian distribution (with `sigma` at `0.1`, \f$\sigma_{gauss} = 0.1 \cdot P_T_{gen}\f$). |
  *   | `sigma_range` | double | Range of integration expressed in number of sigma. |
+ *   | `sampling` | string, default `uniform` | How the phase-space point is mapped onto the integration range: `uniform` or `cdf` (see above explanation). |
  *   | `min_Pt` | double | Optional: cut on Pt to avoid divergences |
  * 
  * ### Inputs
@@ -96,38 +104,60 @@ class GaussianTransferFunctionOnPt: public GaussianTransferFunctionOnPtBase {
     public:
         GaussianTransferFunctionOnPt(PoolPtr pool, const ParameterSet& parameters): GaussianTransferFunctionOnPtBase(pool, parameters) {
             m_ps_point = get<double>(parameters.get<InputTag>("ps_point"));
+
+            std::string sampling = parameters.get<std::string>("sampling", "uniform");
+            if (sampling == "cdf") {
+                m_inverse_cdf = true;
+            } else if (sampling != "uniform") {
+                LOG(fatal) << "Unknown sampling mode '" << sampling << "'. Valid modes are 'uniform' and 'cdf'.";
+                throw Module::invalid_configuration("Unknown sampling mode");
+            }
         }
 
         virtual Status work() override {
+            const momemta::FourVector reco(*m_reco_input);
+            const double rec_Pt = reco.Pt();
+
             // Estimate the width over which to integrate using the width of the TF at Pt_rec ...
-            const double sigma_Pt_rec = m_reco_input->Pt() * m_sigma;
+            const double sigma_Pt_rec = rec_Pt * m_sigma;
 
-            const double cosh_eta = std::cosh(m_reco_input->Eta());
-            double range_min = std::max(m_min_Pt, m_reco_input->Pt() - (m_sigma_range * sigma_Pt_rec));
-            double range_max = m_reco_input->Pt() + (m_sigma_range * sigma_Pt_rec);
+            // cosh(eta) = |P| / Pt
+            const double cosh_eta = reco.P() / rec_Pt;
+            double range_min = std::max(m_min_Pt, rec_Pt - (m_sigma_range * sigma_Pt_rec));
+            double range_max = rec_Pt + (m_sigma_range * sigma_Pt_rec);
             double range = (range_max - range_min);
 
-            double gen_Pt = range_min + range * (*m_ps_point);
+            double gen_Pt;
+            double jacobian;
+            if (m_inverse_cdf) {
+                // Sample Pt_gen following a Gaussian of width sigma_Pt_rec centred on Pt_rec, truncated to the integration range
+                const double cdf_min = normalCdf(range_min, sigma_Pt_rec, rec_Pt);
+                const double cdf_range = normalCdf(range_max, sigma_Pt_rec, rec_Pt) - cdf_min;
+
+                gen_Pt = rec_Pt + normalQuantile(cdf_min + cdf_range * (*m_ps_point), sigma_Pt_rec);
+                gen_Pt = std::min(std::max(gen_Pt, range_min), range_max);
+                jacobian = cdf_range / normalPdf(gen_Pt, sigma_Pt_rec, rec_Pt);
+            } else {
+                gen_Pt = range_min + range * (*m_ps_point);
+                jacobian = range;
+            }
 
             // To change the particle's Pt without changing its direction and mass:
-            const double gen_E = std::sqrt(SQ(m_reco_input->M()) + SQ(cosh_eta * gen_Pt));
-            
-            output->SetCoordinates(
-                    gen_Pt * std::cos(m_reco_input->Phi()),
-                    gen_Pt * std::sin(m_reco_input->Phi()),
-                    gen_Pt * std::sinh(m_reco_input->Eta()),
-                    gen_E);
+            const double gen_E = std::sqrt(SQ(reco.M()) + SQ(cosh_eta * gen_Pt));
+            *output = reco.withPt(gen_Pt, gen_E).toLorentzVector();
 
             // ... but compute the width of the TF at Pt_gen!
             const double sigma_Pt_gen = gen_Pt * m_sigma;
 
             // Compute TF*jacobian, where the jacobian includes the transformation of [0,1]->[range_min,range_max] and d|P|/dPt = cosh(eta)
-            *TF_times_jacobian = ROOT::Math::normal_pdf(gen_Pt, sigma_Pt_gen, m_reco_input->Pt()) * range * cosh_eta;
+            *TF_times_jacobian = normalPdf(gen_Pt, sigma_Pt_gen, rec_Pt) * jacobian * cosh_eta;
 
             return Status::OK;
         }
 
     private:
+        bool m_inverse_cdf = false;
+
         // Input
         Value<double> m_ps_point;
 
@@ -178,7 +208,7 @@ class GaussianTransferFunctionOnPtEvaluator: public GaussianTransferFunctionOnPt
 
         virtual Status work() override {
             // Compute TF value
-            *TF_value = ROOT::Math::normal_pdf(m_gen_input->Pt(), m_gen_input->Pt() * m_sigma, m_reco_input->Pt());
+            *TF_value = normalPdf(m_gen_input->Pt(), m_gen_input->Pt() * m_sigma, m_reco_input->Pt());
 
             return Status::OK;
         }
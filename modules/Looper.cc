@@ -18,13 +18,20 @@
 
 #include <momemta/Module.h>
 
+#include <atomic>
+#include <memory>
 #include <vector>
 
+#include <unistd.h>
+
 #include <momemta/config.h>
+#include <momemta/ModuleFactory.h>
 #include <momemta/ParameterSet.h>
 #include <momemta/Path.h>
 #include <momemta/Solution.h>
 
+#include <ThreadTeam.h>
+
 #ifdef DEBUG_TIMING
 #include <chrono>
 using namespace std::chrono;
@@ -34,6 +41,11 @@ using namespace std::chrono;
         m->X(); \
     }
 
+#define CALL_LANES(X) { for (auto& lane: m_lanes) \
+        for (auto& m: lane.modules) \
+            m->X(); \
+    }
+
 /**
  * \brief A module looping over a set of solutions
  *
@@ -84,6 +96,31 @@ using namespace std::chrono;
  *  ───┬───
  * ```
  *
+ * ### Nested loopers
+ *
+ * When a Looper is the last module of the path of another Looper (typically when a secondary block is followed by a
+ * main block), both loops are flattened when the configuration is frozen: the outer Looper directly iterates over
+ * the solutions of the inner one, without going through the inner Looper module for each of its own solutions.
+ * As a consequence, the `beginLoop` and `endLoop` methods of the modules of the inner path are only called once per
+ * iteration of the outer Looper. Chains of more than two Loopers are flattened as well. Set `flatten` to `false` on
+ * the outer Looper to disable this behaviour.
+ *
+ * The `combined_jacobian` output holds the product of the jacobians of the current solutions of this Looper and of
+ * all the Loopers it's nested in, and can be used instead of listing the `jacobian` output of each Looper.
+ *
+ * ### Concurrent evaluation
+ *
+ * If `threads` is larger than 1, the solutions are evaluated concurrently by a team of threads, which shortens the
+ * time needed to evaluate one phase-space point when the path is expensive (matrix element evaluation, ...). Each
+ * thread runs its own copy of the modules of the path, created with the same parameters, and handles one solution out
+ * of `threads`. At the end of the loop, the results of the copies are merged into the original modules (see
+ * Module::merge), always in the same order, so that results are reproducible. Only the modules accumulating results
+ * over the solutions (like the LooperSummer modules) should be used outside of the path.
+ *
+ * Concurrent evaluation is not possible if the path contains another Looper. The modules of the path must also be
+ * thread-safe with respect to each other: for instance, two copies of a MatrixElement module must not share a
+ * non-reentrant matrix element library.
+ *
  * ### Integration dimension
  *
  * This module requires **0** phase-space point.
@@ -93,6 +130,8 @@ using namespace std::chrono;
  *   | Name | Type | %Description |
  *   |------|------|--------------|
  *   | `path` | Path | An execution path. For each solution, each module of the path will be executed in order. |
+ *   | `flatten` | bool, default `true` | Flatten a Looper ending the path into this one (see above explanation). |
+ *   | `threads` | int, default `1` | Number of threads used to evaluate the solutions (see above explanation). |
  *
  * ### Inputs
  *
@@ -106,6 +145,7 @@ using namespace std::chrono;
  *   |------|------|--------------|
  *   | `particles` | vector(LorentzVector) | The particles of the current solution. This output only makes sense for a module inside the execution path. For any other module, this output is invalid. |
  *   | `jacobian` | double | The jacobian of the current solution. This output only makes sense for a module inside the execution path. For any other module, this output is invalid. |
+ *   | `combined_jacobian` | double | The product of the jacobian of the current solution and of the jacobians of the current solutions of the enclosing Loopers. This output only makes sense for a module inside the execution path. For any other module, this output is invalid. |
  *
  * \ingroup modules
  */
@@ -116,19 +156,65 @@ class Looper: public Module {
             solutions = pool->get<SolutionCollection>(parameters.get<InputTag>("solutions"));
 
             path = parameters.get<Path>("path");
+            m_flatten = parameters.get<bool>("flatten", true);
+
+            m_threads = parameters.get<int64_t>("threads", 1);
+            if (m_threads < 1) {
+                LOG(fatal) << "Invalid number of threads " << m_threads << " for looper " << name() << ".";
+                throw Module::invalid_configuration("Invalid number of threads");
+            }
         };
 
+        virtual ~Looper() {
+            // Threads are not inherited by child processes: the team of the parent process must not be destroyed
+            if (m_team && m_team_pid != getpid())
+                m_team.release();
+        }
+
         virtual void configure() override {
             path.freeze();
             CALL(configure);
+
+            bool contains_looper = false;
+            for (const auto& m: path.modules()) {
+                Looper* looper = dynamic_cast<Looper*>(m.get());
+                if (looper) {
+                    looper->m_parent = this;
+                    contains_looper = true;
+                }
+            }
+
+            if (m_threads > 1 && contains_looper) {
+                LOG(warning) << "The path of looper " << name() << " contains another looper: solutions cannot be "
+                             << "evaluated concurrently. Using a single thread.";
+                m_threads = 1;
+            }
+
+            if (m_threads > 1)
+                createLanes();
+
+            // Inner loopers are configured first, and already flattened their own inner loopers.
+            // Loopers evaluating their solutions concurrently are never flattened.
+            m_levels.clear();
+            Looper* inner = path.modules().empty() ? nullptr : dynamic_cast<Looper*>(path.modules().back().get());
+            if (m_flatten && inner && inner->m_lanes.empty()) {
+                LOG(debug) << "Flattening looper " << inner->name() << " into looper " << name();
+
+                m_levels.push_back({this, {path.modules().begin(), path.modules().end() - 1}});
+                m_levels.insert(m_levels.end(), inner->m_levels.begin(), inner->m_levels.end());
+            } else {
+                m_levels.push_back({this, path.modules()});
+            }
         }
 
         virtual void beginIntegration() override {
             CALL(beginIntegration);
+            CALL_LANES(beginIntegration);
         }
 
         virtual void endIntegration() override {
             CALL(endIntegration);
+            CALL_LANES(endIntegration);
 
 #ifdef DEBUG_TIMING
             LOG(info) << "Time spent evaluating modules of looper " << name() << ":";
@@ -146,51 +232,240 @@ class Looper: public Module {
             CALL(endPoint);
         }
 
+        virtual void finish() override {
+            CALL_LANES(finish);
+        }
+
         virtual Status work() override {
+            if (!m_lanes.empty())
+                return concurrentWork();
+
             particles->clear();
 
-            CALL(beginLoop);
+            for (const auto& level: m_levels) {
+                for (const auto& m: level.modules)
+                    m->beginLoop();
+            }
+
+            const double parent_jacobian = m_parent ? *m_parent->combined_jacobian : 1.;
+            auto status = loop(0, parent_jacobian);
+
+            for (const auto& level: m_levels) {
+                for (const auto& m: level.modules)
+                    m->endLoop();
+            }
+
+            return status;
+        }
+
+    private:
+        /// A Looper and the modules it executes for each solution, when flattened
+        struct Level {
+            Looper* looper;
+            std::vector<std::shared_ptr<Module>> modules;
+        };
 
-            auto status = Status::OK;
+        /**
+         * Loop over the solutions of level \p index, and for each of them, execute the modules of this level
+         * then loop over the next level.
+         */
+        Status loop(size_t index, double parent_jacobian) {
+            const Level& level = m_levels[index];
+            Looper& looper = *level.looper;
 
-            // For each solution, loop over all the modules
-            for (const auto& s: *solutions) {
+            for (const auto& s: *looper.solutions) {
                 if (!s.valid)
                     continue;
 
-                *particles = s.values;
-                *jacobian = s.jacobian;
+                // The memory of the output is reused: no allocation once it holds as many particles as a solution
+                looper.particles->assign(s.values.begin(), s.values.end());
+                *looper.jacobian = s.jacobian;
+                *looper.combined_jacobian = parent_jacobian * s.jacobian;
 
-                for (auto& m: path.modules()) {
+                auto status = Status::OK;
+                for (auto& m: level.modules) {
 #ifdef DEBUG_TIMING
                     auto start = high_resolution_clock::now();
 #endif
-                    auto module_status = m->work();
+                    status = m->work();
 #ifdef DEBUG_TIMING
                     m_timings[m.get()] += high_resolution_clock::now() - start;
 #endif
 
-                    if (module_status == Status::OK)
-                        continue;
-                    else if (module_status == Status::NEXT)
+                    if (status != Status::OK)
                         break;
-                    else {
-                        status = module_status;
-                        break;
-                    }
                 }
 
-                if (status != Status::OK)
+                if (status == Status::NEXT)
+                    continue;
+                else if (status != Status::OK)
+                    return status;
+
+                if (index + 1 < m_levels.size()) {
+                    status = loop(index + 1, *looper.combined_jacobian);
+                    if (status != Status::OK)
+                        return status;
+                }
+            }
+
+            return Status::OK;
+        }
+
+        /// A copy of the modules of the path, and of the outputs of this looper, used by one thread
+        struct Lane {
+            PoolPtr pool;
+            std::vector<std::shared_ptr<Module>> modules;
+
+            std::shared_ptr<std::vector<LorentzVector>> particles;
+            std::shared_ptr<double> jacobian;
+            std::shared_ptr<double> combined_jacobian;
+        };
+
+        /// Create a copy of the modules of the path for each thread but the first one
+        void createLanes() {
+            const auto& description = m_pool->description();
+
+            m_lanes.clear();
+            for (int64_t i = 1; i < m_threads; i++) {
+                Lane lane;
+
+                // Outputs of the copies are stored in a separate pool, shadowing the original outputs
+                lane.pool = std::make_shared<Pool>(m_pool);
+
+                lane.pool->current_module(description.at(name()).module);
+                lane.particles = lane.pool->put<std::vector<LorentzVector>>({name(), "particles"});
+                lane.jacobian = lane.pool->put<double>({name(), "jacobian"});
+                lane.combined_jacobian = lane.pool->put<double>({name(), "combined_jacobian"});
+
+                for (const auto& m: path.modules()) {
+                    const auto& module = description.at(m->name()).module;
+                    lane.pool->current_module(module);
+                    lane.modules.push_back(ModuleFactory::get().create(module.type, lane.pool, *module.parameters));
+                }
+
+                for (const auto& m: lane.modules)
+                    m->configure();
+
+                m_lanes.push_back(lane);
+            }
+
+            m_lanes_status.resize(m_threads);
+            LOG(debug) << "Looper " << name() << " evaluates its solutions using " << m_threads << " threads";
+        }
+
+        ThreadTeam& team() {
+            // Cuba forks the process to parallelize the integration, and threads are not inherited by
+            // child processes: the team is started in each process using it
+            if (!m_team || m_team_pid != getpid()) {
+                if (m_team)
+                    m_team.release();
+
+                m_team.reset(new ThreadTeam(m_threads));
+                m_team_pid = getpid();
+            }
+
+            return *m_team;
+        }
+
+        /**
+         * Execute \p modules for one solution out of \p stride, starting at solution \p first.
+         * Stops as soon as one of the lanes returns a status different from `OK` or `NEXT`.
+         */
+        Status loopLane(size_t first, size_t stride, const std::vector<std::shared_ptr<Module>>& modules,
+                        std::vector<LorentzVector>& lane_particles, double& lane_jacobian,
+                        double& lane_combined_jacobian, double parent_jacobian) {
+
+            for (size_t i = first; i < solutions->size(); i += stride) {
+                if (m_abort)
                     break;
+
+                const auto s = (*solutions)[i];
+                if (!s.valid)
+                    continue;
+
+                lane_particles.assign(s.values.begin(), s.values.end());
+                lane_jacobian = s.jacobian;
+                lane_combined_jacobian = parent_jacobian * s.jacobian;
+
+                auto status = Status::OK;
+                for (const auto& m: modules) {
+                    status = m->work();
+                    if (status != Status::OK)
+                        break;
+                }
+
+                if (status != Status::OK && status != Status::NEXT) {
+                    m_abort = true;
+                    return status;
+                }
+            }
+
+            return Status::OK;
+        }
+
+        Status concurrentWork() {
+            particles->clear();
+
+            CALL(beginLoop);
+
+            // Copies are reset for each loop, their results being merged into the original modules afterwards
+            for (const auto& lane: m_lanes) {
+                lane.pool->arena().reset();
+                for (const auto& m: lane.modules) {
+                    m->beginPoint();
+                    m->beginLoop();
+                }
+            }
+
+            const double parent_jacobian = m_parent ? *m_parent->combined_jacobian : 1.;
+            m_abort = false;
+
+            team().run([this, parent_jacobian](size_t lane) {
+                if (lane == 0) {
+                    m_lanes_status[0] = loopLane(0, m_threads, path.modules(), *particles, *jacobian,
+                                                 *combined_jacobian, parent_jacobian);
+                } else {
+                    Lane& l = m_lanes[lane - 1];
+                    m_lanes_status[lane] = loopLane(lane, m_threads, l.modules, *l.particles, *l.jacobian,
+                                                    *l.combined_jacobian, parent_jacobian);
+                }
+            });
+
+            // Merge the copies, always in the same order
+            for (const auto& lane: m_lanes) {
+                for (size_t i = 0; i < lane.modules.size(); i++) {
+                    lane.modules[i]->endLoop();
+                    lane.modules[i]->endPoint();
+                    path.modules()[i]->merge(*lane.modules[i]);
+                }
             }
 
             CALL(endLoop);
 
-            return status;
+            for (const auto& status: m_lanes_status) {
+                if (status != Status::OK)
+                    return status;
+            }
+
+            return Status::OK;
         }
 
-    private:
         Path path;
+        bool m_flatten;
+        int64_t m_threads;
+
+        /// Looper whose path contains this one, if any
+        Looper* m_parent = nullptr;
+
+        /// This looper, followed by the loopers flattened into it
+        std::vector<Level> m_levels;
+
+        /// Copies of the path for concurrent evaluation (one per thread, except the first one)
+        std::vector<Lane> m_lanes;
+        std::vector<Status> m_lanes_status;
+        std::atomic<bool> m_abort;
+        std::unique_ptr<ThreadTeam> m_team;
+        pid_t m_team_pid = 0;
 
         // Inputs
         Value<SolutionCollection> solutions;
@@ -198,6 +473,7 @@ class Looper: public Module {
         // Outputs
         std::shared_ptr<std::vector<LorentzVector>> particles = produce<std::vector<LorentzVector>>("particles");
         std::shared_ptr<double> jacobian = produce<double>("jacobian");
+        std::shared_ptr<double> combined_jacobian = produce<double>("combined_jacobian");
 
 #ifdef DEBUG_TIMING
         std::unordered_map<Module*, std::chrono::high_resolution_clock::duration> m_timings;
@@ -42,6 +42,10 @@ class LooperSummer: public Module {
             return Status::OK;
         }
 
+        virtual void merge(const Module& other) override {
+            *result += *static_cast<const LooperSummer<T>&>(other).result;
+        }
+
     private:
 
         // Inputs
@@ -60,6 +64,41 @@ void LooperSummer<LorentzVector>::beginPoint() {
   result->SetXYZT(0, 0, 0, 0);
 }
 
+/**
+ * \brief Specialization for vector of doubles
+ *
+ * Entries are summed independently. All the input vectors must have the same size, given by the
+ * `size` parameter, so that the output has the correct size even if no solution is found.
+ */
+template<>
+LooperSummer<std::vector<double>>::LooperSummer(PoolPtr pool, const ParameterSet& parameters): Module(pool, parameters.getModuleName()) {
+  input = pool->get<std::vector<double>>(parameters.get<InputTag>("input"));
+  result->resize(parameters.get<int64_t>("size"), 0);
+}
+
+template<>
+void LooperSummer<std::vector<double>>::beginPoint() {
+  std::fill(result->begin(), result->end(), 0);
+}
+
+template<>
+Module::Status LooperSummer<std::vector<double>>::work() {
+  size_t size = std::min(input->size(), result->size());
+  for (size_t i = 0; i < size; i++)
+      (*result)[i] += (*input)[i];
+
+  return Status::OK;
+}
+
+template<>
+void LooperSummer<std::vector<double>>::merge(const Module& other) {
+  const auto& other_result = *static_cast<const LooperSummer<std::vector<double>>&>(other).result;
+  size_t size = std::min(other_result.size(), result->size());
+  for (size_t i = 0; i < size; i++)
+      (*result)[i] += other_result[i];
+}
+
 REGISTER_MODULE_NAME("IntLooperSummer", LooperSummer<int64_t>);
 REGISTER_MODULE_NAME("DoubleLooperSummer", LooperSummer<double>);
 REGISTER_MODULE_NAME("P4LooperSummer", LooperSummer<LorentzVector>);
+REGISTER_MODULE_NAME("DoubleVectorLooperSummer", LooperSummer<std::vector<double>>);
@@ -26,9 +26,81 @@
 #include <momemta/ParameterSet.h>
 #include <momemta/Math.h>
 #include <momemta/Module.h>
+#include <momemta/PDFTable.h>
 #include <momemta/Types.h>
 #include <momemta/Utils.h>
 
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace {
+
+/// Protects the caches below: several engines (see MoMEMta::clone()) may be created concurrently
+std::mutex cache_mutex;
+
+/**
+ * \brief Load a member of a PDF set
+ *
+ * PDF sets are read-only once loaded: instances are shared between all the modules (and engines) using
+ * the same member, as long as one of them is alive.
+ */
+std::shared_ptr<LHAPDF::PDF> loadPDF(const std::string& name, int member) {
+    static std::map<std::pair<std::string, int>, std::weak_ptr<LHAPDF::PDF>> pdfs;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto& cached = pdfs[std::make_pair(name, member)];
+
+    auto pdf = cached.lock();
+    if (!pdf) {
+        pdf.reset(LHAPDF::mkPDF(name, member));
+        cached = pdf;
+    }
+
+    return pdf;
+}
+
+/// A PDF interpolation table, along with its largest deviation with LHAPDF
+struct ValidatedPDFTable {
+    ValidatedPDFTable(const std::vector<int>& flavours, double x_min, double x_max, size_t n_points,
+                      const momemta::PDFTable::Evaluator& xfx):
+        table(flavours, x_min, x_max, n_points, xfx), deviation(table.validate(xfx)) {}
+
+    momemta::PDFTable table;
+    double deviation;
+};
+
+/**
+ * \brief Build the interpolation table of a PDF at a fixed scale
+ *
+ * Tables are shared as long as one of their users is alive, so that building several identical engines
+ * fills and validates each table only once.
+ */
+std::shared_ptr<const ValidatedPDFTable> loadPDFTable(const std::shared_ptr<LHAPDF::PDF>& pdf,
+                                                      double scale_squared, size_t n_points) {
+    using Key = std::tuple<const LHAPDF::PDF*, double, size_t>;
+    static std::map<Key, std::weak_ptr<const ValidatedPDFTable>> tables;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto& cached = tables[Key(pdf.get(), scale_squared, n_points)];
+
+    auto table = cached.lock();
+    if (!table) {
+        auto xfx = [&pdf, scale_squared](int pdg_id, double x) {
+            return pdf->xfxQ2(pdg_id, x, scale_squared);
+        };
+
+        // Stay away from x = 1, where the grid variable is not defined
+        double x_max = std::min(pdf->xMax(), 1. - 1e-4);
+        table = std::make_shared<const ValidatedPDFTable>(pdf->flavors(), pdf->xMin(), x_max, n_points, xfx);
+        cached = table;
+    }
+
+    return table;
+}
+
+}
+
 /** \brief Compute the integrand: matrix element, PDFs, jacobians
  *
  * ### Summary
@@ -109,6 +181,47 @@
  * ```
  * means that the particle vector corresponds to (electron, positron), while the matrix element expects to be given first the positron, then the electron.
  *
+ * ### PDF interpolation table
+ *
+ * Since the factorisation scale is fixed, the PDFs only depend on Björken-\f$x\f$. If `pdf_table` is set, a dense
+ * interpolation table of \f$ x f(x) \f$ is built for all the flavours of the PDF set when the module is configured,
+ * and is used instead of LHAPDF during the integration. The number of nodes of the table is set with `pdf_table_points`.
+ * The table is validated against LHAPDF when built: if the largest relative deviation is above `pdf_table_tolerance`,
+ * a warning is printed and LHAPDF is used instead. Values of \f$x\f$ outside of the table range are always evaluated using LHAPDF.
+ *
+ * ### PDF uncertainties and scale variations
+ *
+ * The integrand can also be computed for other members of the PDF set (`pdf_members`) and for other factorisation
+ * scales (`pdf_scale_variations`, given as factors applied to `pdf_scale`). The matrix element is evaluated only once
+ * per phase-space point: only the PDF product is recomputed for each variation. The results are stored in the
+ * `pdf_variations` output, first one entry per PDF member, then one entry per scale variation, in the order given in
+ * the configuration. Each entry can be used as an additional integrand component (`integrand("me::output",
+ * "me::pdf_variations/1", ...)`). When a Looper is used, the entries have to be summed over the solutions using a
+ * DoubleVectorLooperSummer module, with `size` set to the number of variations.
+ *
+ * ### Parameter hypotheses
+ *
+ * The integrand can be computed for several sets of matrix element parameters at once, using `hypotheses`: a list of
+ * parameter sets, each one overriding some parameters of the matrix element (like `override_parameters`). For instance,
+ * ```
+ * hypotheses = {
+ *     { mdl_MT = 171.5, mdl_WT = 1.47 },
+ *     { mdl_MT = 173.5, mdl_WT = 1.50 }
+ * }
+ * ```
+ * Each hypothesis gets its own instance of the matrix element, created when the module is configured. For each
+ * phase-space point, the matrix element is evaluated once per hypothesis on the same particles, while the jacobians and
+ * PDFs are reused: the PDFs are only evaluated again for the initial states the nominal matrix element does not have
+ * (for instance if a hypothesis turns on a coupling). The results are stored in the `hypotheses` output, in the same order as in the configuration, and
+ * can be used as additional integrand components like the PDF variations (see above). The nominal parameters are used
+ * for the `output` output. Parameters given in `override_parameters` apply to the hypotheses as well.
+ *
+ * \note The hypotheses do not change the PDFs nor the kinematics: parameters used elsewhere in the configuration
+ *       (e.g. a mass in a Breit-Wigner generator) are not affected. In particular, the phase-space generation and the
+ *       importance sampling of the integration stay tuned to the nominal parameters: the further a hypothesis is from
+ *       them, the larger the variance of its weight. Hypotheses far from the nominal values are better computed in a
+ *       separate integration.
+ *
  * ### Integration dimension
  *
  * This module requires **0** phase-space point.
@@ -126,6 +239,12 @@
  *   | `use_pdf` | double, default true | Evaluate PDFs and use them in the integrand. |
  *   | `pdf` | string | Name of the LHAPDF set to be used (see [full list](https://lhapdf.hepforge.org/pdfsets.html)). |
  *   | `pdf_scale` | double | Factorisation scale used when evaluating the PDFs. |
+ *   | `pdf_table` | bool, default false | Evaluate the PDFs using a precomputed interpolation table (see above explanation). |
+ *   | `pdf_table_points` | int, default 2000 | Number of nodes of the PDF interpolation table, at least 4. |
+ *   | `pdf_table_tolerance` | double, default 1e-3 | Largest relative deviation allowed between the PDF interpolation table and LHAPDF. |
+ *   | `pdf_members` | vector(int), optional | Members of the PDF set for which the integrand is also computed (see above explanation). |
+ *   | `pdf_scale_variations` | vector(double), optional | Factors applied to `pdf_scale` for which the integrand is also computed (see above explanation). |
+ *   | `hypotheses` | vector(ParameterSet), optional | Sets of matrix element parameters for which the integrand is also computed (see above explanation). |
  *   | `matrix_element` | string | Name of the matrix element to be used. |
  *   | `matrix_element_parameters` | ParameterSet | Set of parameters passed to the matrix element (see above explanation). |
  *   | `override_parameters` | ParameterSet (optional) | Overrides the value of the ME parameters (usually those specified in the param card) by the ones specified. |
@@ -143,6 +262,8 @@
  *   | Name | Type | %Description |
  *   |------|------|--------------|
  *   | `integrands` | vector(double) | Vector of integrands (one per invisibles' solution). All entries in this vector will be summed by MoMEMta to define the final integrand used by Cuba to compute the integral. |
+ *   | `pdf_variations` | vector(double) | Integrand computed for each PDF member and scale variation (see above explanation). Empty if no variation is requested. |
+ *   | `hypotheses` | vector(double) | Integrand computed for each set of matrix element parameters given in `hypotheses` (see above explanation). |
  *
  * \ingroup modules
  */
@@ -205,25 +326,84 @@ class MatrixElement: public Module {
                 p->cacheCouplings();
             }
 
+            if (parameters.exists("hypotheses")) {
+                const auto& hypotheses = parameters.get<std::vector<ParameterSet>>("hypotheses");
+
+                // One matrix element per hypothesis: parameters are only set once, not for each point
+                for (const auto& hypothesis: hypotheses) {
+                    auto me = MatrixElementFactory::get().create(matrix_element, matrix_element_configuration);
+                    auto p = me->getParameters();
+
+                    if (parameters.exists("override_parameters")) {
+                        const ParameterSet& matrix_element_params = parameters.get<ParameterSet>("override_parameters");
+                        for (const auto& name: matrix_element_params.getNames())
+                            p->setParameter(name, matrix_element_params.get<double>(name));
+                    }
+
+                    for (const auto& name: hypothesis.getNames()) {
+                        if (!p->hasParameter(name)) {
+                            LOG(fatal) << "Parameter '" << name << "' used in hypotheses does not exist in matrix element '"
+                                       << matrix_element << "'";
+                            throw Module::invalid_configuration("Unknown matrix element parameter in hypotheses");
+                        }
+
+                        p->setParameter(name, hypothesis.get<double>(name));
+                    }
+
+                    p->cacheParameters();
+                    p->cacheCouplings();
+
+                    m_hypotheses.push_back(me);
+                }
+
+                m_hypotheses_integrands->resize(m_hypotheses.size());
+            }
+
             // PDF, if asked
             if (use_pdf) {
                 // Silence LHAPDF
                 LHAPDF::setVerbosity(0);
 
                 std::string pdf = parameters.get<std::string>("pdf");
-                m_pdf.reset(LHAPDF::mkPDF(pdf, 0));
+                std::shared_ptr<LHAPDF::PDF> nominal_pdf = loadPDF(pdf, 0);
 
                 double pdf_scale = parameters.get<double>("pdf_scale");
-                pdf_scale_squared = SQ(pdf_scale);
+                m_pdfs.emplace_back(nominal_pdf, SQ(pdf_scale));
+
+                auto members = parameters.get<std::vector<int64_t>>("pdf_members", std::vector<int64_t>());
+                for (const auto& member: members) {
+                    std::shared_ptr<LHAPDF::PDF> member_pdf = loadPDF(pdf, member);
+                    m_pdfs.emplace_back(member_pdf, SQ(pdf_scale));
+                }
+
+                auto scale_variations = parameters.get<std::vector<double>>("pdf_scale_variations", std::vector<double>());
+                for (const auto& factor: scale_variations) {
+                    m_pdfs.emplace_back(nominal_pdf, SQ(factor * pdf_scale));
+                }
+
+                use_pdf_table = parameters.get<bool>("pdf_table", false);
+                pdf_table_points = parameters.get<int64_t>("pdf_table_points", 2000);
+                if (pdf_table_points < 4) {
+                    LOG(fatal) << "Invalid number of nodes " << pdf_table_points << " for the PDF table of module "
+                               << name() << ": at least 4 are needed.";
+                    throw Module::invalid_configuration("Invalid number of nodes for the PDF table");
+                }
+                pdf_table_tolerance = parameters.get<double>("pdf_table_tolerance", 1e-3);
+            } else if (parameters.exists("pdf_members") || parameters.exists("pdf_scale_variations")) {
+                LOG(fatal) << "PDF variations have been requested, but PDFs are disabled (`use_pdf` is false).";
+                throw Module::invalid_configuration("PDF variations requested without PDFs");
             }
 
+            if (m_pdfs.size() > 1)
+                m_pdf_variations->resize(m_pdfs.size() - 1);
+
             // Prepare arrays for sorting particles
             for (size_t i = 0; i < m_particles_ids.size(); i++) {
                 indexing.push_back(m_particles_ids[i].me_index - 1);
             }
 
             // Pre-allocate memory for the finalState array
-            finalState.resize(m_particles_ids.size());
+            finalState.assign(m_particles_ids.size(), std::make_pair(0, std::vector<double>(4)));
 
             // Sort the array taking into account the indexing in the configuration
             std::vector<int64_t> suite(indexing.size());
@@ -232,25 +412,42 @@ class MatrixElement: public Module {
             permutations = get_permutations(suite, indexing);
         };
 
+        virtual void configure() override {
+            if (!use_pdf || !use_pdf_table)
+                return;
+
+            for (auto& pdf: m_pdfs) {
+                auto table = loadPDFTable(pdf.pdf, pdf.scale_squared, pdf_table_points);
+
+                double deviation = table->deviation;
+                if (deviation > pdf_table_tolerance) {
+                    LOG(warning) << name() << ": largest relative deviation between PDF table and LHAPDF is "
+                                 << deviation << ", above the tolerance of " << pdf_table_tolerance
+                                 << ". Falling back to LHAPDF. Try increasing the number of nodes using `pdf_table_points`.";
+                    pdf.table.reset();
+                } else {
+                    LOG(debug) << name() << ": PDF table built with " << pdf_table_points
+                               << " nodes. Largest relative deviation with LHAPDF: " << deviation;
+                    pdf.table = std::shared_ptr<const momemta::PDFTable>(table, &table->table);
+                }
+            }
+        }
+
         virtual Status work() override {
             static std::vector<LorentzVector> empty_vector;
 
             *m_integrand = 0;
             const std::vector<LorentzVector>& partons = *m_partons;
 
-            LorentzVectorRefCollection particles;
-            for (const auto& p: m_particles)
-                particles.push_back(std::ref(*p));
-
-            for (size_t i = 0; i < m_particles_ids.size(); i++) {
-                finalState[i] = std::make_pair(m_particles_ids[i].pdg_id, toVector(particles[i].get()));
+            // Fill the final state in place, sorted taking into account the indexing in the configuration
+            for (size_t i = 0; i < permutations.size(); i++) {
+                const size_t from = permutations[i];
+                finalState[i].first = m_particles_ids[from].pdg_id;
+                toVector(*m_particles[from], finalState[i].second);
             }
 
-            // Sort the array taking into account the indexing in the configuration
-            apply_permutations(finalState, permutations);
-
-            std::pair<std::vector<double>, std::vector<double>> initialState { toVector(partons[0]),
-                                                                               toVector(partons[1]) };
+            toVector(partons[0], initialState.first);
+            toVector(partons[1], initialState.second);
 
             auto result = m_ME->compute(initialState, finalState);
 
@@ -265,30 +462,103 @@ class MatrixElement: public Module {
                 integrand *= (*jacobian);
             }
 
-            // PDF
+            // Product of the nominal PDFs for an initial state
+            auto pdfProduct = [this, x1, x2](const std::pair<int, int>& initial_state) {
+                if (!use_pdf)
+                    return 1.;
+
+                return m_pdfs[0].xfx(initial_state.first, x1) / x1 * m_pdfs[0].xfx(initial_state.second, x2) / x2;
+            };
+
+            // Product of the nominal PDFs for each initial state, shared with the hypotheses
+            m_pdf_products.resize(result.size());
+            size_t index = 0;
             double final_integrand = 0;
             for (const auto& me: result) {
-                double pdf1 = use_pdf ? m_pdf->xfxQ2(me.first.first, x1, pdf_scale_squared) / x1 : 1;
-                double pdf2 = use_pdf ? m_pdf->xfxQ2(me.first.second, x2, pdf_scale_squared) / x2 : 1;
+                m_pdf_products[index] = pdfProduct(me.first);
+                final_integrand += me.second * m_pdf_products[index++];
+            }
 
-                final_integrand += me.second * pdf1 * pdf2;
+            *m_integrand = final_integrand * integrand;
+
+            // The matrix element is the same for all the PDF variations, only the PDFs change
+            for (size_t i = 1; i < m_pdfs.size(); i++) {
+                const auto& pdf = m_pdfs[i];
+
+                double variation_integrand = 0;
+                for (const auto& me: result) {
+                    double pdf1 = pdf.xfx(me.first.first, x1) / x1;
+                    double pdf2 = pdf.xfx(me.first.second, x2) / x2;
+
+                    variation_integrand += me.second * pdf1 * pdf2;
+                }
+
+                (*m_pdf_variations)[i - 1] = variation_integrand * integrand;
             }
 
-            final_integrand *= integrand;
-            *m_integrand = final_integrand;
+            // Only the matrix element changes for the hypotheses
+            for (size_t i = 0; i < m_hypotheses.size(); i++) {
+                auto hypothesis_result = m_hypotheses[i]->compute(initialState, finalState);
+
+                // Results are sorted by initial state: look for each initial state of the hypothesis among the
+                // nominal ones, and only evaluate the PDFs for those not found
+                auto nominal = result.begin();
+                index = 0;
+                double hypothesis_integrand = 0;
+                for (const auto& me: hypothesis_result) {
+                    while (nominal != result.end() && nominal->first < me.first) {
+                        ++nominal;
+                        ++index;
+                    }
+
+                    const bool shared = nominal != result.end() && nominal->first == me.first;
+                    hypothesis_integrand += me.second * (shared ? m_pdf_products[index] : pdfProduct(me.first));
+                }
+
+                (*m_hypotheses_integrands)[i] = hypothesis_integrand * integrand;
+            }
 
             return Status::OK;
         }
 
     private:
+        /// A PDF evaluated at a fixed factorisation scale, possibly using an interpolation table
+        struct FixedScalePDF {
+            FixedScalePDF(std::shared_ptr<LHAPDF::PDF> pdf, double scale_squared):
+                pdf(pdf), scale_squared(scale_squared) {}
+
+            double xfx(int pdg_id, double x) const {
+                if (table && table->covers(x) && table->hasFlavour(pdg_id))
+                    return table->xfx(pdg_id, x);
+
+                return pdf->xfxQ2(pdg_id, x, scale_squared);
+            }
+
+            std::shared_ptr<LHAPDF::PDF> pdf;
+            double scale_squared;
+            std::shared_ptr<const momemta::PDFTable> table;
+        };
+
         double sqrt_s;
         bool use_pdf;
-        double pdf_scale_squared = 0;
         std::shared_ptr<momemta::MatrixElement> m_ME;
-        std::shared_ptr<LHAPDF::PDF> m_pdf;
+
+        /// Nominal PDF first, then PDF members and scale variations
+        std::vector<FixedScalePDF> m_pdfs;
+
+        bool use_pdf_table = false;
+        int64_t pdf_table_points;
+        double pdf_table_tolerance;
+
+        /// Matrix element for each hypothesis, with its parameters already set
+        std::vector<std::shared_ptr<momemta::MatrixElement>> m_hypotheses;
+
+        /// Product of the nominal PDFs for each initial state of the nominal matrix element, in the same order
+        std::vector<double> m_pdf_products;
 
         std::vector<int64_t> indexing;
         std::vector<size_t> permutations;
+        std::pair<std::vector<double>, std::vector<double>> initialState {std::vector<double>(4), std::vector<double>(4)};
         std::vector<std::pair<int, std::vector<double>>> finalState;
 
         // Inputs
@@ -301,5 +571,7 @@ class MatrixElement: public Module {
 
         // Outputs
         std::shared_ptr<double> m_integrand = produce<double>("output");
+        std::shared_ptr<std::vector<double>> m_pdf_variations = produce<std::vector<double>>("pdf_variations");
+        std::shared_ptr<std::vector<double>> m_hypotheses_integrands = produce<std::vector<double>>("hypotheses");
 };
 REGISTER_MODULE(MatrixElement);
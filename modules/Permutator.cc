@@ -16,44 +16,80 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <momemta/Logging.h>
 #include <momemta/ParameterSet.h>
 #include <momemta/Module.h>
+#include <momemta/Solution.h>
 #include <momemta/Types.h>
 
 #include <algorithm>
 #include <cmath>
-#include <numeric>
-
-#include <TMath.h>
+#include <cstdint>
 
 /** \brief Apply random permutations to a set of inputs
  *
  * Apply a random permutation on the input particles. Which permutation to apply
  * is determined by the value of a phase-space point \f$x\f$ generated by Cuba. For instance,
  * if the input is \f$(p1,p2)\f$, the output will be \f$(p_1,p_2)\f$ if \f$x \in [\,0, 0.5\,[\f$ and
- * \f$(p_2,p_1)\f$ if \f$x \in [\,0.5, 1\,]\f$.
+ * \f$(p_2,p_1)\f$ if \f$x \in [\,0.5, 1\,]\f$. In general, each of the \f$ n! \f$ permutations is chosen for an
+ * interval of length \f$ 1 / n! \f$.
  *
  * This allows to efficiently compute a weight taking into account all permutations over identical
  * objects in the final state. A dimension is added to the integration, and this extra dimension controls
  * which permutation is considered for the rest of the computation. That way, the integrator automatically
  * spends more time on those permutations giving the largest contribution to the final result.
  *
+ * ### Summing over the permutations
+ *
+ * The integrator however has to learn a discrete, piecewise-constant dimension, which it handles poorly. When the
+ * number of permutations is small (two or three b-jets), it's usually faster to evaluate all of them for each
+ * phase-space point. With `mode` set to `sum`, no dimension is added: the module outputs all the permutations as a
+ * collection of solutions, each with a jacobian \f$ 1 / n! \f$, to be fed to a Looper module. The modules depending on
+ * the permutation are placed in the path of the Looper, and the integrand is summed over the permutations using a
+ * LooperSummer module. Modules which do not depend on the permutation stay outside of the path and are only evaluated
+ * once per phase-space point. The result is the same as in the `sample` mode: the average of the integrand over the
+ * permutations.
+ *
+ * ### Permutations
+ *
+ * Permutations are not stored: the permutation corresponding to a phase-space point is computed on demand from its
+ * rank, so that memory and initialization time do not depend on the number of inputs (up to 20 inputs are supported
+ * in `sample` mode). Since all the permutations are output in `sum` mode, this mode is limited to 8 inputs.
+ * Assignments which are never valid (for instance, a b-jet which can only come from one of the top quarks) can be
+ * excluded using the `forbidden` parameter: phase-space points leading to a forbidden permutation are skipped (as if
+ * the module returned `NEXT`), and forbidden permutations are never output in `sum` mode. The weight of the other
+ * permutations is unchanged, so that results only differ if the forbidden permutations were contributing.
+ *
+ * Unfeasible permutations are pruned as soon as a module of the path returns `NEXT` (or a block finds no solution):
+ * cheap kinematic checks and blocks should therefore come first in the path, and the expensive modules (matrix
+ * element, ...) last.
+ *
  * ### Integration dimension
  *
- * This module requires **1** phase-space point.
+ * This module requires **1** phase-space point in `sample` mode, **0** in `sum` mode.
+ *
+ * ### Parameters
+ *
+ *   | Name | Type | %Description |
+ *   |------|------|--------------|
+ *   | `mode` | string, default `sample` | Either `sample` (a permutation is chosen for each phase-space point) or `sum` (all the permutations are evaluated, see above explanation). |
+ *   | `forbidden` | vector(int), optional | Forbidden assignments, as a flat list of (position, input) pairs numbered from 1. For instance, `{1, 2}` forbids the second input to be put in the first position of the output. |
  *
  * ### Inputs
  *
  *   | Name | Type | %Description |
  *   |------|------|--------------|
- *   | `ps_point` | double | Phase-space point generated by CUBA. |
+ *   | `ps_point` | double | Phase-space point generated by CUBA. Only used in `sample` mode. |
  *   | `inputs` | vector(LorentzVector) | Set of input particles to be permutated |
  *
  * ### Outputs
  *
  *   | Name | Type | %Description |
  *   |------|------|--------------|
- *   | `output` | double | Permutated set of input particles |
+ *   | `output` | vector(LorentzVector) | Permutated set of input particles (`sample` mode only) |
+ *   | `solutions` | vector(Solution) | All the permutations of the input particles, with a jacobian \f$ 1 / n! \f$ (`sum` mode only). These solutions should be fed as input to the Looper module. |
+ *
+ * \sa Looper module to loop over the permutations in `sum` mode
  *
  * \ingroup modules
  */
@@ -62,35 +98,178 @@ class Permutator: public Module {
 
         Permutator(PoolPtr pool, const ParameterSet& parameters): Module(pool, parameters.getModuleName()) {
 
-            m_ps_point = get<double>(parameters.get<InputTag>("ps_point"));
+            std::string mode = parameters.get<std::string>("mode", "sample");
+            if (mode == "sum") {
+                m_sum = true;
+            } else if (mode == "sample") {
+                m_sum = false;
+                m_ps_point = get<double>(parameters.get<InputTag>("ps_point"));
+            } else {
+                LOG(fatal) << "Unknown permutation mode '" << mode << "'. Valid modes are 'sample' and 'sum'.";
+                throw Module::invalid_configuration("Unknown permutation mode");
+            }
 
             auto particle_tags = parameters.get<std::vector<InputTag>>("inputs");
             for (auto& t: particle_tags)
                 m_inputs.push_back(get<LorentzVector>(t));
 
-            std::vector<uint32_t> tmp(m_inputs.size());
-            std::iota(tmp.begin(), tmp.end(), 0);
+            const size_t n = m_inputs.size();
+            if (n == 0 || n > MAX_INPUTS) {
+                LOG(fatal) << "Permutator " << name() << ": between 1 and " << MAX_INPUTS << " inputs are supported, got "
+                           << n << ".";
+                throw Module::invalid_configuration("Invalid number of inputs");
+            }
+
+            // factorials[i] = i!
+            m_factorials.resize(n + 1);
+            m_factorials[0] = 1;
+            for (size_t i = 1; i <= n; i++)
+                m_factorials[i] = m_factorials[i - 1] * i;
+
+            m_allowed.assign(n, (1u << n) - 1);
+            auto forbidden = parameters.get<std::vector<int64_t>>("forbidden", {});
+            if (forbidden.size() % 2 != 0) {
+                LOG(fatal) << "Permutator " << name() << ": 'forbidden' must be a list of (position, input) pairs.";
+                throw Module::invalid_configuration("Invalid forbidden assignments");
+            }
+
+            for (size_t i = 0; i < forbidden.size(); i += 2) {
+                const int64_t position = forbidden[i];
+                const int64_t input = forbidden[i + 1];
+                if (position < 1 || position > static_cast<int64_t>(n) || input < 1 || input > static_cast<int64_t>(n)) {
+                    LOG(fatal) << "Permutator " << name() << ": invalid forbidden assignment (" << position << ", "
+                               << input << "). Positions and inputs are numbered from 1 to " << n << ".";
+                    throw Module::invalid_configuration("Invalid forbidden assignments");
+                }
+
+                m_allowed[position - 1] &= ~(1u << (input - 1));
+            }
 
-            do {
-                perm_indices.push_back(tmp);
-            } while (std::next_permutation(tmp.begin(), tmp.end()));
+            m_permutation.resize(n);
+            (*m_output).resize(n);
 
-            (*m_output).resize(m_inputs.size());
+            if (m_sum) {
+                if (n > MAX_SUM_INPUTS) {
+                    LOG(fatal) << "Permutator " << name() << ": at most " << MAX_SUM_INPUTS << " inputs are supported"
+                               << " in `sum` mode, got " << n << ". Use the `sample` mode instead.";
+                    throw Module::invalid_configuration("Too many inputs for `sum` mode");
+                }
+
+                // Weight of each permutation, forbidden ones included, as in `sample` mode
+                m_weight = 1. / m_factorials[n];
+
+                size_t n_allowed = 0;
+                enumerate(0, (1u << n) - 1, [&n_allowed]() { n_allowed++; });
+                if (n_allowed == 0) {
+                    LOG(fatal) << "Permutator " << name() << ": all the permutations are forbidden.";
+                    throw Module::invalid_configuration("All permutations are forbidden");
+                }
+
+                m_permutated.resize(n);
+                m_solutions->reserve(n_allowed, n);
+            }
         };
 
         virtual Status work() override {
+            if (m_sum) {
+                m_solutions->clear();
+                enumerate(0, (1u << m_inputs.size()) - 1, [this]() {
+                    for (size_t i = 0; i < m_inputs.size(); i++)
+                        m_permutated[i] = *m_inputs[m_permutation[i]];
+
+                    m_solutions->push_back(m_permutated.data(), m_permutated.size(), m_weight);
+                });
+
+                return Status::OK;
+            }
+
             double psPoint = *m_ps_point;
 
-            size_t chosen_perm = std::lround(psPoint * (perm_indices.size() - 1));
+            // Each permutation covers an interval of the same length, 1 / n!
+            const uint64_t n_permutations = m_factorials[m_inputs.size()];
+            uint64_t chosen_perm = static_cast<uint64_t>(std::floor(psPoint * n_permutations));
+            chosen_perm = std::min(chosen_perm, n_permutations - 1);
+
+            if (!unrank(chosen_perm))
+                return Status::NEXT;
 
             for (size_t i = 0; i < m_inputs.size(); i++)
-                (*m_output)[i] = *m_inputs[perm_indices[chosen_perm][i]];
+                (*m_output)[i] = *m_inputs[m_permutation[i]];
 
             return Status::OK;
         }
 
     private:
-        std::vector<std::vector<uint32_t>> perm_indices;
+        /// Permutations are indexed using 64 bits integers: 20! is the largest factorial fitting
+        static constexpr size_t MAX_INPUTS = 20;
+
+        /// All the permutations are output in `sum` mode: 8! = 40320 solutions at most
+        static constexpr size_t MAX_SUM_INPUTS = 8;
+
+        /**
+         * \brief Compute the permutation of rank \p rank, in lexicographic order
+         *
+         * The digits of \p rank in the factorial number system (Lehmer code) give, for each position, the
+         * index of the chosen input among the inputs not used yet. The result is stored in `m_permutation`.
+         *
+         * \return False as soon as a forbidden assignment is found
+         */
+        bool unrank(uint64_t rank) {
+            const size_t n = m_inputs.size();
+            uint32_t available = (1u << n) - 1;
+
+            for (size_t position = 0; position < n; position++) {
+                const uint64_t factorial = m_factorials[n - 1 - position];
+                uint64_t digit = rank / factorial;
+                rank %= factorial;
+
+                // Find the `digit`-th available input
+                uint32_t input = 0;
+                for (;; input++) {
+                    if ((available & (1u << input)) && digit-- == 0)
+                        break;
+                }
+
+                if (!(m_allowed[position] & (1u << input)))
+                    return false;
+
+                m_permutation[position] = input;
+                available &= ~(1u << input);
+            }
+
+            return true;
+        }
+
+        /**
+         * \brief Call \p callback for each allowed permutation, in lexicographic order
+         *
+         * Permutations are built position after position: a forbidden assignment prunes all the permutations
+         * sharing the same beginning. The current permutation is stored in `m_permutation`.
+         */
+        template <typename Callback>
+        void enumerate(size_t position, uint32_t available, const Callback& callback) {
+            if (position == m_inputs.size()) {
+                callback();
+                return;
+            }
+
+            const uint32_t candidates = available & m_allowed[position];
+            for (uint32_t input = 0; input < m_inputs.size(); input++) {
+                if (!(candidates & (1u << input)))
+                    continue;
+
+                m_permutation[position] = input;
+                enumerate(position + 1, available & ~(1u << input), callback);
+            }
+        }
+
+        std::vector<uint64_t> m_factorials;
+        std::vector<uint32_t> m_allowed; ///< For each position, mask of the inputs allowed at this position
+        std::vector<uint32_t> m_permutation;
+
+        bool m_sum;
+        double m_weight; ///< Weight of each permutation in `sum` mode
+        std::vector<LorentzVector> m_permutated;
 
         // Inputs
         Value<double> m_ps_point;
@@ -98,6 +277,6 @@ class Permutator: public Module {
 
         // Outputs
         std::shared_ptr<std::vector<LorentzVector>> m_output = produce<std::vector<LorentzVector>>("output");
+        std::shared_ptr<SolutionCollection> m_solutions = produce<SolutionCollection>("solutions");
 };
 REGISTER_MODULE(Permutator);
-
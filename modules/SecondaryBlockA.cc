@@ -23,8 +23,6 @@
 #include <momemta/InputTag.h>
 #include <momemta/Types.h>
 
-#include <Math/GenVector/VectorUtil.h>
-
 /** \brief \f$\require{cancel}\f$ Secondary Block A, describing \f$s_{1234} \to ( s_{123} \to s_{12}(\to \cancel{p_1} + p_2) + p_3 ) + p_4\f$
  *
  * This Secondary Block reconstructs \f$p_1\f$ using:
@@ -90,6 +88,9 @@ class SecondaryBlockA: public Module {
                 m_p2 = get<LorentzVector>(parameters.get<InputTag>("p2"));
                 m_p3 = get<LorentzVector>(parameters.get<InputTag>("p3"));
                 m_p4 = get<LorentzVector>(parameters.get<InputTag>("p4"));
+
+                // At most 2 solutions, with 1 particle each
+                solutions->reserve(2, 1);
             };
 
         virtual Status work() override {
@@ -167,7 +168,7 @@ class SecondaryBlockA: public Module {
             const double Bz = ((a12 * a21 - a11 * a22) * c3 - (a12 * a31 - a11 * a32) * c2  + (a22 * a31 - a21 * a32) * c1) / det;
 
             // Now the mass-shell condition for p1 gives a quadratic equation in E1 with up to two solutions
-            std::vector<double> E1_sol;
+            Roots E1_sol;
             bool foundSolution = solveQuadratic(SQ(Ax) + SQ(Ay) + SQ(Az) - 1, 2 * (Ax * Bx + Ay * By + Az * Bz), SQ(Bx) + SQ(By) + SQ(Bz) + sq_m1, E1_sol);
 
             if (!foundSolution)
@@ -194,8 +195,7 @@ class SecondaryBlockA: public Module {
                                             E3 * (-(p1z*p2y*p4x) + p1y*p2z*p4x + p1z*p2x*p4y - p1x*p2z*p4y - p1y*p2x*p4z + p1x*p2y*p4z)
                                     ));
 
-                Solution solution { { p1 }, jacobian, true };
-                solutions->push_back(solution);
+                solutions->push_back({p1}, jacobian);
             }
             
             return (solutions->size() > 0) ? Status::OK : Status::NEXT;
@@ -23,8 +23,6 @@
 #include <momemta/InputTag.h>
 #include <momemta/Types.h>
 
-#include <Math/GenVector/VectorUtil.h>
-
 /** \brief \f$\require{cancel}\f$ Secondary Block B, describing \f$s_{123} \to s_{12}(\to \cancel{p_1} + p_2) + p_3 \f$
  *
  * This Secondary Block determines \f$p_1^T\f$ and \f$p_1^z\f$ using
@@ -85,6 +83,9 @@ class SecondaryBlockB: public Module {
                 m_p1 = get<LorentzVector>(parameters.get<InputTag>("p1"));
                 m_p2 = get<LorentzVector>(parameters.get<InputTag>("p2"));
                 m_p3 = get<LorentzVector>(parameters.get<InputTag>("p3"));
+
+                // At most 2 solutions, with 1 particle each
+                solutions->reserve(2, 1);
             };
 
         virtual Status work() override {
@@ -112,9 +113,9 @@ class SecondaryBlockB: public Module {
             const double p3z = m_p3->Pz();
             const double p2t = m_p2->Pt();
             const double p3t = m_p3->Pt();
-            const double cosPhi12 = std::cos(ROOT::Math::VectorUtil::DeltaPhi(*m_p1, *m_p2));
-            const double cosPhi13 = std::cos(ROOT::Math::VectorUtil::DeltaPhi(*m_p1, *m_p3));
-            const double cosPhi23 = std::cos(ROOT::Math::VectorUtil::DeltaPhi(*m_p2, *m_p3));
+            const double cosPhi12 = std::cos(deltaPhi(*m_p1, *m_p2));
+            const double cosPhi13 = std::cos(deltaPhi(*m_p1, *m_p3));
+            const double cosPhi23 = std::cos(deltaPhi(*m_p2, *m_p3));
 
             const double denominator = cosPhi13 * p2z * p3t - cosPhi12 * p2t * p3z;
             const double E2E3 = E2 * E3;
@@ -138,7 +139,7 @@ class SecondaryBlockB: public Module {
             const double E1_linear = 2 * (p1t_indep * p1t_linear + p1z_indep * p1z_linear);
             const double E1_quadratic = -1 + p1t_linear_squared + p1z_linear_squared;
 
-            std::vector<double> E1_solutions; // up to two solutions
+            Roots E1_solutions; // up to two solutions
             bool foundSolution = solveQuadratic(E1_quadratic, E1_linear, E1_indep, E1_solutions);
             if (!foundSolution)
                 return Status::NEXT;
@@ -161,8 +162,7 @@ class SecondaryBlockB: public Module {
                 // Compute jacobian
                 const double jacobian = p1t / (64 * CB(M_PI) * std::abs(cosPhi12 * p2t * (E1 * p3z -  E3 * p1z) + cosPhi13 * p3t * (E2 * p1z  - E1 * p2z) + p1t * E3p2z_E2p3z));
 
-                Solution solution { {p1_sol}, jacobian, true };
-                solutions->push_back(solution);
+                solutions->push_back({p1_sol}, jacobian);
             }
             return (solutions->size() > 0) ? Status::OK : Status::NEXT;
 
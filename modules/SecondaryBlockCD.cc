@@ -23,8 +23,6 @@
 #include <momemta/InputTag.h>
 #include <momemta/Types.h>
 
-#include <Math/GenVector/VectorUtil.h>
-
 /** \brief Secondary Block C/D, describing \f$s_{12} \to p_1 + p_2\f$
  *
  * This Secondary Block determine the energy \f$E_1\f$ of \f$p_1\f$ knowing the following quantities:
@@ -77,6 +75,9 @@ class SecondaryBlockCD: public Module {
                 
                 p1 = get<LorentzVector>(parameters.get<InputTag>("p1"));
                 p2 = get<LorentzVector>(parameters.get<InputTag>("p2"));
+
+                // At most 2 solutions, with 1 particle each
+                solutions->reserve(2, 1);
             };
 
         virtual Status work() override {
@@ -87,7 +88,7 @@ class SecondaryBlockCD: public Module {
             if (*s12 > SQ(sqrt_s) || *s12 < p2->M2() || *s12 < p1->M2())
                return Status::NEXT;
 
-            std::vector<double> E1_solutions; // up to two solutions
+            Roots E1_solutions; // up to two solutions
             const double theta1 = p1->Theta();
             const double phi1 = p1->Phi();
             const double m1 = p1->M();
@@ -96,7 +97,7 @@ class SecondaryBlockCD: public Module {
             const double norm2 = p2->P();
             const double m2 = p2->M();
 
-            const double cos_theta12 = ROOT::Math::VectorUtil::CosTheta(*p1, *p2);
+            const double cos_theta12 = cosTheta(*p1, *p2);
 
             // Equation to be solved for E1 : s12 = (p1+p2)^2 ==> [ 4*SQ(cos_theta12)*SQ(norm2)-4*SQ(E2) ] * SQ(E1) + [ 4*(s12 - SQ(m1) - SQ(m2))*E2 ] * E1 + 4*SQ(m1)*SQ(cos_theta12)*(SQ(m2)-SQ(E2) = 0)
             const double quadraticTerm = 4 * SQ(E2) - 4 * SQ(norm2) * SQ(cos_theta12);
@@ -130,8 +131,7 @@ class SecondaryBlockCD: public Module {
                 // Compute jacobian
                 double jacobian = std::abs( std::sin(theta1) * SQ(norm1) / (32 * CB(M_PI) * (norm1 * E2 - E1 * norm2 * cos_theta12)) );
                 
-                Solution s { {gen_p1_sol}, jacobian, true };
-                solutions->push_back(s);
+                solutions->push_back({gen_p1_sol}, jacobian);
             }
 
             return (solutions->size() > 0) ? Status::OK : Status::NEXT;
@@ -23,8 +23,6 @@
 #include <momemta/InputTag.h>
 #include <momemta/Types.h>
 
-#include <Math/GenVector/VectorUtil.h>
-
 /** \brief \f$\require{cancel}\f$ Secondary Block E, describing \f$s_{123} \to s_{12}(\to p_1 + p_2) + p_3 \f$
  *
  * This Secondary Block determines \f$p_1\f$'s and \f$p_2\f$'s energy using
@@ -85,6 +83,9 @@ class SecondaryBlockE: public Module {
                 m_p1 = get<LorentzVector>(parameters.get<InputTag>("p1"));
                 m_p2 = get<LorentzVector>(parameters.get<InputTag>("p2"));
                 m_p3 = get<LorentzVector>(parameters.get<InputTag>("p3"));
+
+                // At most 4 solutions, with 2 particles each
+                solutions->reserve(4, 2);
             };
 
         virtual Status work() override {
@@ -103,14 +104,14 @@ class SecondaryBlockE: public Module {
             const double E3 = m_p3->E();
             const double sq_E3 = SQ(E3);
 
-            const double c12 = ROOT::Math::VectorUtil::CosTheta(*m_p1, *m_p2);
-            const double c13 = ROOT::Math::VectorUtil::CosTheta(*m_p1, *m_p3);
-            const double c23 = ROOT::Math::VectorUtil::CosTheta(*m_p2, *m_p3);
+            const double c12 = cosTheta(*m_p1, *m_p2);
+            const double c13 = cosTheta(*m_p1, *m_p3);
+            const double c23 = cosTheta(*m_p2, *m_p3);
 
             double X = p3 * c23 - E3;
             double Y = *s123 - *s12 - SQ(m3);
 
-            std::vector<double> abs_p1, abs_p2;
+            Roots abs_p1, abs_p2;
             solve2Quads(SQ(X), SQ(p3 * c13) - sq_E3, 2 * p3 * c13 * X,  X * Y, p3 * c13 * Y, 0.25 * SQ(Y) - sq_E3 * sq_m1,
                         2 * X / E3, 0, 2 * (p3 * c13 / E3 - c12), Y / E3, 0, sq_m1 + SQ(m2) - *s12,
                         abs_p2, abs_p1);
@@ -143,8 +144,7 @@ class SecondaryBlockE: public Module {
                                                     abs_p2[i] * (abs_p1[i] - E1 * c12) * X + (E3 * abs_p1[i] - E1 * p3 * c13) * (E1 - abs_p1[i] * c12) )
                                             );
 
-                Solution solution { { p1_sol, p2_sol }, jacobian, true };
-                solutions->push_back(solution);
+                solutions->push_back({p1_sol, p2_sol}, jacobian);
             }
             
             return (solutions->size() > 0) ? Status::OK : Status::NEXT;
@@ -16,6 +16,7 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <momemta/FourVector.h>
 #include <momemta/Math.h>
 #include <momemta/Module.h>
 #include <momemta/ParameterSet.h>
@@ -59,7 +60,9 @@ class StandardPhaseSpace: public Module {
 
             *phase_space = 1;
             for (const auto& p: input_particles) {
-                *phase_space *= SQ(p->P()) * sin(p->Theta()) / (2.0 * p->E() * CB(2. * M_PI));
+                // |P|^2 sin(theta) = |P| Pt
+                const momemta::FourVector v(*p);
+                *phase_space *= v.P() * v.Pt() / (2.0 * v.E() * CB(2. * M_PI));
             }
 
             return Status::OK;
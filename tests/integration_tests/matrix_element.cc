@@ -0,0 +1,164 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Integration tests for the MatrixElement module variations and hypotheses
+ * \ingroup IntegrationTests
+ */
+
+#include <catch.hpp>
+
+#include <momemta/ConfigurationReader.h>
+#include <momemta/Logging.h>
+#include <momemta/MatrixElement.h>
+#include <momemta/MatrixElementFactory.h>
+#include <momemta/MEParameters.h>
+#include <momemta/MoMEMta.h>
+#include <momemta/ParameterSet.h>
+
+#include <cmath>
+
+using namespace momemta;
+
+namespace {
+
+/// Same event as the `No integration` test
+std::vector<Particle> ttbarEvent() {
+    return {
+        { "electron", LorentzVector(16.171895980835, -13.7919054031372, -3.42997527122497, 21.5293197631836), -11 },
+        { "muon", LorentzVector(-18.9018573760986, 10.0896110534668, -0.602926552295686, 21.4346446990967), +13 },
+        { "bjet1", LorentzVector(-55.7908325195313, -111.59294128418, -122.144721984863, 174.66259765625), 5 },
+        { "bjet2", LorentzVector(71.3899612426758, 96.0094833374023, -77.2513122558594, 142.492813110352), -5 },
+        { "neutrino1", LorentzVector(-57.9413, 40.7629, -54.2982, 89.2587), +12 },
+        { "neutrino2", LorentzVector(57.9413, -40.7629, -40.8437, 81.7742), -14 }
+    };
+}
+
+std::vector<std::pair<double, double>> computeWeights(const std::string& lua_file,
+                                                      const ParameterSet& parameters = ParameterSet()) {
+    ConfigurationReader configuration(lua_file, parameters);
+    MoMEMta weight(configuration.freeze());
+
+    auto weights = weight.computeWeights(ttbarEvent());
+    REQUIRE(weight.getIntegrationStatus() == MoMEMta::IntegrationStatus::SUCCESS);
+
+    return weights;
+}
+
+}
+
+TEST_CASE("PDF variations", "[integration_tests]") {
+    logging::set_level(logging::level::fatal);
+
+    const double nominal = computeWeights("no_integration.lua")[0].first;
+    REQUIRE(nominal > 0);
+
+    auto weights = computeWeights("matrix_element.lua");
+    REQUIRE(weights.size() == 8);
+
+    // Weights are tiny: compare the ratios to the nominal weight
+    auto ratio = [&weights, nominal](size_t component) {
+        return weights[component].first / nominal;
+    };
+
+    // Computing the variations does not change the nominal weight
+    REQUIRE(ratio(0) == Approx(1));
+
+    SECTION("PDF members") {
+        // Nominal member
+        REQUIRE(ratio(1) == Approx(1));
+
+        // First eigenvector of the set: a small deviation
+        REQUIRE(ratio(2) != Approx(1));
+        REQUIRE(std::abs(ratio(2) - 1) < 0.2);
+    }
+
+    SECTION("Scale variations") {
+        // Nominal scale
+        REQUIRE(ratio(3) == Approx(1));
+
+        REQUIRE(ratio(4) != Approx(1));
+        REQUIRE(ratio(5) != Approx(1));
+
+        // The gluon density is monotonic with the scale at the Björken-x of this event
+        REQUIRE((ratio(4) - 1) * (ratio(5) - 1) < 0);
+    }
+}
+
+TEST_CASE("Matrix element parameters", "[integration_tests]") {
+    logging::set_level(logging::level::fatal);
+
+    ParameterSet configuration;
+    configuration.set("card", std::string("../../MatrixElements/Cards/param_card.dat"));
+
+    std::shared_ptr<momemta::MatrixElement> me = MatrixElementFactory::get().create("pp_ttx_fully_leptonic",
+                                                                                    configuration);
+    auto parameters = me->getParameters();
+
+    REQUIRE(parameters->hasParameter("mdl_MT"));
+    REQUIRE(parameters->hasParameter("mdl_WT"));
+    REQUIRE_FALSE(parameters->hasParameter("unknown"));
+
+    // Values from the param card
+    REQUIRE(parameters->getParameter("mdl_MT") == Approx(173.));
+    REQUIRE(parameters->getParameter("mdl_WT") == Approx(1.4915));
+    REQUIRE_THROWS_AS(parameters->getParameter("unknown"), std::out_of_range);
+
+    parameters->setParameter("mdl_MT", 171.);
+    REQUIRE(parameters->getParameter("mdl_MT") == Approx(171.));
+}
+
+TEST_CASE("Parameter hypotheses", "[integration_tests]") {
+    logging::set_level(logging::level::fatal);
+
+    auto weights = computeWeights("matrix_element.lua");
+    REQUIRE(weights.size() == 8);
+
+    // Nominal parameters
+    REQUIRE(weights[6].first / weights[0].first == Approx(1));
+
+    // Lighter and narrower top quark
+    const double hypothesis = weights[7].first;
+    REQUIRE(hypothesis / weights[0].first != Approx(1));
+
+    // Same as computing the weight with these parameters
+    ParameterSet parameters;
+    parameters.set("override_mass", 171.);
+    parameters.set("override_width", 1.45);
+
+    auto separate = computeWeights("matrix_element.lua", parameters);
+    REQUIRE(hypothesis / separate[0].first == Approx(1));
+}
+
+TEST_CASE("PDF table", "[integration_tests]") {
+    logging::set_level(logging::level::fatal);
+
+    const double nominal = computeWeights("matrix_element.lua")[0].first;
+
+    ParameterSet parameters;
+    parameters.set("pdf_table_points", 2000);
+    REQUIRE(computeWeights("matrix_element.lua", parameters)[0].first / nominal == Approx(1).epsilon(1e-3));
+
+    // Fewer nodes than needed by the interpolation
+    parameters.set("pdf_table_points", 3);
+    REQUIRE_THROWS(computeWeights("matrix_element.lua", parameters));
+
+    parameters.set("pdf_table_points", -1);
+    REQUIRE_THROWS(computeWeights("matrix_element.lua", parameters));
+}
@@ -0,0 +1,110 @@
+-- Same event and integrand as `no_integration.lua`, also computed for other members of the
+-- PDF set, other factorisation scales and other top-quark masses and widths
+--
+-- When `override_mass` and `override_width` are defined, they replace the top-quark mass and width of
+-- the matrix element, to compare the hypotheses with a separate computation.
+--
+-- When `pdf_table_points` is defined, PDFs are evaluated using an interpolation table with this number of nodes.
+
+local electron = declare_input("electron")
+local muon = declare_input("muon")
+local bjet1 = declare_input("bjet1")
+local bjet2 = declare_input("bjet2")
+local neutrino1 = declare_input("neutrino1")
+local neutrino2 = declare_input("neutrino2")
+
+parameters = {
+    energy = 13000.,
+    top_mass = 173.
+}
+
+inputs = {
+    electron.reco_p4,
+    bjet1.reco_p4,
+    muon.reco_p4,
+    bjet2.reco_p4,
+    neutrino1.reco_p4,
+    neutrino2.reco_p4
+}
+
+StandardPhaseSpace.phaseSpaceOut = {
+    particles = {electron.reco_p4, bjet1.reco_p4, muon.reco_p4, bjet2.reco_p4}
+}
+
+BuildInitialState.boost = {
+    do_transverse_boost = true,
+    particles = inputs
+}
+
+local ttbar = {
+    pdf = 'CT10nlo',
+    pdf_scale = parameter('top_mass'),
+    -- Nominal member first, as a reference
+    pdf_members = {0, 1},
+    -- Nominal scale first, as a reference
+    pdf_scale_variations = {1., 0.5, 2.},
+    -- Nominal parameters first, as a reference
+    hypotheses = {
+        { mdl_MT = 173., mdl_WT = 1.4915 },
+        { mdl_MT = 171., mdl_WT = 1.45 }
+    },
+    matrix_element = 'pp_ttx_fully_leptonic',
+    matrix_element_parameters = {
+        card = '../../MatrixElements/Cards/param_card.dat'
+    },
+    initialState = 'boost::partons',
+    particles = {
+        inputs = inputs,
+        ids = {
+            {
+                pdg_id = -11,
+                me_index = 1,
+            },
+
+            {
+                pdg_id = 5,
+                me_index = 3,
+            },
+
+            {
+                pdg_id = 13,
+                me_index = 4,
+            },
+
+            {
+                pdg_id = -5,
+                me_index = 6,
+            },
+
+            {
+                pdg_id = 12,
+                me_index = 2,
+            },
+
+            {
+                pdg_id = -14,
+                me_index = 5,
+            }
+        }
+    },
+    jacobians = {'phaseSpaceOut::phase_space'}
+}
+
+if override_mass then
+    ttbar.override_parameters = {
+        mdl_MT = override_mass,
+        mdl_WT = override_width
+    }
+end
+
+if pdf_table_points then
+    ttbar.pdf_table = true
+    ttbar.pdf_table_points = pdf_table_points
+end
+
+MatrixElement.ttbar = ttbar
+
+integrand("ttbar::output",
+        "ttbar::pdf_variations/1", "ttbar::pdf_variations/2",
+        "ttbar::pdf_variations/3", "ttbar::pdf_variations/4", "ttbar::pdf_variations/5",
+        "ttbar::hypotheses/1", "ttbar::hypotheses/2")
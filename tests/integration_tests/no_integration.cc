@@ -27,29 +27,38 @@
 #include <momemta/ConfigurationReader.h>
 #include <momemta/Logging.h>
 #include <momemta/MoMEMta.h>
+#include <momemta/ParameterSet.h>
+
+#include <memory>
 
 using namespace momemta;
 
+namespace {
+std::vector<Particle> event() {
+    return {
+        // Electron
+        { "electron", LorentzVector(16.171895980835, -13.7919054031372, -3.42997527122497, 21.5293197631836), -11 },
+        // Muon
+        { "muon", LorentzVector(-18.9018573760986, 10.0896110534668, -0.602926552295686, 21.4346446990967), +13 },
+        // b-quark
+        { "bjet1", LorentzVector(-55.7908325195313, -111.59294128418, -122.144721984863, 174.66259765625), 5 },
+        // Anti b-quark
+        { "bjet2", LorentzVector(71.3899612426758, 96.0094833374023, -77.2513122558594, 142.492813110352), -5 },
+        // Electronic neutrino
+        { "neutrino1", LorentzVector(-57.9413, 40.7629, -54.2982, 89.2587), +12 },
+        // Muonic neutrino
+        { "neutrino2", LorentzVector(57.9413, -40.7629, -40.8437, 81.7742), -14 }
+    };
+}
+}
+
 TEST_CASE("No integration", "[integration_tests]") {
     logging::set_level(logging::level::fatal);
 
     ConfigurationReader configuration("no_integration.lua");
     MoMEMta weight(configuration.freeze());
 
-    // Electron
-    Particle electron { "electron", LorentzVector(16.171895980835, -13.7919054031372, -3.42997527122497, 21.5293197631836), -11 };
-    // b-quark
-    Particle bjet1 { "bjet1", LorentzVector(-55.7908325195313, -111.59294128418, -122.144721984863, 174.66259765625), 5 };
-    // Muon
-    Particle muon { "muon", LorentzVector(-18.9018573760986, 10.0896110534668, -0.602926552295686, 21.4346446990967), +13 };
-    // Anti b-quark
-    Particle bjet2 { "bjet2", LorentzVector(71.3899612426758, 96.0094833374023, -77.2513122558594, 142.492813110352), -5 };
-    // Electronic neutrino
-    Particle nu1 { "neutrino1", LorentzVector(-57.9413, 40.7629, -54.2982, 89.2587), +12 };
-    // Muonic neutrino
-    Particle nu2 { "neutrino2", LorentzVector(57.9413, -40.7629, -40.8437, 81.7742), -14 };
-
-    std::vector<std::pair<double, double>> weights = weight.computeWeights({electron, muon, bjet1, bjet2, nu1, nu2});
+    std::vector<std::pair<double, double>> weights = weight.computeWeights(event());
 
     REQUIRE(weight.getIntegrationStatus() == MoMEMta::IntegrationStatus::SUCCESS);
 
@@ -57,3 +66,40 @@ TEST_CASE("No integration", "[integration_tests]") {
     REQUIRE(weights[0].first == Approx(8.36916e-13));
     REQUIRE(weights[0].second == Approx(0.));
 }
+
+TEST_CASE("Clone with a PDF", "[integration_tests]") {
+    logging::set_level(logging::level::fatal);
+
+    ConfigurationReader configuration("no_integration.lua");
+    std::unique_ptr<MoMEMta> weight(new MoMEMta(configuration.freeze()));
+
+    const double nominal = weight->computeWeights(event())[0].first;
+    REQUIRE(nominal > 0);
+
+    // Weights are tiny: compare the ratios to the nominal weight
+    auto ratio = [nominal](MoMEMta& weight) {
+        return weight.computeWeights(event())[0].first / nominal;
+    };
+
+    // The clone uses the PDF set and interpolation table loaded by the original engine
+    auto clone = weight->clone();
+    REQUIRE(ratio(*clone) == Approx(1));
+    REQUIRE(clone->getIntegrationStatus() == MoMEMta::IntegrationStatus::SUCCESS);
+
+    // A new scale gives the clone its own interpolation table, and does not change the original engine
+    ParameterSet parameters;
+    parameters.set("top_mass", 171.);
+    clone->updateParameters(parameters);
+
+    const double other_scale = ratio(*clone);
+    REQUIRE(other_scale != Approx(1));
+    REQUIRE(ratio(*weight) == Approx(1));
+
+    // The shared PDF set outlives the original engine
+    weight.reset();
+    REQUIRE(ratio(*clone) == Approx(other_scale));
+
+    parameters.set("top_mass", 173.);
+    clone->updateParameters(parameters);
+    REQUIRE(ratio(*clone) == Approx(1));
+}
@@ -0,0 +1,157 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Replacement of the global allocation functions, used to count the allocations done by the tests.
+ *
+ * They live in their own translation unit so that the compiler never sees the `malloc` / `free`
+ * pair behind a `new` / `delete` expression, and every replaceable form is provided so that all
+ * the allocations and deallocations of the binary go through the same allocator.
+ */
+
+#include "allocations.h"
+
+#include <cstdlib>
+#include <new>
+
+std::atomic<bool> count_allocations(false);
+std::atomic<std::size_t> n_allocations(0);
+
+namespace {
+void* allocate(std::size_t size) noexcept {
+    if (count_allocations.load(std::memory_order_relaxed))
+        n_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    return std::malloc(size ? size : 1);
+}
+
+void* allocate_or_throw(std::size_t size) {
+    if (void* ptr = allocate(size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+}
+
+void* operator new(std::size_t size) {
+    return allocate_or_throw(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate_or_throw(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+#endif
+
+#if defined(__cpp_aligned_new)
+namespace {
+void* allocate(std::size_t size, std::align_val_t alignment) noexcept {
+    if (count_allocations.load(std::memory_order_relaxed))
+        n_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    void* ptr = nullptr;
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (align < sizeof(void*))
+        align = sizeof(void*);
+
+    if (posix_memalign(&ptr, align, size ? size : 1) != 0)
+        return nullptr;
+
+    return ptr;
+}
+
+void* allocate_or_throw(std::size_t size, std::align_val_t alignment) {
+    if (void* ptr = allocate(size, alignment))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+#endif
@@ -0,0 +1,32 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/*
+ * The unit tests binary replaces the global allocation functions (see allocations.cc) so
+ * that tests can check that a piece of code does not allocate memory.
+ *
+ * Every call to one of the `operator new` overloads, from any thread, increments `n_allocations`
+ * while `count_allocations` is true.
+ */
+extern std::atomic<bool> count_allocations;
+extern std::atomic<std::size_t> n_allocations;
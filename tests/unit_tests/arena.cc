@@ -0,0 +1,85 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file
+ * \brief Unit tests for the per-point memory arena
+ * \sa momemta::Arena
+ * \ingroup UnitTests
+ */
+
+#include <catch.hpp>
+
+#include <momemta/Arena.h>
+#include <momemta/Pool.h>
+
+#include <cstdint>
+
+TEST_CASE("Memory arena", "[arena]") {
+
+    SECTION("Allocation") {
+        momemta::Arena arena(4096);
+
+        void* first = arena.allocate(100);
+        void* second = arena.allocate(8, 64);
+        REQUIRE(first != second);
+        REQUIRE(reinterpret_cast<uintptr_t>(second) % 64 == 0);
+        REQUIRE(arena.used() == 108);
+        REQUIRE(arena.allocations() == 2);
+        REQUIRE(arena.systemAllocations() == 1);
+
+        // Larger than a block
+        arena.allocate(10000);
+        REQUIRE(arena.systemAllocations() == 2);
+        REQUIRE(arena.capacity() >= 4096 + 10000);
+
+        // Memory is reused after a reset, without asking the system for more
+        arena.reset();
+        REQUIRE(arena.used() == 0);
+        REQUIRE(arena.peakUsage() == 10108);
+        REQUIRE(arena.allocate(100) == first);
+        arena.allocate(10000);
+        REQUIRE(arena.systemAllocations() == 2);
+    }
+
+    SECTION("Containers") {
+        momemta::Arena arena(4096, true);
+
+        for (size_t point = 0; point < 3; point++) {
+            arena.reset();
+
+            momemta::ArenaVector<double> values{momemta::ArenaAllocator<double>(arena)};
+            for (size_t i = 0; i < 1000; i++)
+                values.push_back(i);
+
+            REQUIRE(values[999] == 999);
+        }
+
+        // Blocks are only allocated while handling the first point
+        REQUIRE(arena.systemAllocations() == 1);
+    }
+
+    SECTION("Layered pools") {
+        auto pool = std::make_shared<Pool>();
+        Pool child(pool);
+
+        REQUIRE(&child.arena() != &pool->arena());
+        REQUIRE(child.arena().blockSize() == pool->arena().blockSize());
+    }
+}
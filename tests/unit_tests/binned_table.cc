@@ -0,0 +1,206 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Unit tests for the flat 2D lookup table
+ * \sa momemta::BinnedTable2D
+ * \sa momemta::BinnedTableSampler
+ * \ingroup UnitTests
+ */
+
+#include <catch.hpp>
+
+#include <momemta/BinnedTable2D.h>
+#include <momemta/BinnedTableSampler.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+using Axis = momemta::BinnedTable2D::Axis;
+
+TEST_CASE("Binned table", "[binned_table]") {
+
+    SECTION("Uniform axis") {
+        Axis axis(4, 0., 2.);
+
+        REQUIRE(axis.isUniform());
+        REQUIRE(axis.findBin(-0.1) == 0);
+        REQUIRE(axis.findBin(0.) == 1);
+        REQUIRE(axis.findBin(0.49) == 1);
+        REQUIRE(axis.findBin(0.5) == 2);
+        REQUIRE(axis.findBin(1.99999999) == 4);
+        REQUIRE(axis.findBin(2.) == 5);
+
+        REQUIRE(axis.lowEdge(2) == Approx(0.5));
+        REQUIRE(axis.upEdge(4) == Approx(2.));
+        REQUIRE(axis.binCenter(4) == Approx(1.75));
+    }
+
+    SECTION("Variable axis") {
+        Axis axis({0., 1., 5., 10.});
+
+        REQUIRE_FALSE(axis.isUniform());
+        REQUIRE(axis.nBins() == 3);
+        REQUIRE(axis.findBin(-1.) == 0);
+        REQUIRE(axis.findBin(0.) == 1);
+        REQUIRE(axis.findBin(1.) == 2);
+        REQUIRE(axis.findBin(7.) == 3);
+        REQUIRE(axis.findBin(10.) == 4);
+
+        REQUIRE(axis.binCenter(2) == Approx(3.));
+    }
+
+    SECTION("Table lookup") {
+        Axis x(2, 0., 2.);
+        Axis y(std::vector<double>{-1., 0., 1.});
+
+        // Global bin = bin_x + 4 * bin_y
+        std::vector<double> contents(16);
+        for (size_t i = 0; i < contents.size(); i++)
+            contents[i] = i;
+
+        momemta::BinnedTable2D table(x, y, contents);
+
+        REQUIRE(table.findBin(0.5, -0.5) == 5);
+        REQUIRE(table(1.5, 0.5) == Approx(10));
+        // Overflow in x, underflow in y
+        REQUIRE(table(3., -2.) == Approx(3));
+
+        std::vector<double> xs = {0.5, 1.5, 3., -1.};
+        std::vector<double> ys = {-0.5, 0.5, -2., 2.};
+        std::vector<double> out(xs.size());
+        table.evaluate(xs.data(), ys.data(), out.data(), xs.size());
+        for (size_t i = 0; i < xs.size(); i++)
+            REQUIRE(out[i] == table(xs[i], ys[i]));
+    }
+
+    SECTION("Native file format") {
+        std::vector<double> contents(6 * 5);
+        for (size_t i = 0; i < contents.size(); i++)
+            contents[i] = 0.5 * i;
+
+        momemta::BinnedTable2D uniform(Axis(4, 0., 4.), Axis(3, -1., 2.), contents);
+        momemta::BinnedTable2D variable(Axis(std::vector<double>{0., 1., 2., 4., 8.}), Axis(3, -1., 2.), contents);
+
+        const std::string path = "unit_tests_binned_table.bin";
+        momemta::BinnedTable2D::save(path, {{"uniform", &uniform}, {"variable", &variable}});
+
+        auto loaded_uniform = momemta::BinnedTable2D::load(path, "uniform");
+        auto loaded_variable = momemta::BinnedTable2D::load(path, "variable");
+
+        REQUIRE(loaded_uniform->xAxis().isUniform());
+        REQUIRE_FALSE(loaded_variable->xAxis().isUniform());
+        REQUIRE(loaded_variable->xAxis().upEdge(4) == Approx(8.));
+
+        for (double x: {-1., 0.5, 3.5, 6., 10.}) {
+            for (double y: {-2., -0.5, 1.5, 3.}) {
+                REQUIRE(loaded_uniform->operator()(x, y) == uniform(x, y));
+                REQUIRE(loaded_variable->operator()(x, y) == variable(x, y));
+            }
+        }
+
+        // Tables are shared as long as they are used
+        REQUIRE(momemta::BinnedTable2D::load(path, "uniform") == loaded_uniform);
+
+        REQUIRE_THROWS_AS(momemta::BinnedTable2D::load(path, "missing"), momemta::BinnedTable2D::table_not_found_error);
+
+        SECTION("Overwriting a mapped file") {
+            std::vector<double> other_contents(contents.size(), 42.);
+            momemta::BinnedTable2D other(Axis(4, 0., 4.), Axis(3, -1., 2.), other_contents);
+            momemta::BinnedTable2D::save(path, {{"uniform", &other}});
+
+            // Tables still in use keep the previous content
+            REQUIRE(loaded_uniform->operator()(0.5, -0.5) == uniform(0.5, -0.5));
+
+            loaded_uniform.reset();
+            loaded_variable.reset();
+            REQUIRE(momemta::BinnedTable2D::load(path, "uniform")->operator()(0.5, -0.5) == Approx(42.));
+        }
+
+        SECTION("Corrupted file") {
+            loaded_uniform.reset();
+            loaded_variable.reset();
+
+            // Number of x bins of the first table, just after the file header and the table name
+            std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(24 + 64);
+            const uint64_t n_bins = uint64_t(1) << 62;
+            file.write(reinterpret_cast<const char*>(&n_bins), sizeof(n_bins));
+            file.close();
+
+            REQUIRE_THROWS_AS(momemta::BinnedTable2D::load(path, "uniform"), momemta::BinnedTable2D::invalid_file_error);
+        }
+
+        std::remove(path.c_str());
+    }
+
+    SECTION("Sampling") {
+        // Two columns: a peaked one, and one empty except for a single bin
+        Axis x(2, 0., 2.);
+        Axis y(std::vector<double>{-2., -1., -0.5, 0.5, 1., 2.});
+        std::vector<double> contents(4 * 7);
+        const std::vector<double> peaked = {0.05, 0.1, 0.7, 0.1, 0.05};
+        for (size_t j = 1; j <= 5; j++)
+            contents[1 + 4 * j] = peaked[j - 1];
+        contents[2 + 4 * 3] = 1.;
+
+        auto table = std::make_shared<const momemta::BinnedTable2D>(x, y, contents);
+        momemta::BinnedTableSampler sampler(table);
+
+        REQUIRE(sampler.column(-1.) == 1);
+        REQUIRE(sampler.column(1.5) == 2);
+        REQUIRE(sampler.column(5.) == 2);
+
+        REQUIRE(sampler.cumulative(1, -2.) == Approx(0.));
+        REQUIRE(sampler.cumulative(1, 0.) == Approx(0.05 + 0.05 + 0.35));
+        REQUIRE(sampler.cumulative(1, 3.) == Approx(0.05 + 0.05 + 0.7 + 0.05 + 0.05));
+
+        // The integral of the TF is the same when sampling from the table or uniformly, and the mapping is monotonic
+        for (size_t column: {1, 2}) {
+            for (double alpha: {0., 0.1, 1.}) {
+                const double y_min = -2.;
+                const double y_max = 0.8;
+                const size_t n = 2000;
+
+                double integral = 0;
+                double previous = y_min;
+                for (size_t i = 0; i < n; i++) {
+                    double density;
+                    const double value = sampler.sample(column, y_min, y_max, alpha, (i + 0.5) / n, density);
+                    REQUIRE(value >= previous);
+                    REQUIRE(value <= y_max);
+                    previous = value;
+
+                    integral += (*table)(x.binCenter(column), value) / density / n;
+                }
+
+                const double expected = sampler.cumulative(column, y_max) - sampler.cumulative(column, y_min);
+                REQUIRE(integral == Approx(expected).epsilon(0.01));
+            }
+        }
+    }
+
+    SECTION("Invalid configuration") {
+        REQUIRE_THROWS_AS(Axis(0, 0., 1.), std::invalid_argument);
+        REQUIRE_THROWS_AS(Axis({1., 0.}), std::invalid_argument);
+        REQUIRE_THROWS_AS(momemta::BinnedTable2D(Axis(2, 0., 1.), Axis(2, 0., 1.), std::vector<double>(4)), std::invalid_argument);
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Unit tests for the conversion of ROOT histograms into flat 2D lookup tables
+ * \sa momemta::BinnedTable2D
+ * \ingroup UnitTests
+ */
+
+#include <catch.hpp>
+
+#include <momemta/BinnedTable2D.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <TH2.h>
+
+namespace {
+
+/// Edges of a uniform binning, the values just around them, and values outside the range
+std::vector<double> edgeValues(const TAxis& axis) {
+    const double min = axis.GetXmin();
+    const double max = axis.GetXmax();
+    const int n_bins = axis.GetNbins();
+
+    std::vector<double> values = {min - 1, max + 1};
+    for (int i = 0; i <= n_bins; i++) {
+        for (double edge: {min + i * (max - min) / n_bins, axis.GetBinLowEdge(i + 1)}) {
+            values.push_back(edge);
+            values.push_back(std::nextafter(edge, -std::numeric_limits<double>::infinity()));
+            values.push_back(std::nextafter(edge, std::numeric_limits<double>::infinity()));
+        }
+    }
+
+    return values;
+}
+
+}
+
+TEST_CASE("Binned table from ROOT", "[binned_table]") {
+
+    SECTION("Bins at the edges") {
+        // Bin widths not representable exactly, where rounding differs between formulas
+        TH2D th2("th2", "", 7, -0.3, 1.1, 100, 0., 0.3);
+        th2.SetDirectory(nullptr);
+
+        momemta::BinnedTable2D table = momemta::toBinnedTable(th2);
+
+        const auto xs = edgeValues(*th2.GetXaxis());
+        const auto ys = edgeValues(*th2.GetYaxis());
+
+        for (double x: xs)
+            REQUIRE(table.xAxis().findBin(x) == static_cast<size_t>(th2.GetXaxis()->FindFixBin(x)));
+
+        for (double y: ys)
+            REQUIRE(table.yAxis().findBin(y) == static_cast<size_t>(th2.GetYaxis()->FindFixBin(y)));
+
+        for (double x: xs) {
+            for (double y: ys)
+                REQUIRE(table.findBin(x, y) == static_cast<size_t>(th2.FindFixBin(x, y)));
+        }
+    }
+}
@@ -0,0 +1,396 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file
+ * \brief Unit tests for the binary format of frozen configurations
+ * \sa Configuration
+ * \ingroup UnitTests
+ */
+
+#include <catch.hpp>
+
+#include <momemta/Configuration.h>
+#include <momemta/ConfigurationReader.h>
+#include <momemta/Logging.h>
+#include <momemta/MoMEMta.h>
+#include <momemta/Module.h>
+#include <momemta/ModuleFactory.h>
+#include <momemta/ParameterSet.h>
+#include <momemta/Path.h>
+#include <momemta/Solution.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace {
+const std::string CONFIGURATION = R"(
+parameters = {
+    energy = 13000.,
+    top_mass = 173.,
+}
+
+cuba = {
+    relative_accuracy = 0.01,
+    n_start = 500,
+}
+
+BreitWignerGenerator.flatter = {
+    ps_point = add_dimension(),
+    mass = parameter('top_mass'),
+    width = top_width,
+    flags = {true, false},
+    tags = {'a::b', 'c::d/2'},
+    nested = { values = {1, 2, 3} },
+}
+
+declare_input('lepton')
+
+Looper.looper = {
+    solutions = 'flatter::s',
+    path = Path('flatter'),
+}
+
+integrand('flatter::jacobian')
+)";
+
+size_t countFiles(const std::string& directory) {
+    size_t n = 0;
+    DIR* dir = opendir(directory.c_str());
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.')
+            n++;
+    }
+    closedir(dir);
+
+    return n;
+}
+
+/// Module registered by the test, changing the list of available modules
+class UnitTestsCacheModule: public Module {
+    public:
+        UnitTestsCacheModule(PoolPtr pool, const ParameterSet& parameters): Module(pool, parameters.getModuleName()) {
+            // Empty
+        }
+};
+
+/// Two solutions, of jacobians `energy` and 2 * `energy`, where `energy` is read from the global parameters
+class UnitTestsSolutions: public Module {
+    public:
+        /// Number of instances created so far
+        static size_t instances;
+
+        UnitTestsSolutions(PoolPtr pool, const ParameterSet& parameters): Module(pool, parameters.getModuleName()) {
+            m_energy = parameters.globalParameters().get<double>("energy");
+            if (m_energy < 0)
+                throw Module::invalid_configuration("Negative energy");
+
+            instances++;
+        }
+
+        virtual Status work() override {
+            m_solutions->clear();
+            m_solutions->push_back({LorentzVector()}, m_energy);
+            m_solutions->push_back({LorentzVector()}, 2 * m_energy);
+
+            return Status::OK;
+        }
+
+    private:
+        double m_energy;
+
+        std::shared_ptr<SolutionCollection> m_solutions = produce<SolutionCollection>("solutions");
+};
+size_t UnitTestsSolutions::instances = 0;
+REGISTER_MODULE(UnitTestsSolutions);
+
+/// Write a configuration summing, over the solutions of UnitTestsSolutions, their jacobian and a parameter
+void writeLooperConfiguration(const std::string& lua_file, int64_t threads) {
+    std::ofstream(lua_file) << R"(
+parameters = {
+    energy = 10.,
+    factor = 2.,
+}
+
+UnitTestsSolutions.block = {}
+
+DoubleConstant.factor = { value = parameter('factor') }
+DoubleLooperSummer.jacobians = { input = 'looper::jacobian' }
+DoubleLooperSummer.factors = { input = 'factor::value' }
+
+Looper.looper = {
+    solutions = 'block::solutions',
+    path = Path('factor', 'jacobians', 'factors'),
+    threads = )" << threads << R"(,
+}
+
+integrand('jacobians::sum', 'factors::sum')
+)";
+}
+
+std::vector<double> values(MoMEMta& weight) {
+    std::vector<double> result;
+    for (const auto& w: weight.computeWeights({}))
+        result.push_back(w.first);
+    return result;
+}
+
+void removeDirectory(const std::string& directory) {
+    DIR* dir = opendir(directory.c_str());
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.')
+            std::remove((directory + "/" + entry->d_name).c_str());
+    }
+    closedir(dir);
+    rmdir(directory.c_str());
+}
+}
+
+TEST_CASE("Frozen configuration cache", "[configuration]") {
+
+    // Suppress log messages
+    logging::set_level(logging::level::fatal);
+
+    const std::string lua_file = "unit_tests_configuration.lua";
+    std::ofstream(lua_file) << CONFIGURATION;
+
+    ParameterSet parameters;
+    parameters.set("top_width", 1.5);
+
+    auto check = [](const Configuration& c) {
+        REQUIRE(c.getNDimensions() == 1);
+        REQUIRE(c.getInputs() == std::vector<std::string>({"lepton"}));
+        REQUIRE(c.getIntegrands() == std::vector<InputTag>({InputTag("flatter", "jacobian")}));
+        REQUIRE(c.getCubaConfiguration().get<int64_t>("n_start") == 500);
+        REQUIRE(c.getGlobalParameters().get<double>("energy") == 13000.);
+
+        REQUIRE(c.getPaths().size() == 1);
+        REQUIRE(c.getPaths()[0]->elements == std::vector<std::string>({"flatter"}));
+
+        const auto& modules = c.getModules();
+        REQUIRE(modules.size() == 2);
+        REQUIRE(modules[0].type == "BreitWignerGenerator");
+        REQUIRE(modules[0].name == "flatter");
+        REQUIRE(modules[1].name == "looper");
+
+        const ParameterSet& flatter = *modules[0].parameters;
+        REQUIRE(flatter.getModuleName() == "flatter");
+        REQUIRE(flatter.get<InputTag>("ps_point").isIndexed());
+        REQUIRE(flatter.get<double>("mass") == 173.);
+        REQUIRE(flatter.get<double>("width") == 1.5);
+        REQUIRE(flatter.get<std::vector<bool>>("flags") == std::vector<bool>({true, false}));
+        REQUIRE(flatter.get<std::vector<InputTag>>("tags")[1].index == 1);
+        REQUIRE(flatter.get<ParameterSet>("nested").get<std::vector<int64_t>>("values").size() == 3);
+        REQUIRE(flatter.globalParameters().get<double>("energy") == 13000.);
+
+        REQUIRE(modules[1].parameters->existsAs<Path>("path"));
+    };
+
+    SECTION("Round trip") {
+        ConfigurationReader reader(lua_file, parameters);
+        Configuration configuration = reader.freeze();
+        check(configuration);
+
+        const std::string path = "unit_tests_configuration.bin";
+        configuration.save(path);
+        check(Configuration::load(path));
+        std::remove(path.c_str());
+
+        REQUIRE_THROWS_AS(Configuration::load(lua_file), Configuration::invalid_file_error);
+    }
+
+    SECTION("Cache") {
+        char directory[] = "unit_tests_cache_XXXXXX";
+        REQUIRE(mkdtemp(directory));
+
+        check(ConfigurationReader::readCached(lua_file, parameters, directory));
+        REQUIRE(countFiles(directory) == 1);
+
+        // Cache hit
+        check(ConfigurationReader::readCached(lua_file, parameters, directory));
+        REQUIRE(countFiles(directory) == 1);
+
+        // Different injected parameters use a different cache
+        parameters.set("top_width", 2.);
+        Configuration configuration = ConfigurationReader::readCached(lua_file, parameters, directory);
+        REQUIRE(configuration.getModules()[0].parameters->get<double>("width") == 2.);
+        REQUIRE(countFiles(directory) == 2);
+
+        // A new module type uses a different cache
+        static const ModuleFactory::PMaker<UnitTestsCacheModule> maker("UnitTestsCacheModule");
+        ConfigurationReader::readCached(lua_file, parameters, directory);
+        REQUIRE(countFiles(directory) == 3);
+
+        removeDirectory(directory);
+    }
+
+    std::remove(lua_file.c_str());
+}
+
+TEST_CASE("Global parameters update", "[configuration]") {
+
+    // Suppress log messages
+    logging::set_level(logging::level::fatal);
+
+    const std::string lua_file = "unit_tests_parameters.lua";
+    std::ofstream(lua_file) << R"(
+parameters = {
+    factor = 2.,
+    offset = 1.,
+}
+
+DoubleConstant.factor = { value = parameter('factor') }
+DoubleConstant.offset = { value = parameter('offset') }
+DoubleConstant.fixed = { value = 3. }
+
+integrand('factor::value', 'offset::value', 'fixed::value')
+)";
+
+    char directory[] = "unit_tests_cache_XXXXXX";
+    REQUIRE(mkdtemp(directory));
+
+    // Bindings to global parameters are kept in the binary format
+    ConfigurationReader::readCached(lua_file, ParameterSet(), directory);
+    MoMEMta weight(ConfigurationReader::readCached(lua_file, ParameterSet(), directory));
+
+    REQUIRE(values(weight) == std::vector<double>({2., 1., 3.}));
+
+    ParameterSet parameters;
+    parameters.set("factor", 5.);
+    weight.updateParameters(parameters);
+    REQUIRE(values(weight) == std::vector<double>({5., 1., 3.}));
+
+    parameters.set("offset", -1.);
+    weight.updateParameters(parameters);
+    REQUIRE(values(weight) == std::vector<double>({5., -1., 3.}));
+
+    ParameterSet unknown;
+    unknown.set("unknown", 1.);
+    REQUIRE_THROWS(weight.updateParameters(unknown));
+
+    removeDirectory(directory);
+
+    std::remove(lua_file.c_str());
+}
+
+TEST_CASE("Global parameters update of a looper", "[configuration]") {
+
+    // Suppress log messages
+    logging::set_level(logging::level::fatal);
+
+    auto run = [](int64_t threads) {
+        const std::string lua_file = "unit_tests_parameters_looper.lua";
+        writeLooperConfiguration(lua_file, threads);
+
+        ConfigurationReader reader(lua_file);
+        MoMEMta weight(reader.freeze());
+        std::remove(lua_file.c_str());
+
+        REQUIRE(values(weight) == std::vector<double>({30., 4.}));
+        const size_t instances = UnitTestsSolutions::instances;
+
+        // Only the modules of the path, and the looper, are re-created
+        ParameterSet parameters;
+        parameters.set("factor", 3.);
+        weight.updateParameters(parameters);
+        REQUIRE(values(weight) == std::vector<double>({30., 6.}));
+        REQUIRE(UnitTestsSolutions::instances == instances);
+
+        parameters.set("energy", 20.);
+        weight.updateParameters(parameters);
+        REQUIRE(values(weight) == std::vector<double>({60., 6.}));
+        REQUIRE(UnitTestsSolutions::instances == instances + 1);
+
+        // A failed update leaves the instance as it was
+        parameters.set("energy", -1.);
+        parameters.set("factor", 4.);
+        REQUIRE_THROWS(weight.updateParameters(parameters));
+        REQUIRE(values(weight) == std::vector<double>({60., 6.}));
+
+        parameters.set("energy", 5.);
+        weight.updateParameters(parameters);
+        REQUIRE(values(weight) == std::vector<double>({15., 8.}));
+    };
+
+    SECTION("Single thread") {
+        run(1);
+    }
+
+    SECTION("Concurrent looper") {
+        run(2);
+    }
+}
+
+TEST_CASE("Clone", "[configuration]") {
+
+    // Suppress log messages
+    logging::set_level(logging::level::fatal);
+
+    auto run = [](int64_t threads) {
+        const std::string lua_file = "unit_tests_clone.lua";
+        writeLooperConfiguration(lua_file, threads);
+
+        ConfigurationReader reader(lua_file);
+        std::unique_ptr<MoMEMta> weight(new MoMEMta(reader.freeze()));
+        std::remove(lua_file.c_str());
+
+        REQUIRE(values(*weight) == std::vector<double>({30., 4.}));
+
+        // The modules of the path are created for the clone, and run by its own looper
+        auto clone = weight->clone();
+        REQUIRE(values(*clone) == std::vector<double>({30., 4.}));
+
+        // Clones are independent from the original engine
+        ParameterSet parameters;
+        parameters.set("factor", 3.);
+        weight->updateParameters(parameters);
+        REQUIRE(values(*weight) == std::vector<double>({30., 6.}));
+        REQUIRE(values(*clone) == std::vector<double>({30., 4.}));
+
+        ParameterSet clone_parameters;
+        clone_parameters.set("energy", 20.);
+        clone->updateParameters(clone_parameters);
+        REQUIRE(values(*clone) == std::vector<double>({60., 4.}));
+        REQUIRE(values(*weight) == std::vector<double>({30., 6.}));
+
+        // The clone does not depend on the original engine
+        weight.reset();
+        REQUIRE(values(*clone) == std::vector<double>({60., 4.}));
+
+        // Its paths are its own: re-creating their modules does not touch the original ones
+        clone_parameters.set("factor", 5.);
+        clone->updateParameters(clone_parameters);
+        REQUIRE(values(*clone) == std::vector<double>({60., 10.}));
+    };
+
+    SECTION("Single thread") {
+        run(1);
+    }
+
+    SECTION("Concurrent looper") {
+        run(2);
+    }
+}
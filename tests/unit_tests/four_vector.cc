@@ -0,0 +1,121 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file
+ * \brief Unit tests for the native four-vector type
+ * \sa momemta::FourVector
+ * \ingroup UnitTests
+ */
+
+#include <catch.hpp>
+
+#include <momemta/FourVector.h>
+#include <momemta/Math.h>
+#include <momemta/Types.h>
+
+#include <stdexcept>
+#include <type_traits>
+
+using momemta::FourVector;
+using momemta::FourVectorBatch;
+
+TEST_CASE("Four-vectors", "[four_vector]") {
+
+    const LorentzVector lv(16.171895980835, -13.7919054031372, -3.42997527122497, 21.5293197631836);
+    const FourVector v(lv);
+
+    SECTION("Conversions") {
+        REQUIRE(std::is_trivially_copyable<FourVector>::value);
+        REQUIRE(v.toLorentzVector() == lv);
+    }
+
+    SECTION("Derived quantities") {
+        REQUIRE(v.M() == Approx(lv.M()));
+        REQUIRE(v.M2() == Approx(lv.M2()));
+        REQUIRE(v.P() == Approx(lv.P()));
+        REQUIRE(v.Pt() == Approx(lv.Pt()));
+        REQUIRE(v.Eta() == Approx(lv.Eta()));
+        REQUIRE(v.Phi() == Approx(lv.Phi()));
+        REQUIRE(v.Theta() == Approx(lv.Theta()));
+        REQUIRE(v.CosTheta() == Approx(std::cos(lv.Theta())));
+        REQUIRE(v.SinTheta() == Approx(std::sin(lv.Theta())));
+        REQUIRE(v.Dot(v) == Approx(lv.M2()));
+
+        const FourVector space_like(1., 2., 3., 1.);
+        REQUIRE(space_like.M() == Approx(-std::sqrt(13.)));
+    }
+
+    SECTION("Rescaling") {
+        // Same direction and mass, different energy
+        const double e = 2 * v.E();
+        const FourVector scaled = v.withMomentum(std::sqrt(SQ(e) - v.M2()), e);
+        REQUIRE(scaled.E() == e);
+        REQUIRE(scaled.M() == Approx(v.M()));
+        REQUIRE(scaled.Eta() == Approx(v.Eta()));
+        REQUIRE(scaled.Phi() == Approx(v.Phi()));
+
+        const FourVector scaled_pt = v.withPt(2 * v.Pt(), e);
+        REQUIRE(scaled_pt.Pt() == Approx(2 * v.Pt()));
+        REQUIRE(scaled_pt.Eta() == Approx(v.Eta()));
+        REQUIRE(scaled_pt.Phi() == Approx(v.Phi()));
+    }
+
+    SECTION("Boosts") {
+        // To the rest frame and back
+        const FourVector rest = v.boosted(-v.Px() / v.E(), -v.Py() / v.E(), -v.Pz() / v.E());
+        REQUIRE(rest.P() == Approx(0).epsilon(1e-6));
+        REQUIRE(rest.E() == Approx(v.M()));
+
+        const FourVector back = rest.boosted(v.Px() / v.E(), v.Py() / v.E(), v.Pz() / v.E());
+        REQUIRE(back.Px() == Approx(v.Px()));
+        REQUIRE(back.Pz() == Approx(v.Pz()));
+        REQUIRE(back.E() == Approx(v.E()));
+
+        // Invariant
+        const FourVector boosted = v.boosted(0.3, -0.2, 0.1);
+        REQUIRE(boosted.M2() == Approx(v.M2()));
+    }
+
+    SECTION("Batches") {
+        FourVectorBatch batch;
+        batch.push_back(v);
+        batch.push_back(FourVector(1., 2., 3., 10.));
+        batch.push_back(FourVector(1., 2., 3., 1.));
+        REQUIRE(batch.size() == 3);
+
+        double masses[3], pts[3], momenta[3], pairs[3];
+        batch.masses(masses);
+        batch.pts(pts);
+        batch.momenta(momenta);
+        batch.pairMasses2(batch, pairs);
+        for (size_t i = 0; i < batch.size(); i++) {
+            REQUIRE(masses[i] == Approx(batch[i].M()));
+            REQUIRE(pts[i] == Approx(batch[i].Pt()));
+            REQUIRE(momenta[i] == Approx(batch[i].P()));
+            REQUIRE(pairs[i] == Approx(4 * batch[i].M2()));
+        }
+
+        batch.boost(0.3, -0.2, 0.1);
+        REQUIRE(batch[0].Px() == Approx(v.boosted(0.3, -0.2, 0.1).Px()));
+        REQUIRE(batch[0].E() == Approx(v.boosted(0.3, -0.2, 0.1).E()));
+
+        REQUIRE_THROWS_AS(batch.pairMasses2(FourVectorBatch(2), pairs), std::invalid_argument);
+    }
+}
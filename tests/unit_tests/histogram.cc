@@ -0,0 +1,132 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file
+ * \brief Unit tests for the histograms used by the DMEM module
+ * \sa momemta::Histogram
+ * \sa ShardedHistogram
+ * \ingroup UnitTests
+ */
+
+#include <catch.hpp>
+
+#include <momemta/Histogram.h>
+
+#include <ShardedHistogram.h>
+
+#include <stdexcept>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+TEST_CASE("Histograms", "[histogram]") {
+
+    SECTION("Histogram") {
+        momemta::Histogram hist(4, 0., 2.);
+
+        hist.fill(-1., 3.);
+        hist.fill(0.1, 2.);
+        hist.fill(0.2, 1.);
+        hist.fill(1.9);
+        hist.fill(2.);
+
+        REQUIRE(hist.binContent(0) == Approx(3.));
+        REQUIRE(hist.binContent(1) == Approx(3.));
+        REQUIRE(hist.binSumw2(1) == Approx(5.));
+        REQUIRE(hist.binContent(4) == Approx(1.));
+        REQUIRE(hist.binContent(5) == Approx(1.));
+        REQUIRE(hist.integral() == Approx(4.));
+        REQUIRE(hist.entries() == 5);
+
+        momemta::Histogram other(4, 0., 2.);
+        other.fill(0.6, 2.);
+        other.fill(0.7);
+        hist += other;
+        REQUIRE(hist.binContent(2) == Approx(3.));
+        REQUIRE(hist.entries() == 7);
+
+        REQUIRE_THROWS_AS(hist += momemta::Histogram(5, 0., 2.), std::invalid_argument);
+
+        hist.reset();
+        REQUIRE(hist.integral() == 0);
+        REQUIRE(hist.entries() == 0);
+    }
+
+    SECTION("Sharded histogram") {
+        ShardedHistogram accumulator(2, 10, 0., 10., 4);
+
+        accumulator.fill(0, 0.5, 1.);
+        accumulator.fill(1, 9.5, 2.);
+
+        SECTION("Single process") {
+            auto first = accumulator.merge(0);
+            REQUIRE(first.binContent(1) == Approx(1.));
+            REQUIRE(first.integral() == Approx(1.));
+
+            auto second = accumulator.merge(1);
+            REQUIRE(second.binContent(10) == Approx(2.));
+            REQUIRE(second.binSumw2(10) == Approx(4.));
+            REQUIRE(second.entries() == 1);
+
+            accumulator.reset();
+            REQUIRE(accumulator.merge(0).integral() == 0);
+            REQUIRE(accumulator.merge(1).integral() == 0);
+        }
+
+        SECTION("Forked processes") {
+            // More processes than shards: some of them share a shard
+            const size_t n_processes = 6;
+            for (size_t i = 0; i < n_processes; i++) {
+                pid_t pid = fork();
+                if (pid == 0) {
+                    for (size_t j = 0; j < 1000; j++)
+                        accumulator.fill(0, 2.5, 1.);
+                    _exit(0);
+                }
+
+                REQUIRE(pid > 0);
+            }
+
+            for (size_t i = 0; i < n_processes; i++) {
+                int status = 0;
+                wait(&status);
+                REQUIRE(WIFEXITED(status));
+            }
+
+            auto merged = accumulator.merge(0);
+            REQUIRE(merged.binContent(1) == Approx(1.));
+            REQUIRE(merged.binContent(3) == Approx(n_processes * 1000.));
+            REQUIRE(merged.entries() == n_processes * 1000 + 1);
+        }
+
+        SECTION("Absorb") {
+            ShardedHistogram copy(2, 10, 0., 10., 4);
+            copy.fill(0, 0.5, 3.);
+
+            accumulator.absorb(copy);
+            REQUIRE(accumulator.merge(0).binContent(1) == Approx(4.));
+            REQUIRE(accumulator.merge(0).entries() == 2);
+            REQUIRE(copy.merge(0).integral() == 0);
+
+            ShardedHistogram other_layout(1, 10, 0., 10., 4);
+            REQUIRE_THROWS_AS(accumulator.absorb(other_layout), std::invalid_argument);
+        }
+    }
+}
@@ -0,0 +1,145 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file
+ * \brief Unit tests for the conversion of histograms into ROOT histograms, and for the ROOT output of DMEM
+ * \sa momemta::Histogram
+ * \ingroup UnitTests
+ */
+
+#include <catch.hpp>
+
+#include <momemta/ConfigurationReader.h>
+#include <momemta/Histogram.h>
+#include <momemta/Logging.h>
+#include <momemta/MoMEMta.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <TH1D.h>
+
+TEST_CASE("Histograms to ROOT", "[histogram]") {
+    momemta::Histogram hist(4, 0., 2.);
+
+    hist.fill(-1., 3.);
+    hist.fill(0.1, 2.);
+    hist.fill(0.2, 1.);
+    hist.fill(0.6, 2.);
+    hist.fill(1.9);
+    hist.fill(2.);
+    hist.fill(2.);
+
+    SECTION("New histogram") {
+        auto th1 = hist.toTH1D("test");
+        REQUIRE(th1->GetNbinsX() == 4);
+        REQUIRE(th1->GetBinContent(0) == Approx(3.));
+        REQUIRE(th1->GetBinContent(1) == Approx(3.));
+        REQUIRE(th1->GetBinError(1) == Approx(std::sqrt(5.)));
+        REQUIRE(th1->GetBinContent(5) == Approx(2.));
+        REQUIRE(th1->Integral() == Approx(hist.integral()));
+        REQUIRE(th1->GetEntries() == 7);
+    }
+
+    SECTION("Existing histogram") {
+        TH1D th1("existing", "", 4, 0., 2.);
+        th1.SetDirectory(nullptr);
+        th1.Fill(0.5, 10.);
+
+        hist.fillTH1D(th1);
+        REQUIRE(th1.GetBinContent(1) == Approx(3.));
+        REQUIRE(th1.GetBinContent(2) == Approx(2.));
+        REQUIRE(th1.GetEntries() == 7);
+
+        TH1D other_binning("other_binning", "", 5, 0., 2.);
+        other_binning.SetDirectory(nullptr);
+        REQUIRE_THROWS_AS(hist.fillTH1D(other_binning), std::invalid_argument);
+    }
+}
+
+TEST_CASE("DMEM after a global parameters update", "[histogram]") {
+
+    // Suppress log messages
+    logging::set_level(logging::level::fatal);
+
+    const std::string lua_file = "unit_tests_dmem.lua";
+    std::ofstream(lua_file) << R"(
+load_root_plugin()
+
+parameters = {
+    n_bins = 5,
+    value = 2.,
+}
+
+DoubleConstant.value = { value = parameter('value') }
+DoubleConstant.one = { value = 1. }
+
+DMEM.dmem = {
+    x_start = 0.,
+    x_end = 10.,
+    n_bins = parameter('n_bins'),
+    observables = { 'value::value' },
+    ps_weight = 'one::value',
+    me_output = 'value::value',
+}
+
+integrand('value::value')
+)";
+
+    ConfigurationReader reader(lua_file);
+    MoMEMta weight(reader.freeze());
+    std::remove(lua_file.c_str());
+
+    auto hist = weight.getPool().get<TH1D>({"dmem", "hist"});
+    auto histograms = weight.getPool().get<std::vector<momemta::Histogram>>({"dmem", "histograms"});
+    const TH1D* address = hist.get();
+
+    weight.computeWeights({});
+    REQUIRE(hist->GetNbinsX() == 5);
+    REQUIRE(histograms->front().nBins() == 5);
+
+    // The histogram is created again in the same memory block, with the new binning
+    ParameterSet parameters;
+    parameters.set("n_bins", 8);
+    weight.updateParameters(parameters);
+    REQUIRE(weight.getPool().get<TH1D>({"dmem", "hist"}).get() == address);
+
+    weight.computeWeights({});
+    REQUIRE(hist->GetNbinsX() == 8);
+    REQUIRE(hist->GetEntries() == 1);
+    REQUIRE(histograms->front().nBins() == 8);
+
+    // An invalid binning is rejected, and the instance keeps the previous one
+    parameters.set("n_bins", 0);
+    REQUIRE_THROWS(weight.updateParameters(parameters));
+
+    parameters.set("value", 3.);
+    parameters.set("n_bins", 8);
+    weight.updateParameters(parameters);
+    REQUIRE(weight.computeWeights({}).front().first == 3.);
+    REQUIRE(hist->GetNbinsX() == 8);
+    // Bin 0 is the underflow: 3 is in the third bin of [0, 10]
+    REQUIRE(histograms->front().binContent(3) == Approx(3.));
+    REQUIRE(histograms->front().binContent(2) == 0.);
+}
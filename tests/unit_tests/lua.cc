@@ -72,11 +72,16 @@ class LuaCallbackMock: public ILuaCallback {
             inputs.push_back(name);
         }
 
+        virtual void onLibraryLoaded(const std::string& path) override {
+            libraries.push_back(path);
+        }
+
         std::vector<std::pair<std::string, std::string>> modules;
         std::vector<InputTag> integrands;
         std::vector<PathElementsPtr> paths;
         std::size_t n_dimensions;
         std::vector<std::string> inputs;
+        std::vector<std::string> libraries;
 };
 
 // A small mock of LazyParameterSet to change visibility of the `freeze` function
@@ -102,6 +107,7 @@ TEST_CASE("lua parsing utilities", "[lua]") {
 
     SECTION("custom functions") {
         execute_string(L, "load_modules('not_existing.so')");
+        REQUIRE(luaCallback.libraries == std::vector<std::string>({"not_existing.so"}));
         execute_string(L, "parameter('not_existing')");
 
         // Check that the 'add_dimension()' function returns the correct InputTag
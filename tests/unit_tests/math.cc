@@ -0,0 +1,147 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Unit tests for the mathematical functions
+ * \ingroup UnitTests
+ */
+
+#include <catch.hpp>
+
+#include <momemta/Math.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("Polynomial solvers", "[math]") {
+
+    SECTION("Roots container") {
+        Roots roots;
+        REQUIRE(roots.empty());
+
+        for (double x: {1., 2., 3., 4.})
+            roots.push_back(x);
+        REQUIRE_THROWS_AS(roots.push_back(5.), std::length_error);
+
+        roots.erase(roots.begin() + 1);
+        REQUIRE(roots.size() == 3);
+        REQUIRE(roots[1] == 3.);
+        REQUIRE_THROWS_AS(roots.at(3), std::out_of_range);
+
+        roots.clear();
+        REQUIRE(roots.empty());
+    }
+
+    SECTION("Quartic") {
+        // (x - 1)(x + 2)(x - 3)(x + 0.5) = x^4 - 1.5 x^3 - 6 x^2 + 3.5 x + 3
+        Roots roots;
+        REQUIRE(solveQuartic(1., -1.5, -6., 3.5, 3., roots));
+        REQUIRE(roots.size() == 4);
+
+        std::vector<double> expected = {-2., -0.5, 1., 3.};
+        std::vector<double> found(roots.begin(), roots.end());
+        std::sort(found.begin(), found.end());
+        for (size_t i = 0; i < 4; i++)
+            REQUIRE(found[i] == Approx(expected[i]));
+
+        // Same results with a std::vector
+        std::vector<double> vector_roots;
+        REQUIRE(solveQuartic(1., -1.5, -6., 3.5, 3., vector_roots));
+        REQUIRE(std::equal(vector_roots.begin(), vector_roots.end(), roots.begin()));
+
+        // No real solution
+        roots.clear();
+        REQUIRE_FALSE(solveQuartic(1., 0., 1., 0.5, 1., roots));
+        REQUIRE(roots.empty());
+    }
+
+    SECTION("System of two quadratic equations") {
+        // Unit circle intersecting the hyperbola x * y = 0.25
+        Roots E1, E2;
+        REQUIRE(solve2Quads(1., 1., 0., 0., 0., -1., 0., 0., 1., 0., 0., -0.25, E1, E2));
+        REQUIRE(E1.size() == 4);
+        REQUIRE(E2.size() == 4);
+        for (size_t i = 0; i < E1.size(); i++) {
+            REQUIRE(SQ(E1[i]) + SQ(E2[i]) == Approx(1.));
+            REQUIRE(E1[i] * E2[i] == Approx(0.25));
+        }
+    }
+
+    SECTION("Batch of quartics") {
+        // Mix general equations with all the special cases
+        std::vector<double> a = {1., 0., 2., 1., 1., -3., 1., 0.5};
+        std::vector<double> b = {-1.5, 1., 0., 0., 0., 1., 4., -2.};
+        std::vector<double> c = {-6., -3., -8., 0., 1., 2., -1., 0.3};
+        std::vector<double> d = {3.5, 2., 0., 0., 0.5, -1., 0., 1.};
+        std::vector<double> e = {3., 0., 2., 0., 1., 0.2, -2., -0.1};
+
+        std::vector<Roots> batch(a.size());
+        solveQuarticBatch(a.size(), a.data(), b.data(), c.data(), d.data(), e.data(), batch.data());
+
+        for (size_t i = 0; i < a.size(); i++) {
+            Roots roots;
+            solveQuartic(a[i], b[i], c[i], d[i], e[i], roots);
+
+            REQUIRE(batch[i].size() == roots.size());
+            for (size_t j = 0; j < roots.size(); j++)
+                REQUIRE(batch[i][j] == Approx(roots[j]));
+        }
+    }
+}
+
+TEST_CASE("Normal distribution", "[math]") {
+
+    SECTION("Density and cumulative distribution") {
+        REQUIRE(normalPdf(0.) == Approx(0.3989422804014327));
+        REQUIRE(normalPdf(3., 2., 1.) == Approx(0.3989422804014327 * std::exp(-0.5) / 2.));
+        REQUIRE(normalCdf(0.) == Approx(0.5));
+        REQUIRE(normalCdf(1.96) == Approx(0.9750021048517795));
+        REQUIRE(normalCdf(-1., 2., 1.) == Approx(0.15865525393145707));
+    }
+
+    SECTION("Quantile") {
+        REQUIRE(std::abs(normalQuantile(0.5)) < 1e-12);
+        REQUIRE(normalQuantile(0.975) == Approx(1.959963984540054));
+        REQUIRE(normalQuantile(0.025, 2.) == Approx(-2 * 1.959963984540054));
+        REQUIRE(std::isinf(normalQuantile(0.)));
+
+        // Central region and both tails
+        for (double p: {1e-300, 1e-10, 0.01, 0.3, 0.6, 0.99, 1 - 1e-12})
+            REQUIRE(normalCdf(normalQuantile(p)) == Approx(p).epsilon(1e-12));
+    }
+}
+
+TEST_CASE("Angles between vectors", "[math]") {
+    struct Vector {
+        double x, y, z;
+        double Px() const { return x; }
+        double Py() const { return y; }
+        double Pz() const { return z; }
+        double Phi() const { return std::atan2(y, x); }
+    };
+
+    REQUIRE(cosTheta(Vector{1, 0, 0}, Vector{0, 2, 0}) == 0.);
+    REQUIRE(cosTheta(Vector{1, 1, 0}, Vector{2, 2, 0}) == Approx(1.));
+    REQUIRE(cosTheta(Vector{0, 0, 0}, Vector{2, 2, 0}) == 0.);
+
+    REQUIRE(deltaPhi(Vector{1, 0, 0}, Vector{0, 1, 0}) == Approx(M_PI / 2));
+    REQUIRE(deltaPhi(Vector{-1, 0.1, 0}, Vector{-1, -0.1, 0}) == Approx(2 * std::atan(0.1)).epsilon(1e-12));
+}
@@ -25,14 +25,22 @@
 
 #include <catch.hpp>
 
+#include <momemta/BinnedTable2D.h>
+#include <momemta/MatrixElement.h>
+#include <momemta/MatrixElementFactory.h>
 #include <momemta/ModuleFactory.h>
 #include <momemta/Module.h>
 #include <momemta/ParameterSet.h>
+#include <momemta/Path.h>
 #include <momemta/Pool.h>
 #include <momemta/Solution.h>
 #include <momemta/Types.h>
 #include <momemta/Math.h>
 
+#include <cmath>
+#include <cstdio>
+#include <set>
+
 #define N_PS_POINTS 5
 
 // A mock of ParameterSet to change visibility of the constructor
@@ -48,6 +56,46 @@ public:
     }
 };
 
+/// Parameters of UnitTestsMatrixElement
+class UnitTestsMEParameters: public momemta::MEParameters {
+public:
+    UnitTestsMEParameters() {
+        m_card_parameters["n_states"] = 1;
+    }
+
+    virtual void cacheParameters() override {}
+    virtual void cacheCouplings() override {}
+    virtual void updateParameters() override {}
+    virtual void updateCouplings() override {}
+};
+
+/// Matrix element of `n_states` initial states, the k-th one having a value of k
+class UnitTestsMatrixElement: public momemta::MatrixElement {
+public:
+    UnitTestsMatrixElement(const ParameterSet&): m_parameters(std::make_shared<UnitTestsMEParameters>()) {}
+
+    virtual Result compute(const std::pair<std::vector<double>, std::vector<double>>&,
+                           const std::vector<std::pair<int, std::vector<double>>>&) override {
+        // Not sorted: the first initial state is not the first one of the result
+        static const std::vector<std::pair<int, int>> initial_states = { {2, -2}, {1, -1}, {21, 21} };
+
+        Result result;
+        const size_t n_states = m_parameters->getParameter("n_states");
+        for (size_t k = 0; k < n_states; k++)
+            result[initial_states[k]] = k + 1;
+
+        return result;
+    }
+
+    virtual std::shared_ptr<momemta::MEParameters> getParameters() override {
+        return m_parameters;
+    }
+
+private:
+    std::shared_ptr<UnitTestsMEParameters> m_parameters;
+};
+REGISTER_MATRIX_ELEMENT("UnitTestsMatrixElement", UnitTestsMatrixElement);
+
 std::shared_ptr<std::vector<double>> addPhaseSpacePoints(std::shared_ptr<Pool> pool) {
     pool->current_module("cuba");
 
@@ -685,4 +733,415 @@ TEST_CASE("Modules", "[modules]") {
             REQUIRE(solution.values.at(1).Theta() == Approx(input_particles->at(5).Theta()));
         }
     }
+    SECTION("GaussianTransferFunctionOnEnergy") {
+        // The integral of the TF over the phase-space point must not depend on the sampling mode
+        auto integrate = [&](const std::string& sampling) {
+            pool.reset(new Pool());
+            ps_points = addPhaseSpacePoints(pool);
+            input_particles = addInputParticles(pool);
+
+            parameters.reset(new ParameterSetMock("GaussianTransferFunctionOnEnergy"));
+            parameters->set("ps_point", InputTag("cuba", "ps_points", 0));
+            parameters->set("reco_particle", InputTag("input", "particles", 1));
+            parameters->set("sigma", 0.1);
+            parameters->set("sampling", sampling);
+
+            auto module = createModule("GaussianTransferFunctionOnEnergy");
+            auto TF_times_jacobian = pool->get<double>({"GaussianTransferFunctionOnEnergy", "TF_times_jacobian"});
+            auto output = pool->get<LorentzVector>({"GaussianTransferFunctionOnEnergy", "output"});
+
+            const size_t n_points = 10000;
+            double integral = 0;
+            for (size_t i = 0; i < n_points; i++) {
+                ps_points->operator[](0) = (i + 0.5) / n_points;
+                module->work();
+                integral += *TF_times_jacobian / dP_over_dE(*output);
+            }
+
+            return integral / n_points;
+        };
+
+        double uniform = integrate("uniform");
+        double cdf = integrate("cdf");
+
+        REQUIRE(uniform == Approx(1).epsilon(0.01));
+        REQUIRE(cdf == Approx(uniform).epsilon(1e-3));
+
+        REQUIRE_THROWS_AS(integrate("unknown"), Module::invalid_configuration);
+        // Same spelling as for the binned TFs
+        REQUIRE_THROWS_AS(integrate("inverse_cdf"), Module::invalid_configuration);
+    }
+
+    SECTION("BinnedTransferFunctionOnEnergy") {
+        // Delta in [-50, 50] for E_gen in [0, 150] and [150, 300]. The column of the reconstructed energy (142.5)
+        // is empty except for one bin, while the next column is not: sampling only from the column would miss
+        // part of the TF
+        const std::string path = "unit_tests_binned_tf.bin";
+        std::vector<double> contents(4 * 6);
+        contents[1 + 4 * 2] = 1.;
+        for (size_t j = 1; j <= 4; j++)
+            contents[2 + 4 * j] = 0.25;
+
+        momemta::BinnedTable2D table(momemta::BinnedTable2D::Axis(2, 0., 300.),
+                                     momemta::BinnedTable2D::Axis(4, -50., 50.), contents);
+        momemta::BinnedTable2D::save(path, {{"tf", &table}});
+
+        auto integrate = [&](const std::string& sampling, double uniform_fraction) {
+            pool.reset(new Pool());
+            ps_points = addPhaseSpacePoints(pool);
+            input_particles = addInputParticles(pool);
+
+            parameters.reset(new ParameterSetMock("BinnedTransferFunctionOnEnergy"));
+            parameters->set("ps_point", InputTag("cuba", "ps_points", 0));
+            parameters->set("reco_particle", InputTag("input", "particles", 1));
+            parameters->set("file", path);
+            parameters->set("th2_name", std::string("tf"));
+            parameters->set("sampling", sampling);
+            parameters->set("uniform_fraction", uniform_fraction);
+
+            auto module = createModule("BinnedTransferFunctionOnEnergy");
+            auto TF_times_jacobian = pool->get<double>({"BinnedTransferFunctionOnEnergy", "TF_times_jacobian"});
+            auto output = pool->get<LorentzVector>({"BinnedTransferFunctionOnEnergy", "output"});
+
+            const size_t n_points = 10000;
+            double integral = 0;
+            for (size_t i = 0; i < n_points; i++) {
+                ps_points->operator[](0) = (i + 0.5) / n_points;
+                module->work();
+                REQUIRE(std::isfinite(*TF_times_jacobian));
+                integral += *TF_times_jacobian / dP_over_dE(*output);
+            }
+
+            return integral / n_points;
+        };
+
+        double uniform = integrate("uniform", 0.1);
+        REQUIRE(uniform > 0);
+        REQUIRE(integrate("cdf", 0.1) == Approx(uniform).epsilon(1e-3));
+        REQUIRE(integrate("cdf", 1.) == Approx(uniform).epsilon(1e-3));
+
+        // The uniform part is needed to sample the whole TF
+        REQUIRE_THROWS_AS(integrate("cdf", 0.), Module::invalid_configuration);
+        REQUIRE_THROWS_AS(integrate("cdf", 1.5), Module::invalid_configuration);
+
+        std::remove(path.c_str());
+    }
+
+    SECTION("Permutator") {
+        std::vector<InputTag> inputs;
+        for (size_t i = 0; i < 3; i++)
+            inputs.push_back(InputTag("input", "particles", i));
+
+        parameters.reset(new ParameterSetMock("Permutator"));
+        parameters->set("inputs", inputs);
+
+        SECTION("Sample") {
+            parameters->set("ps_point", InputTag("cuba", "ps_points", 4));
+            auto output = pool->get<std::vector<LorentzVector>>({"Permutator", "output"});
+
+            auto module = createModule("Permutator");
+
+            // Last permutation
+            REQUIRE(module->work() == Module::Status::OK);
+            REQUIRE(output->size() == 3);
+            REQUIRE(output->at(0) == input_particles->at(2));
+            REQUIRE(output->at(1) == input_particles->at(1));
+            REQUIRE(output->at(2) == input_particles->at(0));
+        }
+
+        SECTION("Sum") {
+            parameters->set("mode", std::string("sum"));
+            auto solutions = pool->get<SolutionCollection>({"Permutator", "solutions"});
+
+            auto module = createModule("Permutator");
+
+            for (size_t i = 0; i < 2; i++) {
+                REQUIRE(module->work() == Module::Status::OK);
+                REQUIRE(solutions->size() == 6);
+            }
+
+            std::set<std::vector<double>> permutations;
+            for (const auto& solution: *solutions) {
+                REQUIRE(solution.jacobian == Approx(1. / 6.));
+                REQUIRE(solution.values.size() == 3);
+
+                std::vector<double> energies;
+                for (const auto& p: solution.values)
+                    energies.push_back(p.E());
+                permutations.insert(energies);
+            }
+
+            REQUIRE(permutations.size() == 6);
+        }
+
+        SECTION("Same result in both modes") {
+            // A function of the permutation, averaged over all the permutations
+            auto f = [](const std::vector<LorentzVector>& p) {
+                return p[0].E() + 2 * p[1].E() + 3 * p[2].E();
+            };
+
+            parameters->set("ps_point", InputTag("cuba", "ps_points", 4));
+            auto output = pool->get<std::vector<LorentzVector>>({"Permutator", "output"});
+            auto sample = createModule("Permutator");
+
+            // Each permutation is chosen for the same fraction of the points
+            const size_t n_points = 600;
+            double sampled = 0;
+            for (size_t i = 0; i < n_points; i++) {
+                ps_points->operator[](4) = (i + 0.5) / n_points;
+                REQUIRE(sample->work() == Module::Status::OK);
+                sampled += f(*output);
+            }
+            sampled /= n_points;
+
+            pool.reset(new Pool());
+            addPhaseSpacePoints(pool);
+            addInputParticles(pool);
+
+            parameters->set("mode", std::string("sum"));
+            auto solutions = pool->get<SolutionCollection>({"Permutator", "solutions"});
+            auto sum = createModule("Permutator");
+            REQUIRE(sum->work() == Module::Status::OK);
+
+            double summed = 0;
+            for (const auto& solution: *solutions)
+                summed += solution.jacobian * f({solution.values.begin(), solution.values.end()});
+
+            REQUIRE(sampled == Approx(summed));
+        }
+
+        SECTION("Too many inputs to sum") {
+            std::vector<InputTag> many_inputs;
+            for (size_t i = 0; i < 9; i++)
+                many_inputs.push_back(InputTag("input", "particles", i % 4));
+
+            parameters->set("inputs", many_inputs);
+            parameters->set("mode", std::string("sum"));
+            REQUIRE_THROWS_AS(createModule("Permutator"), Module::invalid_configuration);
+        }
+
+        SECTION("Forbidden assignments") {
+            // Third input never in first position, first input never in second position
+            parameters->set("forbidden", std::vector<int64_t>({1, 3, 2, 1}));
+
+            SECTION("Sample") {
+                parameters->set("ps_point", InputTag("cuba", "ps_points", 4));
+                auto module = createModule("Permutator");
+
+                // Last permutation is (3, 2, 1)
+                REQUIRE(module->work() == Module::Status::NEXT);
+            }
+
+            SECTION("Sum") {
+                parameters->set("mode", std::string("sum"));
+                auto solutions = pool->get<SolutionCollection>({"Permutator", "solutions"});
+                auto module = createModule("Permutator");
+
+                // Remaining permutations: (1, 2, 3), (1, 3, 2) and (2, 3, 1)
+                REQUIRE(module->work() == Module::Status::OK);
+                REQUIRE(solutions->size() == 3);
+                REQUIRE((*solutions)[2].values[0] == input_particles->at(1));
+                REQUIRE((*solutions)[2].values[1] == input_particles->at(2));
+                REQUIRE((*solutions)[2].values[2] == input_particles->at(0));
+                REQUIRE((*solutions)[2].jacobian == Approx(1. / 6.));
+            }
+        }
+
+        SECTION("Many inputs") {
+            std::vector<InputTag> many_inputs;
+            for (size_t i = 0; i < 12; i++)
+                many_inputs.push_back(InputTag("input", "particles", i % 4));
+
+            parameters->set("inputs", many_inputs);
+            parameters->set("ps_point", InputTag("cuba", "ps_points", 2));
+            auto output = pool->get<std::vector<LorentzVector>>({"Permutator", "output"});
+
+            auto module = createModule("Permutator");
+            REQUIRE(module->work() == Module::Status::OK);
+            REQUIRE(output->size() == 12);
+
+            // Permutation of rank 12! / 2 is (7, 1, 2, 3, 4, 5, 6, 8, 9, 10, 11, 12)
+            REQUIRE(output->at(0) == input_particles->at(6 % 4));
+            REQUIRE(output->at(1) == input_particles->at(0));
+            REQUIRE(output->at(7) == input_particles->at(7 % 4));
+            REQUIRE(output->at(11) == input_particles->at(11 % 4));
+        }
+
+        SECTION("Invalid mode") {
+            parameters->set("mode", std::string("unknown"));
+            REQUIRE_THROWS_AS(createModule("Permutator"), Module::invalid_configuration);
+        }
+    }
+
+    SECTION("Nested loopers") {
+        // Two levels of solutions, summing the combined jacobian over all the valid pairs
+        auto run = [&](bool flatten) {
+            pool.reset(new Pool());
+
+            pool->current_module("outer_block");
+            auto outer_solutions = pool->put<SolutionCollection>({"outer_block", "solutions"});
+            outer_solutions->push_back({LorentzVector()}, 2.);
+            outer_solutions->push_back({LorentzVector()}, 100., false);
+            outer_solutions->push_back({LorentzVector()}, 3.);
+
+            pool->current_module("inner_block");
+            auto inner_solutions = pool->put<SolutionCollection>({"inner_block", "solutions"});
+            inner_solutions->push_back({LorentzVector()}, 5.);
+            inner_solutions->push_back({LorentzVector()}, 7.);
+
+            auto create = [&](const std::string& type, const std::string& name) {
+                Configuration::Module module;
+                module.name = name;
+                module.type = type;
+                module.parameters.reset(parameters->clone());
+                pool->current_module(module);
+
+                return ModuleFactory::get().create(type, pool, *parameters);
+            };
+
+            parameters.reset(new ParameterSetMock("summer"));
+            parameters->set("input", InputTag("inner", "combined_jacobian"));
+            auto summer = create("DoubleLooperSummer", "summer");
+
+            PathElements inner_path{true, {"summer"}, {summer}};
+            parameters.reset(new ParameterSetMock("inner"));
+            parameters->set("solutions", InputTag("inner_block", "solutions"));
+            parameters->createMock("path", Path(&inner_path));
+            auto inner = create("Looper", "inner");
+
+            PathElements outer_path{true, {"inner"}, {inner}};
+            parameters.reset(new ParameterSetMock("outer"));
+            parameters->set("solutions", InputTag("outer_block", "solutions"));
+            parameters->set("flatten", flatten);
+            parameters->createMock("path", Path(&outer_path));
+            auto outer = create("Looper", "outer");
+
+            outer->configure();
+            outer->beginPoint();
+            REQUIRE(outer->work() == Module::Status::OK);
+
+            return *pool->get<double>({"summer", "sum"});
+        };
+
+        REQUIRE(run(true) == Approx((2. + 3.) * (5. + 7.)));
+        REQUIRE(run(false) == Approx(run(true)));
+    }
+
+    SECTION("Concurrent looper") {
+        // Sum the jacobians of the solutions, using one or several threads
+        auto run = [&](int64_t threads) {
+            pool.reset(new Pool());
+
+            pool->current_module("block");
+            auto solutions = pool->put<SolutionCollection>({"block", "solutions"});
+            for (size_t i = 1; i <= 10; i++)
+                solutions->push_back({LorentzVector()}, i, i != 4);
+
+            auto create = [&](const std::string& type, const std::string& name) {
+                Configuration::Module module;
+                module.name = name;
+                module.type = type;
+                module.parameters.reset(parameters->clone());
+                pool->current_module(module);
+
+                return ModuleFactory::get().create(type, pool, *parameters);
+            };
+
+            parameters.reset(new ParameterSetMock("summer"));
+            parameters->set("input", InputTag("looper", "jacobian"));
+            auto summer = create("DoubleLooperSummer", "summer");
+
+            PathElements path{true, {"summer"}, {summer}};
+            parameters.reset(new ParameterSetMock("looper"));
+            parameters->set("solutions", InputTag("block", "solutions"));
+            parameters->set("threads", threads);
+            parameters->createMock("path", Path(&path));
+            auto looper = create("Looper", "looper");
+
+            looper->configure();
+            looper->beginIntegration();
+
+            std::vector<double> sums;
+            for (size_t i = 0; i < 2; i++) {
+                looper->beginPoint();
+                REQUIRE(looper->work() == Module::Status::OK);
+                looper->endPoint();
+                sums.push_back(*pool->get<double>({"summer", "sum"}));
+            }
+
+            looper->endIntegration();
+            looper->finish();
+
+            return sums;
+        };
+
+        std::vector<double> expected {51., 51.};
+        REQUIRE(run(1) == expected);
+        REQUIRE(run(3) == expected);
+    }
+
+    SECTION("DoubleVectorLooperSummer") {
+        pool->current_module("input");
+        auto values = pool->put<std::vector<double>>({"input", "values"});
+        *values = {1., 2.};
+
+        parameters.reset(new ParameterSetMock("DoubleVectorLooperSummer"));
+        parameters->set("input", InputTag("input", "values"));
+        parameters->set("size", 2);
+
+        auto module = createModule("DoubleVectorLooperSummer");
+
+        auto sum = pool->get<std::vector<double>>({"DoubleVectorLooperSummer", "sum"});
+        REQUIRE(sum->size() == 2);
+
+        module->beginPoint();
+        REQUIRE(module->work() == Module::Status::OK);
+        *values = {0.5, -1.};
+        REQUIRE(module->work() == Module::Status::OK);
+
+        REQUIRE(sum->at(0) == Approx(1.5));
+        REQUIRE(sum->at(1) == Approx(1.));
+
+        module->beginPoint();
+        REQUIRE(sum->at(0) == Approx(0));
+        REQUIRE(sum->at(1) == Approx(0));
+    }
+
+    SECTION("MatrixElement hypotheses") {
+        pool->current_module("partons");
+        auto partons = pool->put<std::vector<LorentzVector>>({"partons", "partons"});
+        partons->push_back({0, 0, 100, 100});
+        partons->push_back({0, 0, -200, 200});
+
+        ParameterSetMock particles("particles");
+        particles.set("inputs", std::vector<InputTag>({InputTag("input", "particles", 0)}));
+        ParameterSetMock id("id");
+        id.set("pdg_id", 11);
+        id.set("me_index", 1);
+        particles.createMock("ids", std::vector<ParameterSet>({id}));
+
+        // The hypothesis has more initial states than the nominal matrix element
+        ParameterSet hypothesis;
+        hypothesis.set("n_states", 3.);
+
+        parameters.reset(new ParameterSetMock("MatrixElement"));
+        parameters->set("energy", 1000.);
+        parameters->set("use_pdf", false);
+        parameters->set("initialState", InputTag("partons", "partons"));
+        parameters->createMock("particles", static_cast<const ParameterSet&>(particles));
+        parameters->set("matrix_element", std::string("UnitTestsMatrixElement"));
+        parameters->createMock("matrix_element_parameters", static_cast<const ParameterSet&>(ParameterSetMock("me")));
+        parameters->createMock("hypotheses", std::vector<ParameterSet>({hypothesis}));
+
+        auto module = createModule("MatrixElement");
+        auto output = pool->get<double>({"MatrixElement", "output"});
+        auto hypotheses = pool->get<std::vector<double>>({"MatrixElement", "hypotheses"});
+
+        REQUIRE(module->work() == Module::Status::OK);
+        REQUIRE(*output > 0);
+
+        // Every initial state of the hypothesis contributes: 1 + 2 + 3
+        REQUIRE(hypotheses->size() == 1);
+        REQUIRE(hypotheses->front() / *output == Approx(6.));
+    }
 }
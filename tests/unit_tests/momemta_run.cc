@@ -0,0 +1,150 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file
+ * \brief Unit tests for momemta-run, computing the weights of the events of a TTree
+ * \ingroup UnitTests
+ */
+
+#include <catch.hpp>
+
+#include <momemta/Math.h>
+#include <momemta/MoMEMta.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <TFile.h>
+#include <TTree.h>
+
+namespace {
+/// Run momemta-run with \p arguments. \return Its exit code
+int run(const std::string& arguments) {
+    const std::string command = std::string(MOMEMTA_RUN_EXECUTABLE) + " " + arguments + " > /dev/null 2>&1";
+    return std::system(command.c_str());
+}
+}
+
+TEST_CASE("momemta-run", "[momemta-run]") {
+
+    const std::string lua_file = "unit_tests_run.lua";
+    const std::string input_file = "unit_tests_run_input.root";
+    const std::string output_file = "unit_tests_run_output.root";
+
+    std::ofstream(lua_file) << R"(
+local particle = declare_input('particle')
+
+parameters = {
+    factor = 2.,
+}
+
+GaussianTransferFunctionOnEnergyEvaluator.tf = {
+    reco_particle = particle.reco_p4,
+    gen_particle = particle.reco_p4,
+    sigma = 0.1,
+}
+
+DoubleConstant.factor = { value = parameter('factor') }
+
+integrand('tf::TF', 'factor::value')
+)";
+
+    // The second entry has no particle: it can't be integrated
+    const std::vector<std::vector<double>> energies = { {50.}, {}, {100., 1.}, {80.} };
+    {
+        std::unique_ptr<TFile> input(TFile::Open(input_file.c_str(), "RECREATE"));
+        TTree tree("t", "t");
+
+        int n;
+        double e[2];
+        tree.Branch("n", &n, "n/I");
+        tree.Branch("e", e, "e[n]/D");
+        for (const auto& entry: energies) {
+            n = entry.size();
+            std::copy(entry.begin(), entry.end(), e);
+            tree.Fill();
+        }
+
+        tree.Write();
+    }
+
+    const std::string files = lua_file + " " + input_file + " " + output_file;
+    const std::string inputs = "-i particle=0,0,e[0],e[0] ";
+
+    SECTION("Weights") {
+        // Blocks smaller than the tree, so that entries are read while others are integrated
+        REQUIRE(run("-j 2 -b 3 -p factor=3 " + inputs + files) == 0);
+
+        std::unique_ptr<TFile> output(TFile::Open(output_file.c_str()));
+        REQUIRE(output);
+
+        TTree* tree = nullptr;
+        output->GetObject("momemta", tree);
+        REQUIRE(tree);
+        REQUIRE(tree->GetEntries() == static_cast<Long64_t>(energies.size()));
+
+        Long64_t entry;
+        std::vector<double>* weights = nullptr;
+        int status;
+        tree->SetBranchAddress("entry", &entry);
+        tree->SetBranchAddress("weights", &weights);
+        tree->SetBranchAddress("status", &status);
+
+        for (size_t i = 0; i < energies.size(); i++) {
+            tree->GetEntry(i);
+
+            REQUIRE(entry == static_cast<Long64_t>(i));
+            REQUIRE(weights->size() == 2);
+
+            if (energies[i].empty()) {
+                REQUIRE(status == static_cast<int>(MoMEMta::IntegrationStatus::NONE));
+                REQUIRE(weights->at(0) == 0);
+                REQUIRE(weights->at(1) == 0);
+                continue;
+            }
+
+            const double energy = energies[i].front();
+            REQUIRE(status == static_cast<int>(MoMEMta::IntegrationStatus::SUCCESS));
+            REQUIRE(weights->at(0) == Approx(normalPdf(energy, 0.1 * energy, energy)));
+
+            // Value given on the command line, not the one of the configuration
+            REQUIRE(weights->at(1) == Approx(3.));
+        }
+    }
+
+    SECTION("Invalid command line") {
+        // Not a global parameter of the configuration
+        REQUIRE(run("-p unknown=3 " + inputs + files) != 0);
+
+        // Not a number
+        REQUIRE(run("-p factor=3GeV " + inputs + files) != 0);
+
+        // Input not mapped to the tree
+        REQUIRE(run(files) != 0);
+    }
+
+    std::remove(lua_file.c_str());
+    std::remove(input_file.c_str());
+    std::remove(output_file.c_str());
+}
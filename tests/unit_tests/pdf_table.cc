@@ -0,0 +1,69 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Unit tests for the PDF interpolation table
+ * \sa momemta::PDFTable
+ * \ingroup UnitTests
+ */
+
+#include <catch.hpp>
+
+#include <momemta/PDFTable.h>
+
+#include <cmath>
+
+TEST_CASE("PDF interpolation table", "[pdf]") {
+    // PDF-like shape, with a different normalisation for each flavour
+    auto xfx = [](int pdg_id, double x) {
+        return (1 + std::abs(pdg_id)) * std::pow(x, -0.2) * std::pow(1 - x, 3);
+    };
+
+    momemta::PDFTable table({-2, -1, 1, 2, 21}, 1e-7, 0.999, 2000, xfx);
+
+    SECTION("Flavours") {
+        REQUIRE(table.hasFlavour(1));
+        REQUIRE(table.hasFlavour(21));
+        // 0 is an alias for the gluon
+        REQUIRE(table.hasFlavour(0));
+        REQUIRE_FALSE(table.hasFlavour(3));
+        REQUIRE_FALSE(table.hasFlavour(2212));
+    }
+
+    SECTION("Range") {
+        REQUIRE(table.covers(1e-7));
+        REQUIRE(table.covers(0.5));
+        REQUIRE_FALSE(table.covers(1e-8));
+        REQUIRE_FALSE(table.covers(0.9995));
+    }
+
+    SECTION("Interpolation") {
+        for (double x: {1e-7, 1e-5, 0.01, 0.1, 0.33, 0.75, 0.999}) {
+            REQUIRE(table.xfx(2, x) == Approx(xfx(2, x)).epsilon(1e-6));
+            REQUIRE(table.xfx(0, x) == Approx(xfx(21, x)).epsilon(1e-6));
+        }
+
+        REQUIRE(table.validate(xfx) < 1e-6);
+    }
+
+    SECTION("Invalid configuration") {
+        REQUIRE_THROWS_AS(momemta::PDFTable({21}, 1e-7, 1, 100, xfx), std::invalid_argument);
+        REQUIRE_THROWS_AS(momemta::PDFTable({21}, 1e-7, 0.9, 3, xfx), std::invalid_argument);
+    }
+}
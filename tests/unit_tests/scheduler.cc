@@ -0,0 +1,100 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+/**
+ * \file
+ * \brief Unit tests for the scheduler integrating many events on several threads
+ * \sa momemta::Scheduler
+ * \ingroup UnitTests
+ */
+
+#include <catch.hpp>
+
+#include <momemta/ConfigurationReader.h>
+#include <momemta/Logging.h>
+#include <momemta/MoMEMta.h>
+#include <momemta/Scheduler.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+TEST_CASE("Scheduler", "[scheduler]") {
+
+    // Suppress log messages
+    logging::set_level(logging::level::fatal);
+
+    const std::string lua_file = "unit_tests_scheduler.lua";
+    std::ofstream(lua_file) << R"(
+local reco = declare_input('reco')
+
+cuba = {
+    seed = 42,
+    n_start = 2000,
+    max_eval = 10000,
+}
+
+GaussianTransferFunctionOnEnergy.tf = {
+    ps_point = add_dimension(),
+    reco_particle = reco.reco_p4,
+    sigma = 0.1,
+    sigma_range = 3.,
+}
+
+integrand('tf::TF_times_jacobian')
+)";
+
+    ConfigurationReader reader(lua_file);
+    MoMEMta weight(reader.freeze());
+    MoMEMta reference(reader.freeze());
+    std::remove(lua_file.c_str());
+
+    const size_t n_events = 7;
+    std::vector<LorentzVector> p4;
+    for (size_t i = 0; i < n_events; i++)
+        p4.emplace_back(0, 0, 50 + 20 * i, 50 + 20 * i);
+
+    // Results must not depend on how the points are shared between the threads
+    for (size_t threads: {1, 3}) {
+        momemta::Scheduler scheduler(weight, threads, 16);
+        REQUIRE(scheduler.threads() == threads);
+
+        std::vector<double> values(n_events);
+        std::vector<double> errors(n_events);
+        std::vector<MoMEMta::IntegrationStatus> status(n_events, MoMEMta::IntegrationStatus::NONE);
+        scheduler.computeWeights(n_events, p4.data(), nullptr, nullptr, values.data(), errors.data(), status.data());
+
+        for (size_t i = 0; i < n_events; i++) {
+            double value, error;
+            reference.computeWeights(&p4[i], nullptr, LorentzVector(), &value, &error);
+
+            REQUIRE(values[i] == value);
+            REQUIRE(errors[i] == error);
+            REQUIRE(status[i] == reference.getIntegrationStatus());
+        }
+    }
+
+    // Inputs are checked for each event
+    p4[3].SetPxPyPzE(0, 0, 10, 5);
+    momemta::Scheduler scheduler(weight, 2);
+    std::vector<double> values(n_events);
+    REQUIRE_THROWS(scheduler.computeWeights(n_events, p4.data(), nullptr, nullptr, values.data(), values.data()));
+}
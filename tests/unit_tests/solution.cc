@@ -0,0 +1,80 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Unit tests for the solution collection
+ * \sa SolutionCollection
+ * \ingroup UnitTests
+ */
+
+#include <catch.hpp>
+
+#include <momemta/Solution.h>
+
+#include <sstream>
+#include <stdexcept>
+
+TEST_CASE("Solution collection", "[solution]") {
+    SolutionCollection solutions;
+    solutions.reserve(2, 2);
+
+    REQUIRE(solutions.empty());
+    REQUIRE(solutions.capacity() == 2);
+    REQUIRE(solutions.particlesPerSolution() == 2);
+
+    LorentzVector p1(1, 0, 0, 2);
+    LorentzVector p2(0, 1, 0, 3);
+
+    solutions.push_back({p1, p2}, 0.5);
+    solutions.push_back(Solution{{p2, p1}, 2., false});
+
+    REQUIRE(solutions.size() == 2);
+    REQUIRE(solutions[0].values.size() == 2);
+    REQUIRE(solutions[0].values[1] == p2);
+    REQUIRE(solutions[1].values.at(0) == p2);
+    REQUIRE(solutions[0].jacobian == 0.5);
+    REQUIRE(solutions[0].valid);
+    REQUIRE_FALSE(solutions[1].valid);
+
+    REQUIRE_THROWS_AS(solutions.at(2), std::out_of_range);
+    REQUIRE_THROWS_AS(solutions.push_back({p1}, 1.), std::invalid_argument);
+
+    // Exceeding the capacity is allowed
+    solutions.push_back({p1, p1}, 3.);
+    REQUIRE(solutions.size() == 3);
+    REQUIRE(solutions[2].jacobian == 3.);
+    REQUIRE(solutions[0].values[0] == p1);
+
+    size_t count = 0;
+    for (const auto& solution: solutions) {
+        REQUIRE(solution.values.size() == 2);
+        count++;
+    }
+    REQUIRE(count == 3);
+
+    // Clearing keeps the memory
+    solutions.clear();
+    REQUIRE(solutions.empty());
+    REQUIRE(solutions.capacity() >= 3);
+
+    std::stringstream stream;
+    solutions.push_back({p1, p2}, 1.);
+    stream << solutions;
+    REQUIRE_FALSE(stream.str().empty());
+}
@@ -0,0 +1,283 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+/**
+ * \file
+ * \brief Unit tests for the computation of weights using pre-bound input handles
+ * \sa MoMEMta
+ * \ingroup UnitTests
+ */
+
+#include <catch.hpp>
+
+#include "allocations.h"
+
+#include <momemta/ConfigurationReader.h>
+#include <momemta/Logging.h>
+#include <momemta/Math.h>
+#include <momemta/MoMEMta.h>
+#include <momemta/Module.h>
+#include <momemta/ModuleFactory.h>
+#include <momemta/ParameterSet.h>
+#include <momemta/Particle.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+std::unique_ptr<MoMEMta> createInstance() {
+    const std::string lua_file = "unit_tests_handles.lua";
+    std::ofstream(lua_file) << R"(
+local reco = declare_input('reco')
+local gen = declare_input('gen')
+
+GaussianTransferFunctionOnEnergyEvaluator.tf = {
+    reco_particle = reco.reco_p4,
+    gen_particle = gen.reco_p4,
+    sigma = 0.1,
+}
+
+DoubleConstant.constant = { value = 2. }
+
+integrand('tf::TF', 'constant::value')
+)";
+
+    ConfigurationReader reader(lua_file);
+    std::unique_ptr<MoMEMta> weight(new MoMEMta(reader.freeze()));
+    std::remove(lua_file.c_str());
+
+    return weight;
+}
+
+/// Abort the evaluation when the energy of `particle` is above `max_energy`, otherwise produce `value` = 1
+class UnitTestsAbort: public Module {
+    public:
+        UnitTestsAbort(PoolPtr pool, const ParameterSet& parameters): Module(pool, parameters.getModuleName()) {
+            m_particle = get<LorentzVector>(parameters.get<InputTag>("particle"));
+            m_max_energy = parameters.get<double>("max_energy");
+        }
+
+        virtual Status work() override {
+            if (m_particle->E() > m_max_energy)
+                return Status::ABORT;
+
+            *m_value = 1;
+            return Status::OK;
+        }
+
+    private:
+        Value<LorentzVector> m_particle;
+        double m_max_energy;
+
+        std::shared_ptr<double> m_value = produce<double>("value");
+};
+REGISTER_MODULE(UnitTestsAbort);
+}
+
+TEST_CASE("Weights computed from input handles", "[momemta]") {
+
+    // Suppress log messages
+    logging::set_level(logging::level::fatal);
+
+    auto instance = createInstance();
+    MoMEMta& weight = *instance;
+
+    REQUIRE(weight.getNumberOfInputs() == 2);
+    REQUIRE(weight.getNumberOfComponents() == 2);
+    REQUIRE_THROWS(weight.getInputHandle("unknown"));
+
+    auto reco = weight.getInputHandle("reco");
+    auto gen = weight.getInputHandle("gen");
+    REQUIRE(reco != gen);
+
+    LorentzVector p4[2];
+    p4[reco] = LorentzVector(0, 0, 95, 95);
+    p4[gen] = LorentzVector(0, 0, 100, 100);
+
+    const double expected = normalPdf(100, 10, 95);
+
+    double values[2];
+    double errors[2];
+    weight.computeWeights(p4, nullptr, LorentzVector(), values, errors);
+
+    REQUIRE(values[0] == Approx(expected));
+    REQUIRE(values[1] == Approx(2.));
+    REQUIRE(errors[0] == 0);
+
+    // Same weights as with named particles
+    auto weights = weight.computeWeights({ momemta::Particle("gen", p4[gen]), momemta::Particle("reco", p4[reco]) });
+    REQUIRE(weights[0].first == Approx(expected));
+    REQUIRE(weights[1].first == Approx(2.));
+
+    SECTION("No allocation") {
+        n_allocations = 0;
+        count_allocations = true;
+        for (size_t i = 0; i < 100; i++) {
+            p4[reco].SetPxPyPzE(0, 0, 90 + i * 0.1, 90 + i * 0.1);
+            weight.computeWeights(p4, nullptr, LorentzVector(), values, errors);
+        }
+        count_allocations = false;
+
+        REQUIRE(n_allocations == 0);
+    }
+}
+
+TEST_CASE("Bulk evaluation of weights", "[momemta]") {
+
+    // Suppress log messages
+    logging::set_level(logging::level::fatal);
+
+    auto weight = createInstance();
+    auto reco = weight->getInputHandle("reco");
+    auto gen = weight->getInputHandle("gen");
+
+    const size_t n_events = 1000;
+    std::vector<LorentzVector> p4(2 * n_events);
+    std::vector<double> expected(n_events);
+    for (size_t i = 0; i < n_events; i++) {
+        double reco_E = 80 + 0.04 * i;
+        p4[2 * i + reco] = LorentzVector(0, 0, reco_E, reco_E);
+        p4[2 * i + gen] = LorentzVector(0, 0, 100, 100);
+        expected[i] = normalPdf(100, 10, reco_E);
+    }
+
+    for (size_t threads: {1, 4}) {
+        std::vector<double> values(2 * n_events, -1);
+        REQUIRE(weight->computeWeightsBulk(n_events, p4.data(), nullptr, nullptr, values.data(), threads) == 0);
+
+        for (size_t i = 0; i < n_events; i++) {
+            REQUIRE(values[i] == Approx(expected[i]));
+            REQUIRE(values[n_events + i] == Approx(2.));
+        }
+    }
+}
+
+TEST_CASE("Lock-step integration of several events", "[momemta]") {
+
+    // Suppress log messages
+    logging::set_level(logging::level::fatal);
+
+    // A single iteration: the grid is not adapted, so each event sees the same points as when integrated alone
+    const std::string lua_file = "unit_tests_lock_step.lua";
+    std::ofstream(lua_file) << R"(
+local reco = declare_input('reco')
+
+cuba = {
+    seed = 42,
+    n_start = 1000,
+    max_eval = 1000,
+}
+
+GaussianTransferFunctionOnEnergy.tf = {
+    ps_point = add_dimension(),
+    reco_particle = reco.reco_p4,
+    sigma = 0.1,
+    sigma_range = 3.,
+}
+
+UnitTestsAbort.abort = {
+    particle = reco.reco_p4,
+    max_energy = 1000.,
+}
+
+integrand('tf::TF_times_jacobian', 'abort::value')
+)";
+
+    ConfigurationReader reader(lua_file);
+    MoMEMta weight(reader.freeze());
+    std::remove(lua_file.c_str());
+
+    const size_t n_events = 5;
+    std::vector<LorentzVector> p4;
+    for (size_t i = 0; i < n_events; i++)
+        p4.emplace_back(0, 0, 50 + 20 * i, 50 + 20 * i);
+
+    std::vector<double> values(2 * n_events);
+    std::vector<double> errors(2 * n_events);
+    std::vector<MoMEMta::IntegrationStatus> status(n_events);
+
+    SECTION("All the events") {
+        REQUIRE(weight.computeWeightsLockStep(n_events, p4.data(), nullptr, nullptr, values.data(), errors.data(),
+                                              status.data()) == 0);
+        const auto integration_status = weight.getIntegrationStatus();
+
+        for (size_t i = 0; i < n_events; i++) {
+            double value[2], error[2];
+            weight.computeWeights(&p4[i], nullptr, LorentzVector(), value, error);
+
+            REQUIRE(status[i] == integration_status);
+            REQUIRE(values[i] == Approx(value[0]));
+            REQUIRE(errors[i] == Approx(error[0]));
+            REQUIRE(values[n_events + i] == Approx(1.));
+        }
+
+        // Results are written in the given buffers: no more allocation than when integrating a single event
+        double value[2], error[2];
+        n_allocations = 0;
+        count_allocations = true;
+        weight.computeWeights(&p4[0], nullptr, LorentzVector(), value, error);
+        count_allocations = false;
+        const size_t single_event_allocations = n_allocations;
+
+        n_allocations = 0;
+        count_allocations = true;
+        weight.computeWeightsLockStep(n_events, p4.data(), nullptr, nullptr, values.data(), errors.data());
+        count_allocations = false;
+
+        REQUIRE(n_allocations == single_event_allocations);
+    }
+
+    SECTION("Aborted event") {
+        // Only the third event is aborted
+        p4[2].SetPxPyPzE(0, 0, 2000, 2000);
+
+        REQUIRE(weight.computeWeightsLockStep(n_events, p4.data(), nullptr, nullptr, values.data(), errors.data(),
+                                              status.data()) == 1);
+        const auto integration_status = weight.getIntegrationStatus();
+        REQUIRE(integration_status != MoMEMta::IntegrationStatus::ABORTED);
+
+        for (size_t i = 0; i < n_events; i++) {
+            if (i == 2) {
+                REQUIRE(status[i] == MoMEMta::IntegrationStatus::ABORTED);
+                REQUIRE(values[i] == 0);
+                REQUIRE(values[n_events + i] == 0);
+                REQUIRE(errors[i] == 0);
+                continue;
+            }
+
+            double value[2], error[2];
+            weight.computeWeights(&p4[i], nullptr, LorentzVector(), value, error);
+
+            REQUIRE(status[i] == integration_status);
+            REQUIRE(values[i] == Approx(value[0]));
+            REQUIRE(errors[i] == Approx(error[0]));
+        }
+    }
+
+    SECTION("Too many components for cuba") {
+        std::vector<LorentzVector> many(2000, p4[0]);
+        std::vector<double> many_values(4000);
+        REQUIRE_THROWS(weight.computeWeightsLockStep(2000, many.data(), nullptr, nullptr, many_values.data(),
+                                                     many_values.data()));
+    }
+}
@@ -0,0 +1,96 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Convert the TH2s of a ROOT file into the native binary table format
+ *
+ * Usage: `momemta-convert-tf input.root output [name ...]`
+ *
+ * If no name is given, all the TH2s found at the top level of the ROOT file are converted.
+ * The output file can be used in place of the ROOT file in the binned transfer function modules.
+ *
+ * \sa momemta::BinnedTable2D
+ */
+
+#include <momemta/BinnedTable2D.h>
+#include <momemta/Logging.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <TFile.h>
+#include <TH2.h>
+#include <TKey.h>
+#include <TList.h>
+
+using namespace momemta;
+
+int main(int argc, char** argv) {
+
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " input.root output [name ...]" << std::endl;
+        return 1;
+    }
+
+    std::string input = argv[1];
+    std::string output = argv[2];
+    std::vector<std::string> names(argv + 3, argv + argc);
+
+    std::unique_ptr<TFile> file(TFile::Open(input.c_str()));
+    if (!file || !file->IsOpen() || file->IsZombie()) {
+        LOG(fatal) << "Could not open file " << input;
+        return 1;
+    }
+
+    if (names.empty()) {
+        TIter next(file->GetListOfKeys());
+        while (TKey* key = static_cast<TKey*>(next())) {
+            std::unique_ptr<TObject> object(key->ReadObj());
+            if (object && object->InheritsFrom("TH2"))
+                names.push_back(key->GetName());
+        }
+    }
+
+    std::vector<BinnedTable2D> tables;
+    for (const auto& name: names) {
+        std::unique_ptr<TObject> object(file->Get(name.c_str()));
+        if (!object || !object->InheritsFrom("TH2")) {
+            LOG(fatal) << "Could not retrieve object " << name << " deriving from class TH2 in file " << input;
+            return 1;
+        }
+
+        std::unique_ptr<TH2> th2(static_cast<TH2*>(object.release()));
+        th2->SetDirectory(0);
+
+        tables.push_back(toBinnedTable(*th2));
+        LOG(info) << "Converted " << name << " (" << tables.back().xAxis().nBins() << " x "
+                  << tables.back().yAxis().nBins() << " bins)";
+    }
+
+    std::vector<std::pair<std::string, const BinnedTable2D*>> named_tables;
+    for (size_t i = 0; i < names.size(); i++)
+        named_tables.emplace_back(names[i], &tables[i]);
+
+    BinnedTable2D::save(output, named_tables);
+    LOG(info) << names.size() << " table(s) saved in " << output;
+
+    return 0;
+}
@@ -0,0 +1,645 @@
+/*
+ *  MoMEMta: a modular implementation of the Matrix Element Method
+ *  Copyright (C) 2016  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file
+ * \brief Compute the weights of all the events of a TTree
+ *
+ * Usage: `momemta-run [options] config.lua input.root output.root`
+ *
+ * Each input declared in the configuration (see `declare_input`) is mapped to the input tree using `--input`, giving
+ * the four components of its 4-momentum. Components are TTree formulas: plain branch names, array elements or any
+ * expression understood by `TTree::Draw`. For example:
+ *
+ *     momemta-run -c ptetaphie -i electron=el_pt,el_eta,el_phi,el_e -i muon=mu_pt[0],mu_eta[0],mu_phi[0],mu_e[0] \
+ *                 -j 8 tt.lua events.root weights.root
+ *
+ * Events are read by blocks. Each block is integrated on all the threads by a momemta::Scheduler, while the next one
+ * is read from the input tree. Results are written in the order of the input tree to the `momemta` tree of the output
+ * file, with the following branches:
+ *   - `entry` (Long64_t): entry of the event in the input tree
+ *   - `weights`, `weights_err` (vector of double): weights and absolute errors, one entry per integrand component
+ *   - `status` (int): status of the integration, see MoMEMta::IntegrationStatus
+ *   - `time` (double): wall-clock time spent integrating the event, in seconds
+ *
+ * Entries for which a formula has no value, like an element past the end of an array, are not integrated: they are
+ * written with a status of `MoMEMta::IntegrationStatus::NONE` and weights of 0.
+ *
+ * The threads are handled by the scheduler: the configuration must not use the parallelisation of Cuba, `ncores` must
+ * be 0 in the `cuba` table (the default).
+ *
+ * Use `--first` and `--entries` to process a range of the input tree, for instance to split a tree into several jobs.
+ * Jobs sharing a configuration can use `--cache` to only parse it once (see ConfigurationReader::readCached()).
+ *
+ * ### Options
+ *
+ *   | Option | Description |
+ *   |--------|-------------|
+ *   | `-t`, `--tree NAME` | Name of the input tree (default: `t`). |
+ *   | `-i`, `--input NAME=C1,C2,C3,C4` | Formulas giving the four components of input `NAME`. Required for each declared input. |
+ *   | `--type NAME=FORMULA` | Formula giving the type of input `NAME` (default: 0). |
+ *   | `--met C1,C2` | Formulas giving the missing transverse momentum: (px, py), or (pt, phi) if the coordinates are not `pxpypze`. |
+ *   | `-c`, `--coordinates SYSTEM` | Meaning of the components: `pxpypze` (default), `ptetaphie` or `ptetaphim`. |
+ *   | `-p`, `--parameter NAME=VALUE` | Set the value of a global parameter, declared in the `parameters` table of the configuration (see MoMEMta::updateParameters()). |
+ *   | `--cache DIRECTORY` | Cache the frozen configuration in an existing directory, see ConfigurationReader::readCached(). |
+ *   | `-j`, `--threads N` | Number of threads integrating the events (default: number of cores). |
+ *   | `-b`, `--block-size N` | Number of events read and integrated at once (default: 256). |
+ *   | `--first N` | First entry of the input tree to process (default: 0). |
+ *   | `-n`, `--entries N` | Number of entries to process (default: all the remaining entries). |
+ */
+
+#include <momemta/ConfigurationReader.h>
+#include <momemta/Logging.h>
+#include <momemta/MoMEMta.h>
+#include <momemta/ParameterSet.h>
+#include <momemta/Scheduler.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <getopt.h>
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TTreeFormula.h>
+
+namespace {
+
+enum class Coordinates {
+    PxPyPzE,
+    PtEtaPhiE,
+    PtEtaPhiM
+};
+
+/// Events read from the input tree, in the layout expected by momemta::Scheduler
+struct Block {
+    std::vector<Long64_t> entries;
+    std::vector<bool> integrated; ///< For each entry, false if a formula has no value
+    std::vector<LorentzVector> p4;
+    std::vector<int64_t> types;
+    std::vector<LorentzVector> met;
+
+    std::vector<double> values;
+    std::vector<double> errors;
+    std::vector<MoMEMta::IntegrationStatus> status;
+    std::vector<double> times;
+
+    /// \return The number of entries read
+    size_t size() const {
+        return entries.size();
+    }
+
+    /// \return The number of events to integrate
+    size_t events() const {
+        return met.size();
+    }
+};
+
+/// Evaluate the formulas mapping the inputs of the configuration to the input tree
+class Reader {
+public:
+    Reader(TTree* tree, Coordinates coordinates): m_tree(tree), m_coordinates(coordinates) {}
+
+    /// Formulas for the input with the given handle
+    void setInput(size_t handle, const std::vector<std::string>& components, const std::string& type) {
+        if (m_inputs.size() <= handle)
+            m_inputs.resize(handle + 1);
+
+        for (const auto& component: components)
+            m_inputs[handle].components.push_back(formula(component));
+
+        if (!type.empty())
+            m_inputs[handle].type = formula(type);
+    }
+
+    void setMET(const std::vector<std::string>& components) {
+        for (const auto& component: components)
+            m_met.push_back(formula(component));
+    }
+
+    /// Read entries [\p first, \p last[ into \p block. \return The number of entries which can't be integrated
+    size_t read(Long64_t first, Long64_t last, Block& block) {
+        block.entries.clear();
+        block.integrated.clear();
+        block.p4.clear();
+        block.types.clear();
+        block.met.clear();
+
+        size_t skipped = 0;
+        for (Long64_t entry = first; entry < last; entry++) {
+            m_tree->LoadTree(entry);
+            block.entries.push_back(entry);
+
+            const bool integrated = read(block);
+            block.integrated.push_back(integrated);
+            if (!integrated) {
+                LOG(debug) << "Entry " << entry << ": a formula has no value, the entry is not integrated";
+                skipped++;
+            }
+        }
+
+        return skipped;
+    }
+
+private:
+    struct Input {
+        std::vector<TTreeFormula*> components;
+        TTreeFormula* type = nullptr;
+    };
+
+    /// Append the current entry to \p block. \return False, leaving \p block untouched, if a formula has no value
+    bool read(Block& block) {
+        m_p4.clear();
+        m_types.clear();
+
+        double c[4];
+        for (auto& input: m_inputs) {
+            for (size_t i = 0; i < 4; i++) {
+                if (!eval(input.components[i], c[i]))
+                    return false;
+            }
+
+            double type = 0;
+            if (input.type && !eval(input.type, type))
+                return false;
+
+            m_p4.push_back(makeP4(c[0], c[1], c[2], c[3]));
+            m_types.push_back(static_cast<int64_t>(type));
+        }
+
+        LorentzVector met;
+        if (!m_met.empty()) {
+            double px, py;
+            if (!eval(m_met[0], px) || !eval(m_met[1], py))
+                return false;
+
+            if (m_coordinates != Coordinates::PxPyPzE) {
+                const double pt = px;
+                px = pt * std::cos(py);
+                py = pt * std::sin(py);
+            }
+            met.SetPxPyPzE(px, py, 0, std::sqrt(px * px + py * py));
+        }
+
+        block.p4.insert(block.p4.end(), m_p4.begin(), m_p4.end());
+        block.types.insert(block.types.end(), m_types.begin(), m_types.end());
+        block.met.push_back(met);
+
+        return true;
+    }
+
+    TTreeFormula* formula(const std::string& expression) {
+        std::unique_ptr<TTreeFormula> f(new TTreeFormula(expression.c_str(), expression.c_str(), m_tree));
+        if (f->GetNdim() == 0)
+            throw std::invalid_argument("Invalid formula for the input tree: " + expression);
+
+        m_formulas.push_back(std::move(f));
+        return m_formulas.back().get();
+    }
+
+    /// \return False if \p f has no value for the current entry, like an element past the end of an array
+    static bool eval(TTreeFormula* f, double& value) {
+        // Also needed to load the content of arrays
+        if (f->GetNdata() == 0)
+            return false;
+
+        value = f->EvalInstance(0);
+        return true;
+    }
+
+    LorentzVector makeP4(double c1, double c2, double c3, double c4) const {
+        LorentzVector p4;
+        switch (m_coordinates) {
+            case Coordinates::PxPyPzE:
+                p4.SetPxPyPzE(c1, c2, c3, c4);
+                break;
+
+            case Coordinates::PtEtaPhiE:
+                p4.SetPxPyPzE(c1 * std::cos(c3), c1 * std::sin(c3), c1 * std::sinh(c2), c4);
+                break;
+
+            case Coordinates::PtEtaPhiM: {
+                const double px = c1 * std::cos(c3);
+                const double py = c1 * std::sin(c3);
+                const double pz = c1 * std::sinh(c2);
+                p4.SetPxPyPzE(px, py, pz, std::sqrt(px * px + py * py + pz * pz + c4 * c4));
+                break;
+            }
+        }
+
+        return p4;
+    }
+
+    TTree* m_tree;
+    Coordinates m_coordinates;
+    std::vector<std::unique_ptr<TTreeFormula>> m_formulas;
+    std::vector<Input> m_inputs; ///< Indexed by handle
+    std::vector<TTreeFormula*> m_met;
+
+    // Inputs of the current entry
+    std::vector<LorentzVector> m_p4;
+    std::vector<int64_t> m_types;
+};
+
+std::vector<std::string> split(const std::string& str, char separator) {
+    std::vector<std::string> result;
+    size_t start = 0;
+    while (true) {
+        size_t end = str.find(separator, start);
+        result.push_back(str.substr(start, end - start));
+        if (end == std::string::npos)
+            break;
+        start = end + 1;
+    }
+
+    return result;
+}
+
+/// Convert all of \p str using \p convert (std::stod, std::stoll...). \throw std::invalid_argument if it's not possible
+template <typename F> auto toNumber(const std::string& str, F convert) -> decltype(convert(str, nullptr)) {
+    try {
+        size_t end = 0;
+        auto value = convert(str, &end);
+        if (end == str.size())
+            return value;
+    } catch (const std::logic_error&) {
+        // Not a number, or out of range
+    }
+
+    throw std::invalid_argument("'" + str + "' is not a valid number");
+}
+
+/**
+ * \brief Convert the values given on the command line to the type of the global parameters they replace
+ *
+ * \throw std::invalid_argument if a parameter is not declared in the configuration, or if its value can't be
+ *        converted
+ */
+ParameterSet toGlobalParameters(const std::map<std::string, std::string>& values, const ParameterSet& declared) {
+    ParameterSet parameters;
+    for (const auto& value: values) {
+        const std::string& name = value.first;
+        const std::string& str = value.second;
+
+        try {
+            if (!declared.exists(name)) {
+                throw std::invalid_argument("not declared in the `parameters` table of the configuration");
+            } else if (declared.existsAs<int64_t>(name)) {
+                parameters.set(name, static_cast<int64_t>(toNumber(str, [](const std::string& s, size_t* end) {
+                    return std::stoll(s, end);
+                })));
+            } else if (declared.existsAs<bool>(name)) {
+                if (str != "true" && str != "false")
+                    throw std::invalid_argument("expected true or false, got '" + str + "'");
+                parameters.set(name, str == "true");
+            } else if (declared.existsAs<std::string>(name)) {
+                parameters.set(name, str);
+            } else if (declared.existsAs<double>(name)) {
+                parameters.set(name, toNumber(str, [](const std::string& s, size_t* end) {
+                    return std::stod(s, end);
+                }));
+            } else {
+                throw std::invalid_argument("only numbers, booleans and strings can be set from the command line");
+            }
+        } catch (const std::exception& e) {
+            throw std::invalid_argument("Invalid value for global parameter " + name + ": " + e.what());
+        }
+    }
+
+    return parameters;
+}
+
+/// Split `NAME=VALUE`
+std::pair<std::string, std::string> splitAssignment(const std::string& str) {
+    size_t pos = str.find('=');
+    if (pos == std::string::npos || pos == 0)
+        throw std::invalid_argument("Expected NAME=VALUE, got '" + str + "'");
+
+    return std::make_pair(str.substr(0, pos), str.substr(pos + 1));
+}
+
+void usage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] config.lua input.root output.root" << std::endl << std::endl
+              << "Options:" << std::endl
+              << "  -t, --tree NAME                 Name of the input tree (default: t)" << std::endl
+              << "  -i, --input NAME=C1,C2,C3,C4    Formulas giving the 4-momentum of input NAME" << std::endl
+              << "      --type NAME=FORMULA         Formula giving the type of input NAME (default: 0)" << std::endl
+              << "      --met C1,C2                 Formulas giving the missing transverse momentum" << std::endl
+              << "  -c, --coordinates SYSTEM        pxpypze (default), ptetaphie or ptetaphim" << std::endl
+              << "  -p, --parameter NAME=VALUE      Set the value of a global parameter" << std::endl
+              << "      --cache DIRECTORY           Cache the frozen configuration in DIRECTORY" << std::endl
+              << "  -j, --threads N                 Number of threads (default: number of cores)" << std::endl
+              << "  -b, --block-size N              Number of events read and integrated at once (default: 256)" << std::endl
+              << "      --first N                   First entry to process (default: 0)" << std::endl
+              << "  -n, --entries N                 Number of entries to process (default: all)" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+
+    std::string tree_name = "t";
+    std::map<std::string, std::vector<std::string>> inputs;
+    std::map<std::string, std::string> types;
+    std::vector<std::string> met;
+    Coordinates coordinates = Coordinates::PxPyPzE;
+    std::map<std::string, std::string> parameters;
+    std::string cache_directory;
+    size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    size_t block_size = 256;
+    Long64_t first = 0;
+    Long64_t entries = -1;
+
+    enum { OPTION_TYPE = 256, OPTION_MET, OPTION_FIRST, OPTION_CACHE };
+    const struct option options[] = {
+        {"tree", required_argument, nullptr, 't'},
+        {"input", required_argument, nullptr, 'i'},
+        {"type", required_argument, nullptr, OPTION_TYPE},
+        {"met", required_argument, nullptr, OPTION_MET},
+        {"coordinates", required_argument, nullptr, 'c'},
+        {"parameter", required_argument, nullptr, 'p'},
+        {"cache", required_argument, nullptr, OPTION_CACHE},
+        {"threads", required_argument, nullptr, 'j'},
+        {"block-size", required_argument, nullptr, 'b'},
+        {"first", required_argument, nullptr, OPTION_FIRST},
+        {"entries", required_argument, nullptr, 'n'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    try {
+        int option;
+        while ((option = getopt_long(argc, argv, "t:i:c:p:j:b:n:h", options, nullptr)) != -1) {
+            switch (option) {
+                case 't':
+                    tree_name = optarg;
+                    break;
+
+                case 'i': {
+                    auto assignment = splitAssignment(optarg);
+                    auto components = split(assignment.second, ',');
+                    if (components.size() != 4)
+                        throw std::invalid_argument("Four components are needed for input " + assignment.first);
+                    inputs[assignment.first] = components;
+                    break;
+                }
+
+                case OPTION_TYPE: {
+                    auto assignment = splitAssignment(optarg);
+                    types[assignment.first] = assignment.second;
+                    break;
+                }
+
+                case OPTION_MET:
+                    met = split(optarg, ',');
+                    if (met.size() != 2)
+                        throw std::invalid_argument("Two components are needed for the MET");
+                    break;
+
+                case 'c': {
+                    std::string system = optarg;
+                    if (system == "pxpypze")
+                        coordinates = Coordinates::PxPyPzE;
+                    else if (system == "ptetaphie")
+                        coordinates = Coordinates::PtEtaPhiE;
+                    else if (system == "ptetaphim")
+                        coordinates = Coordinates::PtEtaPhiM;
+                    else
+                        throw std::invalid_argument("Unknown coordinate system " + system);
+                    break;
+                }
+
+                case 'p':
+                    parameters.insert(splitAssignment(optarg));
+                    break;
+
+                case OPTION_CACHE:
+                    cache_directory = optarg;
+                    break;
+
+                case 'j':
+                    threads = std::stoul(optarg);
+                    break;
+
+                case 'b':
+                    block_size = std::max<size_t>(std::stoul(optarg), 1);
+                    break;
+
+                case OPTION_FIRST:
+                    first = std::stoll(optarg);
+                    break;
+
+                case 'n':
+                    entries = std::stoll(optarg);
+                    break;
+
+                case 'h':
+                    usage(argv[0]);
+                    return 0;
+
+                default:
+                    usage(argv[0]);
+                    return 1;
+            }
+        }
+    } catch (const std::exception& e) {
+        LOG(fatal) << "Invalid command line: " << e.what();
+        return 1;
+    }
+
+    if (argc - optind != 3) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const std::string configuration_file = argv[optind];
+    const std::string input_file = argv[optind + 1];
+    const std::string output_file = argv[optind + 2];
+
+    try {
+        // Without cache, the reader must outlive the configuration
+        std::unique_ptr<ConfigurationReader> reader;
+        if (cache_directory.empty())
+            reader.reset(new ConfigurationReader(configuration_file));
+
+        Configuration configuration = reader ? reader->freeze() :
+                ConfigurationReader::readCached(configuration_file, ParameterSet(), cache_directory);
+        MoMEMta weight(configuration);
+
+        // Applied to the instance, so that the cached configuration is the same whatever the values
+        if (!parameters.empty())
+            weight.updateParameters(toGlobalParameters(parameters, configuration.getGlobalParameters()));
+
+        std::unique_ptr<TFile> input(TFile::Open(input_file.c_str()));
+        if (!input || !input->IsOpen() || input->IsZombie()) {
+            LOG(fatal) << "Could not open file " << input_file;
+            return 1;
+        }
+
+        TTree* tree = nullptr;
+        input->GetObject(tree_name.c_str(), tree);
+        if (!tree) {
+            LOG(fatal) << "Could not retrieve tree " << tree_name << " from file " << input_file;
+            return 1;
+        }
+
+        // Map the inputs declared in the configuration to the input tree
+        Reader tree_reader(tree, coordinates);
+        for (const auto& name: configuration.getInputs()) {
+            auto it = inputs.find(name);
+            if (it == inputs.end()) {
+                LOG(fatal) << "Input " << name << " is declared in the configuration but not mapped to the input tree. "
+                           << "Use --input " << name << "=C1,C2,C3,C4";
+                return 1;
+            }
+
+            auto type = types.find(name);
+            tree_reader.setInput(weight.getInputHandle(name), it->second, type == types.end() ? "" : type->second);
+            inputs.erase(it);
+        }
+
+        if (!inputs.empty()) {
+            LOG(fatal) << "Input " << inputs.begin()->first << " is not declared in the configuration";
+            return 1;
+        }
+
+        if (!met.empty())
+            tree_reader.setMET(met);
+
+        const Long64_t last = (entries < 0) ? tree->GetEntries() : std::min(first + entries, tree->GetEntries());
+        if (first < 0 || first > last) {
+            LOG(fatal) << "Invalid range of entries: the input tree has " << tree->GetEntries() << " entries";
+            return 1;
+        }
+
+        std::unique_ptr<TFile> output(TFile::Open(output_file.c_str(), "RECREATE"));
+        if (!output || !output->IsOpen() || output->IsZombie()) {
+            LOG(fatal) << "Could not create file " << output_file;
+            return 1;
+        }
+        output->cd();
+
+        Long64_t entry;
+        std::vector<double> weights;
+        std::vector<double> weights_err;
+        int status;
+        double time;
+
+        // Owned by the output file
+        TTree* output_tree = new TTree("momemta", "MoMEMta weights");
+        output_tree->Branch("entry", &entry, "entry/L");
+        output_tree->Branch("weights", &weights);
+        output_tree->Branch("weights_err", &weights_err);
+        output_tree->Branch("status", &status, "status/I");
+        output_tree->Branch("time", &time, "time/D");
+
+        momemta::Scheduler scheduler(weight, threads);
+        const size_t n_components = weight.getNumberOfComponents();
+
+        LOG(info) << "Processing entries " << first << " to " << last << " of tree " << tree_name << " on "
+                  << scheduler.threads() << " thread(s)";
+        auto start = std::chrono::steady_clock::now();
+
+        // While a block is integrated, the next one is read from the input tree
+        Block blocks[2];
+        Block* current = &blocks[0];
+        Block* next = &blocks[1];
+        size_t skipped = tree_reader.read(first, std::min<Long64_t>(first + block_size, last), *current);
+
+        Long64_t processed = 0;
+        while (current->size()) {
+            const size_t n = current->events();
+            current->values.resize(n * n_components);
+            current->errors.resize(n * n_components);
+            current->status.resize(n);
+            current->times.resize(n);
+
+            std::future<void> integration;
+            if (n) {
+                integration = std::async(std::launch::async, [&scheduler, current, n]() {
+                        scheduler.computeWeights(n, current->p4.data(), current->types.data(), current->met.data(),
+                                                 current->values.data(), current->errors.data(),
+                                                 current->status.data(), current->times.data());
+                    });
+            }
+
+            const Long64_t next_first = current->entries.back() + 1;
+            skipped += tree_reader.read(next_first, std::min<Long64_t>(next_first + block_size, last), *next);
+
+            if (integration.valid())
+                integration.get();
+
+            weights.resize(n_components);
+            weights_err.resize(n_components);
+            size_t event = 0;
+            for (size_t i = 0; i < current->size(); i++) {
+                entry = current->entries[i];
+                if (!current->integrated[i]) {
+                    std::fill(weights.begin(), weights.end(), 0.);
+                    std::fill(weights_err.begin(), weights_err.end(), 0.);
+                    status = static_cast<int>(MoMEMta::IntegrationStatus::NONE);
+                    time = 0;
+
+                    output_tree->Fill();
+                    continue;
+                }
+
+                for (size_t c = 0; c < n_components; c++) {
+                    weights[c] = current->values[c * n + event];
+                    weights_err[c] = current->errors[c * n + event];
+                }
+                status = static_cast<int>(current->status[event]);
+                time = current->times[event];
+                event++;
+
+                output_tree->Fill();
+            }
+
+            processed += current->size();
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            LOG(info) << "Processed " << processed << " / " << (last - first) << " events ("
+                      << processed / elapsed << " events/s)";
+
+            std::swap(current, next);
+        }
+
+        if (skipped) {
+            LOG(warning) << skipped << " entries were not integrated because a formula had no value for them, like an "
+                         << "element past the end of an array";
+        }
+
+        output->cd();
+        output_tree->Write();
+        output->Close();
+    } catch (const std::exception& e) {
+        LOG(fatal) << e.what();
+        return 1;
+    }
+
+    return 0;
+}